@@ -0,0 +1,443 @@
+-- vector math on FFI structs with glm's memory layout: vec2/3/4 are packed floats, quat is
+-- x, y, z, w (glm's default storage order, the constructor still takes w first like glm's)
+-- and mat4 is 16 floats in column major order, m[column * 4 + row]. values can be handed to
+-- C++ bindings, component columns and GL uniforms as they are.
+--
+-- operators (a + b, q * v, m * m) return new values. in a compiled loop LuaJIT sinks those
+-- allocations as long as the result doesn't escape the iteration, e.g. when it's stored straight
+-- into a struct field. the methods change self in place and return it, they never allocate and
+-- are the choice for values kept in Lua tables or across frames:
+--
+--     t.position = t.position + t.velocity * dt   -- sunk when t is a struct
+--     position:addScaled(velocity, dt)            -- never allocates
+local ffi = require("ffi")
+
+local sqrt, sin, cos, acos = math.sqrt, math.sin, math.cos, math.acos
+local format = string.format
+local istype, copy = ffi.istype, ffi.copy
+
+local M = {}
+
+-- the renderer bindings declare vec3 and mat4 too, whoever comes first defines them
+local function define(name, cdef, size)
+    if not pcall(ffi.typeof, name) then
+        ffi.cdef(cdef)
+    end
+    if ffi.sizeof(name) ~= size then
+        error(name .. " is " .. ffi.sizeof(name) .. " bytes, glm's is " .. size)
+    end
+    return ffi.typeof(name)
+end
+
+local vec2 = define("vec2", "typedef struct { float x, y; } vec2;", 8)
+local vec3 = define("vec3", "typedef struct { float x, y, z; } vec3;", 12)
+local vec4 = define("vec4", "typedef struct { float x, y, z, w; } vec4;", 16)
+local quatType = define("quat", "typedef struct { float x, y, z, w; } quat;", 16)
+local mat4Type = define("mat4", "typedef struct { float m[16]; } mat4;", 64)
+
+-- metatables double as method tables. they live in the module so a hot reload patches the ones
+-- the ctypes already carry (ffi.metatype can only be set once per type)
+local meta = {
+    vec2 = {},
+    vec3 = {},
+    vec4 = {},
+    quat = {},
+    mat4 = {},
+}
+M.meta = meta
+
+---------------------------------------------------------------------------------------------
+-- vec2
+
+local V2 = meta.vec2
+V2.__index = V2
+
+function V2.__add(a, b) return vec2(a.x + b.x, a.y + b.y) end
+function V2.__sub(a, b) return vec2(a.x - b.x, a.y - b.y) end
+function V2.__unm(a) return vec2(-a.x, -a.y) end
+function V2.__div(a, s) return vec2(a.x / s, a.y / s) end
+function V2.__mul(a, b)
+    if type(a) == "number" then
+        return vec2(a * b.x, a * b.y)
+    elseif type(b) == "number" then
+        return vec2(a.x * b, a.y * b)
+    end
+    return vec2(a.x * b.x, a.y * b.y)
+end
+function V2.__eq(a, b)
+    return istype(vec2, a) and istype(vec2, b) and a.x == b.x and a.y == b.y
+end
+function V2.__tostring(a) return format("vec2(%g, %g)", a.x, a.y) end
+
+function V2.set(a, x, y) a.x, a.y = x, y return a end
+function V2.copy(a, b) a.x, a.y = b.x, b.y return a end
+function V2.clone(a) return vec2(a.x, a.y) end
+function V2.unpack(a) return a.x, a.y end
+function V2.add(a, b) a.x, a.y = a.x + b.x, a.y + b.y return a end
+function V2.sub(a, b) a.x, a.y = a.x - b.x, a.y - b.y return a end
+function V2.mul(a, b) a.x, a.y = a.x * b.x, a.y * b.y return a end
+function V2.scale(a, s) a.x, a.y = a.x * s, a.y * s return a end
+function V2.addScaled(a, b, s) a.x, a.y = a.x + b.x * s, a.y + b.y * s return a end
+function V2.lerp(a, b, t) a.x, a.y = a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t return a end
+function V2.dot(a, b) return a.x * b.x + a.y * b.y end
+function V2.lengthSquared(a) return a.x * a.x + a.y * a.y end
+function V2.length(a) return sqrt(a.x * a.x + a.y * a.y) end
+function V2.distance(a, b)
+    local x, y = a.x - b.x, a.y - b.y
+    return sqrt(x * x + y * y)
+end
+function V2.normalize(a)
+    local length = sqrt(a.x * a.x + a.y * a.y)
+    if length > 0 then
+        a.x, a.y = a.x / length, a.y / length
+    end
+    return a
+end
+
+---------------------------------------------------------------------------------------------
+-- vec3
+
+local V3 = meta.vec3
+V3.__index = V3
+
+function V3.__add(a, b) return vec3(a.x + b.x, a.y + b.y, a.z + b.z) end
+function V3.__sub(a, b) return vec3(a.x - b.x, a.y - b.y, a.z - b.z) end
+function V3.__unm(a) return vec3(-a.x, -a.y, -a.z) end
+function V3.__div(a, s) return vec3(a.x / s, a.y / s, a.z / s) end
+function V3.__mul(a, b)
+    if type(a) == "number" then
+        return vec3(a * b.x, a * b.y, a * b.z)
+    elseif type(b) == "number" then
+        return vec3(a.x * b, a.y * b, a.z * b)
+    end
+    return vec3(a.x * b.x, a.y * b.y, a.z * b.z)
+end
+function V3.__eq(a, b)
+    return istype(vec3, a) and istype(vec3, b) and a.x == b.x and a.y == b.y and a.z == b.z
+end
+function V3.__tostring(a) return format("vec3(%g, %g, %g)", a.x, a.y, a.z) end
+
+function V3.set(a, x, y, z) a.x, a.y, a.z = x, y, z return a end
+function V3.copy(a, b) a.x, a.y, a.z = b.x, b.y, b.z return a end
+function V3.clone(a) return vec3(a.x, a.y, a.z) end
+function V3.unpack(a) return a.x, a.y, a.z end
+function V3.add(a, b) a.x, a.y, a.z = a.x + b.x, a.y + b.y, a.z + b.z return a end
+function V3.sub(a, b) a.x, a.y, a.z = a.x - b.x, a.y - b.y, a.z - b.z return a end
+function V3.mul(a, b) a.x, a.y, a.z = a.x * b.x, a.y * b.y, a.z * b.z return a end
+function V3.scale(a, s) a.x, a.y, a.z = a.x * s, a.y * s, a.z * s return a end
+function V3.addScaled(a, b, s)
+    a.x, a.y, a.z = a.x + b.x * s, a.y + b.y * s, a.z + b.z * s
+    return a
+end
+function V3.lerp(a, b, t)
+    a.x, a.y, a.z = a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t
+    return a
+end
+function V3.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z end
+function V3.lengthSquared(a) return a.x * a.x + a.y * a.y + a.z * a.z end
+function V3.length(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z) end
+function V3.distance(a, b)
+    local x, y, z = a.x - b.x, a.y - b.y, a.z - b.z
+    return sqrt(x * x + y * y + z * z)
+end
+function V3.normalize(a)
+    local length = sqrt(a.x * a.x + a.y * a.y + a.z * a.z)
+    if length > 0 then
+        a.x, a.y, a.z = a.x / length, a.y / length, a.z / length
+    end
+    return a
+end
+function V3.cross(a, b)
+    return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x)
+end
+-- a = b x c, b and c may be a
+function V3.setCross(a, b, c)
+    a.x, a.y, a.z = b.y * c.z - b.z * c.y, b.z * c.x - b.x * c.z, b.x * c.y - b.y * c.x
+    return a
+end
+
+---------------------------------------------------------------------------------------------
+-- vec4
+
+local V4 = meta.vec4
+V4.__index = V4
+
+function V4.__add(a, b) return vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w) end
+function V4.__sub(a, b) return vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w) end
+function V4.__unm(a) return vec4(-a.x, -a.y, -a.z, -a.w) end
+function V4.__div(a, s) return vec4(a.x / s, a.y / s, a.z / s, a.w / s) end
+function V4.__mul(a, b)
+    if type(a) == "number" then
+        return vec4(a * b.x, a * b.y, a * b.z, a * b.w)
+    elseif type(b) == "number" then
+        return vec4(a.x * b, a.y * b, a.z * b, a.w * b)
+    end
+    return vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w)
+end
+function V4.__eq(a, b)
+    return istype(vec4, a) and istype(vec4, b) and a.x == b.x and a.y == b.y and a.z == b.z and a.w == b.w
+end
+function V4.__tostring(a) return format("vec4(%g, %g, %g, %g)", a.x, a.y, a.z, a.w) end
+
+function V4.set(a, x, y, z, w) a.x, a.y, a.z, a.w = x, y, z, w return a end
+function V4.copy(a, b) a.x, a.y, a.z, a.w = b.x, b.y, b.z, b.w return a end
+function V4.clone(a) return vec4(a.x, a.y, a.z, a.w) end
+function V4.unpack(a) return a.x, a.y, a.z, a.w end
+function V4.add(a, b) a.x, a.y, a.z, a.w = a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w return a end
+function V4.sub(a, b) a.x, a.y, a.z, a.w = a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w return a end
+function V4.mul(a, b) a.x, a.y, a.z, a.w = a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w return a end
+function V4.scale(a, s) a.x, a.y, a.z, a.w = a.x * s, a.y * s, a.z * s, a.w * s return a end
+function V4.addScaled(a, b, s)
+    a.x, a.y, a.z, a.w = a.x + b.x * s, a.y + b.y * s, a.z + b.z * s, a.w + b.w * s
+    return a
+end
+function V4.lerp(a, b, t)
+    a.x, a.y = a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t
+    a.z, a.w = a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t
+    return a
+end
+function V4.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end
+function V4.lengthSquared(a) return a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w end
+function V4.length(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w) end
+function V4.normalize(a)
+    local length = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)
+    if length > 0 then
+        a.x, a.y, a.z, a.w = a.x / length, a.y / length, a.z / length, a.w / length
+    end
+    return a
+end
+
+---------------------------------------------------------------------------------------------
+-- quat
+
+local Q = meta.quat
+Q.__index = Q
+
+-- glm's quat(w, x, y, z), no arguments is the identity
+local function quat(w, x, y, z)
+    if not w then
+        return quatType(0, 0, 0, 1)
+    end
+    return quatType(x, y, z, w)
+end
+
+-- a * b applies b first, like glm
+local function quatMultiply(a, b)
+    return a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+           a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+           a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+           a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+end
+
+-- glm's quat * vec3: v + 2 * (w * (q x v) + q x (q x v))
+local function quatRotate(q, v)
+    local qx, qy, qz, qw = q.x, q.y, q.z, q.w
+    local vx, vy, vz = v.x, v.y, v.z
+    local ux, uy, uz = qy * vz - qz * vy, qz * vx - qx * vz, qx * vy - qy * vx
+    local uux, uuy, uuz = qy * uz - qz * uy, qz * ux - qx * uz, qx * uy - qy * ux
+    return vx + 2 * (ux * qw + uux), vy + 2 * (uy * qw + uuy), vz + 2 * (uz * qw + uuz)
+end
+
+function Q.__mul(a, b)
+    if istype(vec3, b) then
+        return vec3(quatRotate(a, b))
+    end
+    return quatType(quatMultiply(a, b))
+end
+function Q.__unm(a) return quatType(-a.x, -a.y, -a.z, -a.w) end
+function Q.__eq(a, b)
+    return istype(quatType, a) and istype(quatType, b) and a.x == b.x and a.y == b.y and a.z == b.z and a.w == b.w
+end
+function Q.__tostring(a) return format("quat(%g, {%g, %g, %g})", a.w, a.x, a.y, a.z) end
+
+function Q.set(a, w, x, y, z) a.x, a.y, a.z, a.w = x, y, z, w return a end
+function Q.copy(a, b) a.x, a.y, a.z, a.w = b.x, b.y, b.z, b.w return a end
+function Q.clone(a) return quatType(a.x, a.y, a.z, a.w) end
+function Q.identity(a) a.x, a.y, a.z, a.w = 0, 0, 0, 1 return a end
+-- angle in radians around a unit length axis, glm's angleAxis
+function Q.setAngleAxis(a, angle, axis)
+    local s = sin(angle * 0.5)
+    a.x, a.y, a.z, a.w = axis.x * s, axis.y * s, axis.z * s, cos(angle * 0.5)
+    return a
+end
+-- a = a * b
+function Q.mul(a, b)
+    a.x, a.y, a.z, a.w = quatMultiply(a, b)
+    return a
+end
+-- a = b * a, applies b after the current rotation
+function Q.premul(a, b)
+    a.x, a.y, a.z, a.w = quatMultiply(b, a)
+    return a
+end
+function Q.conjugate(a) a.x, a.y, a.z = -a.x, -a.y, -a.z return a end
+function Q.dot(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end
+function Q.length(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w) end
+function Q.normalize(a)
+    local length = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)
+    if length > 0 then
+        a.x, a.y, a.z, a.w = a.x / length, a.y / length, a.z / length, a.w / length
+    else
+        a.x, a.y, a.z, a.w = 0, 0, 0, 1
+    end
+    return a
+end
+-- out = a * v, out may be v
+function Q.rotate(a, v, out)
+    out.x, out.y, out.z = quatRotate(a, v)
+    return out
+end
+-- spherical interpolation towards b along the shorter arc, glm's slerp
+function Q.slerp(a, b, t)
+    local bx, by, bz, bw = b.x, b.y, b.z, b.w
+    local cosTheta = a.x * bx + a.y * by + a.z * bz + a.w * bw
+    if cosTheta < 0 then
+        bx, by, bz, bw, cosTheta = -bx, -by, -bz, -bw, -cosTheta
+    end
+    local s0, s1
+    if cosTheta > 1 - 1e-6 then
+        -- sin(angle) goes to zero, lerp is exact enough
+        s0, s1 = 1 - t, t
+    else
+        local angle = acos(cosTheta)
+        local inverse = 1 / sin(angle)
+        s0, s1 = sin((1 - t) * angle) * inverse, sin(t * angle) * inverse
+    end
+    a.x, a.y, a.z, a.w = a.x * s0 + bx * s1, a.y * s0 + by * s1, a.z * s0 + bz * s1, a.w * s0 + bw * s1
+    return a
+end
+
+---------------------------------------------------------------------------------------------
+-- mat4
+
+local M4 = meta.mat4
+M4.__index = M4
+
+-- 16 arguments column by column, no arguments is the identity
+local function mat4(...)
+    if select("#", ...) == 0 then
+        return mat4Type({{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}})
+    end
+    return mat4Type({{...}})
+end
+
+-- o = x * y on the float arrays, o must not be x or y
+local function multiply(o, x, y)
+    for c = 0, 12, 4 do
+        local y0, y1, y2, y3 = y[c], y[c + 1], y[c + 2], y[c + 3]
+        for r = 0, 3 do
+            o[c + r] = x[r] * y0 + x[4 + r] * y1 + x[8 + r] * y2 + x[12 + r] * y3
+        end
+    end
+end
+
+-- in place products go through here so self can be one of the operands
+local scratch = mat4Type()
+
+function M4.__mul(a, b)
+    local m = a.m
+    if istype(vec4, b) then
+        local x, y, z, w = b.x, b.y, b.z, b.w
+        return vec4(m[0] * x + m[4] * y + m[8] * z + m[12] * w, m[1] * x + m[5] * y + m[9] * z + m[13] * w,
+                    m[2] * x + m[6] * y + m[10] * z + m[14] * w, m[3] * x + m[7] * y + m[11] * z + m[15] * w)
+    elseif istype(vec3, b) then
+        return M4.transformPoint(a, b, vec3())
+    end
+    local out = mat4Type()
+    multiply(out.m, m, b.m)
+    return out
+end
+function M4.__tostring(a)
+    local m = a.m
+    return format("mat4(%g, %g, %g, %g | %g, %g, %g, %g | %g, %g, %g, %g | %g, %g, %g, %g)", m[0], m[1], m[2], m[3],
+                  m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15])
+end
+
+function M4.get(a, column, row) return a.m[column * 4 + row] end
+function M4.setElement(a, column, row, value) a.m[column * 4 + row] = value return a end
+function M4.copy(a, b) copy(a, b, 64) return a end
+function M4.clone(a)
+    local out = mat4Type()
+    copy(out, a, 64)
+    return out
+end
+function M4.identity(a)
+    local m = a.m
+    for i = 0, 15 do
+        m[i] = 0
+    end
+    m[0], m[5], m[10], m[15] = 1, 1, 1, 1
+    return a
+end
+-- a = a * b
+function M4.mul(a, b)
+    multiply(scratch.m, a.m, b.m)
+    copy(a, scratch, 64)
+    return a
+end
+-- a = b * c
+function M4.setMul(a, b, c)
+    multiply(scratch.m, b.m, c.m)
+    copy(a, scratch, 64)
+    return a
+end
+function M4.transpose(a)
+    local m = a.m
+    m[1], m[4] = m[4], m[1]
+    m[2], m[8] = m[8], m[2]
+    m[3], m[12] = m[12], m[3]
+    m[6], m[9] = m[9], m[6]
+    m[7], m[13] = m[13], m[7]
+    m[11], m[14] = m[14], m[11]
+    return a
+end
+-- translate(t) * mat4_cast(r) * scale(s), the usual model matrix from a transform
+function M4.compose(a, t, r, s)
+    local m = a.m
+    local x, y, z, w = r.x, r.y, r.z, r.w
+    local xx, yy, zz = x * x, y * y, z * z
+    local xy, xz, yz = x * y, x * z, y * z
+    local wx, wy, wz = w * x, w * y, w * z
+    local sx, sy, sz = s.x, s.y, s.z
+    m[0], m[1], m[2], m[3] = (1 - 2 * (yy + zz)) * sx, 2 * (xy + wz) * sx, 2 * (xz - wy) * sx, 0
+    m[4], m[5], m[6], m[7] = 2 * (xy - wz) * sy, (1 - 2 * (xx + zz)) * sy, 2 * (yz + wx) * sy, 0
+    m[8], m[9], m[10], m[11] = 2 * (xz + wy) * sz, 2 * (yz - wx) * sz, (1 - 2 * (xx + yy)) * sz, 0
+    m[12], m[13], m[14], m[15] = t.x, t.y, t.z, 1
+    return a
+end
+-- out = a * vec4(v, 1) without the divide, out may be v
+function M4.transformPoint(a, v, out)
+    local m = a.m
+    local x, y, z = v.x, v.y, v.z
+    out.x = m[0] * x + m[4] * y + m[8] * z + m[12]
+    out.y = m[1] * x + m[5] * y + m[9] * z + m[13]
+    out.z = m[2] * x + m[6] * y + m[10] * z + m[14]
+    return out
+end
+-- out = a * vec4(v, 0), out may be v
+function M4.transformDirection(a, v, out)
+    local m = a.m
+    local x, y, z = v.x, v.y, v.z
+    out.x = m[0] * x + m[4] * y + m[8] * z
+    out.y = m[1] * x + m[5] * y + m[9] * z
+    out.z = m[2] * x + m[6] * y + m[10] * z
+    return out
+end
+
+---------------------------------------------------------------------------------------------
+
+-- a reload runs this again, the ctypes keep the metatables of the first run and get the new
+-- functions through the patched tables above
+pcall(ffi.metatype, vec2, V2)
+pcall(ffi.metatype, vec3, V3)
+pcall(ffi.metatype, vec4, V4)
+pcall(ffi.metatype, quatType, Q)
+pcall(ffi.metatype, mat4Type, M4)
+
+M.vec2 = vec2
+M.vec3 = vec3
+M.vec4 = vec4
+M.quat = quat
+M.mat4 = mat4
+
+return M
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine {
+namespace Bench {
+
+    struct BenchmarkSettings {
+        uint32_t frames = 0;            // measured frames, 0 disables bench mode
+        uint32_t warmupFrames = 60;     // rendered but not recorded
+        std::string output = "bench";   // writes <output>.csv and <output>.json
+        std::string cameraPath;         // empty uses CameraPath::defaultPath()
+    };
+
+    struct FrameSample {
+        double cpuMs;       // beginFrame to endFrame, covers update, draw submission and swap
+        double gpuMs;       // GL_TIME_ELAPSED of everything between beginFrame and endFrame
+        uint32_t drawCalls;
+        uint64_t triangles;
+        uint64_t heapAllocations;   // between beginFrame and endFrame, 0 without ENGINE_TRACK_ALLOCATIONS
+    };
+
+    struct Percentiles {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    // nearest rank percentiles, sorts `values` in place
+    Percentiles computePercentiles(std::vector<double>& values);
+
+    // records one sample per frame for a fixed number of frames. GPU times come from a ring of
+    // timer queries read back a few frames late, so measuring doesn't stall the pipeline
+    class BenchmarkRecorder {
+    public:
+        explicit BenchmarkRecorder(const BenchmarkSettings& settings);
+        ~BenchmarkRecorder();
+        BenchmarkRecorder(const BenchmarkRecorder&) = delete;
+        BenchmarkRecorder& operator=(const BenchmarkRecorder&) = delete;
+
+        // creates the query objects, needs a current GL context
+        void init();
+
+        bool isWarmup() const { return frame < settings.warmupFrames; }
+        bool isFinished() const { return frame >= settings.warmupFrames + settings.frames; }
+        // progress through the whole run in [0, 1), drives the camera path
+        float progress() const;
+        uint32_t frameIndex() const { return frame; }
+
+        void beginFrame();
+        void countDraw(uint64_t triangles) { drawCalls++; frameTriangles += triangles; }
+        void endFrame();
+
+        // waits for the outstanding queries and releases them, prints the statistics and writes
+        // the CSV and JSON files. returns false when an output file couldn't be written
+        bool finish(int width, int height);
+
+        const std::vector<FrameSample>& getSamples() const { return samples; }
+
+    private:
+        static const uint32_t QUERY_RING = 4;
+
+        BenchmarkSettings settings;
+        std::vector<FrameSample> samples;
+        unsigned int queries[QUERY_RING];
+        int64_t querySample[QUERY_RING];    // sample the query belongs to, -1 when not in flight
+        uint32_t frame;
+        uint64_t frameStart;
+        uint64_t allocationsAtStart;
+        uint32_t drawCalls;
+        uint64_t frameTriangles;
+        bool initialized;
+
+        void collectQuery(uint32_t slot);
+        bool writeCsv(const std::string& path) const;
+        bool writeJson(const std::string& path, int width, int height) const;
+    };
+
+} // namespace Bench
+} // namespace Engine
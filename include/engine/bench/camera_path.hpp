@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace Engine {
+namespace Bench {
+
+    struct CameraKey {
+        glm::vec3 position;
+        float yaw;          // degrees, same convention as Camera
+        float pitch;
+    };
+
+    struct CameraPose {
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    // closed Catmull-Rom spline through camera keys, evaluated by a normalized parameter so the
+    // same path covers any number of benchmark frames
+    class CameraPath {
+    public:
+        // orbit around the default cube scene
+        static CameraPath defaultPath();
+        // one key per line: "x y z yaw pitch", '#' starts a comment. returns false when the
+        // file can't be read or has fewer than two keys
+        bool load(const char* path);
+
+        void addKey(const CameraKey& key) { keys.push_back(key); }
+        size_t keyCount() const { return keys.size(); }
+
+        // t in [0, 1), wraps outside of it
+        CameraPose evaluate(float t) const;
+
+    private:
+        std::vector<CameraKey> keys;
+    };
+
+} // namespace Bench
+} // namespace Engine
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Engine {
+namespace Core {
+
+    const uint64_t NANOSECONDS_PER_SECOND = 1000000000ull;
+
+    // monotonic 64 bit nanosecond clock, unlike a float seconds value it keeps full precision
+    // no matter how long the engine has been running
+    inline uint64_t nowNanoseconds() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    inline double nanosecondsToSeconds(uint64_t nanoseconds) {
+        return (double)nanoseconds / (double)NANOSECONDS_PER_SECOND;
+    }
+
+    inline double nanosecondsToMilliseconds(uint64_t nanoseconds) {
+        return (double)nanoseconds / 1000000.0;
+    }
+
+    inline uint64_t secondsToNanoseconds(double seconds) {
+        return (uint64_t)(seconds * (double)NANOSECONDS_PER_SECOND);
+    }
+
+} // namespace Core
+} // namespace Engine
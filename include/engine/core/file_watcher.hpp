@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine {
+namespace Core {
+
+    // inotify watch over directory trees, reports files that were written or moved into place.
+    // editors that save through a temp file and a rename show up as the final name
+    class FileWatcher {
+    public:
+        FileWatcher() : fd(-1) {}
+        ~FileWatcher() { close(); }
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        bool open();
+        void close();
+
+        // watches directory and every directory below it, directories created later are added
+        // as they appear. returns false when directory can't be watched
+        bool watchTree(const std::string& directory);
+
+        // blocks up to timeoutMs for changes and appends the changed file paths, "<directory>/<name>"
+        // with the directory as passed to watchTree. returns the number of paths appended
+        size_t wait(int timeoutMs, std::vector<std::string>& changed);
+
+    private:
+        int fd;
+        std::unordered_map<int, std::string> directories;     // watch descriptor to path
+    };
+
+} // namespace Core
+} // namespace Engine
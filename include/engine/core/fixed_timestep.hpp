@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Engine {
+namespace Core {
+
+    // accumulates real frame time and hands it out as whole simulation steps of a fixed length,
+    // the leftover fraction of a step becomes the render interpolation factor
+    class FixedTimestep {
+    public:
+        // maxStepsPerFrame bounds how far the simulation tries to catch up after a long frame,
+        // time beyond that is dropped so a slow frame can't snowball into slower ones
+        explicit FixedTimestep(uint64_t stepNanoseconds = 1000000000ull / 60, uint32_t maxStepsPerFrame = 5);
+
+        // feeds the current clock value and returns how many steps to simulate this frame
+        uint32_t advance(uint64_t nowNanoseconds);
+
+        // how far the current time is between the previous and the latest simulated state [0, 1)
+        double alpha() const { return (double)accumulator / (double)step; }
+        float stepSeconds() const { return (float)((double)step / 1000000000.0); }
+        uint64_t stepNanoseconds() const { return step; }
+
+        uint64_t frameNanoseconds() const { return frameDelta; }
+        uint64_t simulationNanoseconds() const { return simulationTime; }
+        uint64_t totalSteps() const { return steps; }
+        // nanoseconds thrown away by the catch-up limit since start
+        uint64_t droppedNanoseconds() const { return dropped; }
+
+    private:
+        uint64_t step;
+        uint32_t maxSteps;
+        uint64_t lastTime;
+        uint64_t accumulator;
+        uint64_t frameDelta;
+        uint64_t simulationTime;
+        uint64_t steps;
+        uint64_t dropped;
+        bool started;
+    };
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+struct GLFWwindow;
+
+namespace Engine {
+namespace Core {
+
+    enum class VsyncMode {
+        On,         // swap interval 1
+        Adaptive,   // swap interval -1, tears instead of stalling when a frame misses vblank
+        Off,        // swap interval 0
+        Count
+    };
+
+    const char* vsyncModeName(VsyncMode mode);
+    // parses "on", "adaptive" or "off", returns false for anything else
+    bool parseVsyncMode(const char* text, VsyncMode& mode);
+
+    // running frame interval statistics (Welford), cheap enough to update every frame
+    struct FrameTimeStats {
+        uint64_t frames = 0;
+        double meanMs = 0.0;
+        double m2 = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+
+        void add(double ms);
+        void reset() { *this = FrameTimeStats(); }
+        double variance() const { return frames > 1 ? m2 / (double)(frames - 1) : 0.0; }
+        double standardDeviation() const;
+    };
+
+    struct FramePacerSettings {
+        VsyncMode vsync = VsyncMode::On;
+        double fpsLimit = 0.0;              // 0 disables the limiter
+        double idleFps = 10.0;              // frame rate while unfocused or iconified
+        bool throttleWhenIdle = true;
+    };
+
+    // owns swap interval, frame limiting and idle throttling for one window
+    class FramePacer {
+    public:
+        FramePacer(GLFWwindow* window, const FramePacerSettings& settings);
+
+        // applies the swap interval for the mode, adaptive falls back to on when the context
+        // lacks swap_control_tear. needs the window's context to be current
+        void setVsync(VsyncMode mode);
+        VsyncMode getVsync() const { return vsync; }
+        void cycleVsync();
+        void setFrameLimit(double fps);
+        double getFrameLimit() const { return settings.fpsLimit; }
+        void setIdleThrottle(bool enabled) { settings.throttleWhenIdle = enabled; }
+        bool getIdleThrottle() const { return settings.throttleWhenIdle; }
+
+        // call after swapping buffers, sleeps then spins until the frame limit interval has
+        // passed and records the frame interval for the active vsync mode
+        void endFrame();
+        // time endFrame would spend waiting for the frame limit if it was called now, 0 when
+        // unlimited, idle or already late. idle frame work (script GC) can fill it instead
+        uint64_t remainingNanoseconds() const;
+        // replaces glfwPollEvents, blocks in glfwWaitEventsTimeout while the window is idle.
+        // returns false when the next frame shouldn't be rendered (iconified window)
+        bool pollEvents();
+
+        bool isIdle() const { return idle; }
+        const FrameTimeStats& stats(VsyncMode mode) const { return modeStats[(int)mode]; }
+        void printStats() const;
+
+    private:
+        GLFWwindow* window;
+        FramePacerSettings settings;
+        VsyncMode vsync;
+        uint64_t frameInterval;             // 0 when unlimited
+        uint64_t lastFrameEnd;
+        bool idle;
+        FrameTimeStats modeStats[(int)VsyncMode::Count];
+
+        void waitUntil(uint64_t deadline);
+    };
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Engine {
+namespace Core {
+
+    // read only memory mapping of a whole file, unmapped when closed or destroyed
+    class MappedFile {
+    public:
+        MappedFile() : bytes(nullptr), byteCount(0) {}
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // returns false when the file can't be opened or mapped, empty files map to size 0
+        bool open(const char* path);
+        void close();
+
+        const char* data() const { return bytes; }
+        size_t size() const { return byteCount; }
+
+    private:
+        const char* bytes;
+        size_t byteCount;
+    };
+
+} // namespace Core
+} // namespace Engine
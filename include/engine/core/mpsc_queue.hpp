@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine {
+namespace Core {
+
+    // bounded lock-free multi producer / single consumer queue, Capacity must be a power of two.
+    // every cell carries a sequence number (Vyukov's bounded queue): producers claim a cell by
+    // moving the tail with a CAS, then publish it by bumping the cell's sequence, so a slow
+    // producer only delays the consumer at its own cell and never blocks other producers
+    template<typename T, size_t Capacity>
+    class MpscQueue {
+        static_assert((Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+    public:
+        MpscQueue() : head(0), tail(0) {
+            for (size_t i = 0; i < Capacity; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // safe from any thread, returns false when the queue is full
+        bool push(const T& value) {
+            size_t position = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position & (Capacity - 1)];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+                if (difference == 0) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // consumer thread only, returns false when empty or the next cell isn't published yet
+        bool pop(T& value) {
+            Cell& cell = cells[head & (Capacity - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if ((intptr_t)sequence - (intptr_t)(head + 1) < 0) {
+                return false;
+            }
+            value = cell.value;
+            cell.sequence.store(head + Capacity, std::memory_order_release);
+            head++;
+            return true;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        alignas(64) size_t head;                // only touched by the consumer
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) Cell cells[Capacity];
+    };
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine {
+namespace Core {
+
+    // bounded lock-free single producer / single consumer ring, Capacity must be a power of two.
+    // head and tail live on separate cache lines so the two sides don't false share
+    template<typename T, size_t Capacity>
+    class SpscRing {
+        static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+    public:
+        SpscRing() : head(0), tail(0) {}
+
+        // returns false when the ring is full
+        bool push(const T& value) {
+            size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            items[currentTail & (Capacity - 1)] = value;
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T& value) {
+            size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = items[currentHead & (Capacity - 1)];
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t size() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) T items[Capacity];
+    };
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "engine/ecs/component.hpp"
+#include "engine/ecs/entity.hpp"
+#include "engine/memory/allocator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+namespace ECS {
+
+    // fixed size block of memory holding `capacity` entities of one archetype, every component
+    // gets its own tightly packed array (SoA) so systems only stream the columns they touch
+    struct Chunk {
+        unsigned char* data;
+        uint32_t count;
+    };
+
+    class Archetype {
+    public:
+        uint32_t id;                             // creation order in its world, never reused
+        ComponentMask mask;
+        std::vector<ComponentId> components;     // sorted by id
+        std::vector<uint32_t> columnOffsets;     // byte offset of each column inside a chunk
+        std::vector<uint32_t> columnSizes;
+        std::vector<Chunk> chunks;
+        uint32_t chunkCapacity;
+        uint32_t entityCount;
+
+        // cached archetype transitions so add/remove of a component skips the lookup
+        std::array<Archetype*, MAX_COMPONENTS> addEdges;
+        std::array<Archetype*, MAX_COMPONENTS> removeEdges;
+
+        Archetype(uint32_t id, const ComponentMask& mask, Memory::Allocator& allocator);
+        ~Archetype();
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
+
+        // returns the column index of a component or -1 if this archetype doesn't have it
+        int columnIndex(ComponentId id) const { return columnLookup[id]; }
+
+        Entity* entities(uint32_t chunk) const { return reinterpret_cast<Entity*>(chunks[chunk].data); }
+        void* column(uint32_t chunk, int column) const { return chunks[chunk].data + columnOffsets[column]; }
+        void* component(uint32_t chunk, uint32_t row, int column) const {
+            return chunks[chunk].data + columnOffsets[column] + (size_t)row * columnSizes[column];
+        }
+
+        // appends an entity and returns its location, component memory is left uninitialized
+        void pushEntity(Entity entity, uint32_t& chunk, uint32_t& row);
+        // swap-removes the row by moving the archetype's last entity into it, returns the moved
+        // entity so the world can patch its record (NULL_ENTITY when nothing moved)
+        Entity removeEntity(uint32_t chunk, uint32_t row);
+
+    private:
+        std::array<int16_t, MAX_COMPONENTS> columnLookup;
+        Memory::Allocator* allocator;
+    };
+
+} // namespace ECS
+} // namespace Engine
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Engine {
+namespace ECS {
+
+    const size_t MAX_COMPONENTS = 128;
+    // archetype chunk size and the alignment of every column inside a chunk
+    const size_t CHUNK_SIZE = 16 * 1024;
+    const size_t COLUMN_ALIGNMENT = 64;
+
+    using ComponentId = uint32_t;
+    using ComponentMask = std::bitset<MAX_COMPONENTS>;
+
+    struct ComponentInfo {
+        size_t size;
+        size_t alignment;
+        const char* name;
+    };
+
+    // registers a component type and returns its id, ids are handed out in registration order.
+    // aborts for components that can't live in a chunk: over-aligned or too big for one entity
+    ComponentId registerComponent(size_t size, size_t alignment, const char* name);
+    const ComponentInfo& getComponentInfo(ComponentId id);
+    size_t getComponentCount();
+
+    // components live in raw chunk memory and get moved around with memcpy when an entity
+    // changes archetype, so they have to be plain data
+    template<typename T>
+    ComponentId componentId() {
+        static_assert(std::is_trivially_copyable<T>::value, "ECS components must be trivially copyable");
+        static_assert(std::is_trivially_destructible<T>::value, "ECS components must be trivially destructible");
+        static_assert(alignof(T) <= COLUMN_ALIGNMENT, "ECS components can't be aligned beyond the chunk columns");
+        static const ComponentId id = registerComponent(sizeof(T), alignof(T), __PRETTY_FUNCTION__);
+        return id;
+    }
+
+    template<typename... Ts>
+    ComponentMask componentMask() {
+        ComponentMask mask;
+        (mask.set(componentId<Ts>()), ...);
+        return mask;
+    }
+
+} // namespace ECS
+} // namespace Engine
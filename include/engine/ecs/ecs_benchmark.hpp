@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Engine {
+namespace ECS {
+
+    // integrates Position += Velocity * dt over `entities` entities through a world query and
+    // over two plain arrays holding the same data. the arrays are the memory bandwidth bound,
+    // chunk iteration should land next to them. checks first that two parallel scheduler
+    // systems iterating fresh component sets get their queries without racing
+    void runIterationBenchmark(uint32_t entities, uint32_t iterations);
+
+} // namespace ECS
+} // namespace Engine
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Engine {
+namespace ECS {
+
+    // generational handle, index points into the world's entity records and the generation
+    // is bumped every time that slot is reused so stale handles can be detected
+    struct Entity {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool isNull() const { return index == UINT32_MAX; }
+        bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Entity& other) const { return !(*this == other); }
+    };
+
+    const Entity NULL_ENTITY = Entity();
+
+} // namespace ECS
+} // namespace Engine
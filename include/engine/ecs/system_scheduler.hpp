@@ -0,0 +1,152 @@
+#pragma once
+
+#include "engine/ecs/world.hpp"
+#include "engine/jobs/job_system.hpp"
+#include "engine/memory/allocator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Engine {
+namespace ECS {
+
+    // handed to a running system, systems may read and write components of existing entities
+    // but structural changes (create/destroy/add/remove) have to happen outside the scheduler
+    struct SystemContext {
+        World& world;
+        Jobs::JobSystem& jobs;
+        float deltaTime;
+        std::vector<ChunkView>& chunks;
+        // per frame scratch memory, reset by the owner of the frame loop (nullptr when not set)
+        Memory::Allocator* frameAllocator;
+        // the system's declared reads | writes, made on the calling thread before any system
+        // runs (nullptr when it declares nothing)
+        Query* query;
+
+        // runs fn(Ts&...) over every matching entity, chunks are spread across the workers
+        template<typename... Ts, typename Fn>
+        void parallelEach(Query& query, Fn&& fn, uint32_t chunksPerJob = 4) {
+            chunks.clear();
+            query.eachChunk([&](const ChunkView& view) { chunks.push_back(view); });
+            std::vector<ChunkView>& views = chunks;
+            jobs.parallelFor((uint32_t)views.size(), chunksPerJob, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t c = begin; c < end; c++) {
+                    Query::eachInChunk<Ts...>(views[c], fn);
+                }
+            });
+        }
+
+        // the world is locked while systems run, so other component sets have to be queried
+        // before SystemScheduler::run or the lookup aborts
+        template<typename... Ts, typename Fn>
+        void parallelEach(Fn&& fn, uint32_t chunksPerJob = 4) {
+            ComponentMask mask = componentMask<Ts...>();
+            Query& resolved = query && query->mask == mask ? *query : world.getQuery(mask);
+            parallelEach<Ts...>(resolved, std::forward<Fn>(fn), chunksPerJob);
+        }
+    };
+
+    using SystemFunction = std::function<void(SystemContext&)>;
+
+    struct SystemDesc {
+        std::string name;
+        ComponentMask reads;
+        ComponentMask writes;
+        // systems touching the GL context or other main thread only state
+        bool mainThread = false;
+        SystemFunction function;
+    };
+
+    // component access declarations for SystemScheduler::addSystem
+    template<typename... Ts>
+    struct Reads {};
+    template<typename... Ts>
+    struct Writes {};
+
+    struct SystemTiming {
+        double startMs;
+        double durationMs;
+        unsigned int thread;
+    };
+
+    struct SchedulerFrameStats {
+        double wallMs;
+        double criticalPathMs;
+        std::vector<uint32_t> criticalPath;     // system indices from first to last
+        std::vector<SystemTiming> systems;      // indexed like the registered systems
+    };
+
+    // runs registered systems every frame, two systems conflict when one writes a component the
+    // other reads or writes, conflicting systems keep their registration order and everything
+    // else runs in parallel on the job system. each system's query over its declared components
+    // is made up front on the calling thread, the world stays locked against new queries and
+    // archetypes while the systems run
+    class SystemScheduler {
+    public:
+        explicit SystemScheduler(Jobs::JobSystem& jobs);
+
+        uint32_t addSystem(const SystemDesc& desc);
+
+        template<typename... ReadTs, typename... WriteTs>
+        uint32_t addSystem(const std::string& name, Reads<ReadTs...>, Writes<WriteTs...>, SystemFunction function, bool mainThread = false) {
+            SystemDesc desc;
+            desc.name = name;
+            desc.reads = componentMask<ReadTs...>();
+            desc.writes = componentMask<WriteTs...>();
+            desc.mainThread = mainThread;
+            desc.function = std::move(function);
+            return addSystem(desc);
+        }
+
+        void run(World& world, float deltaTime);
+        void setFrameAllocator(Memory::Allocator* allocator) { frameAllocator = allocator; }
+
+        const SchedulerFrameStats& lastFrame() const { return stats; }
+        const SystemDesc& system(uint32_t index) const { return nodes[index]->desc; }
+        size_t systemCount() const { return nodes.size(); }
+        // formats the last frame's critical path as "a (0.10ms) -> b (0.32ms)"
+        std::string criticalPathString() const;
+
+    private:
+        struct SystemNode {
+            SystemDesc desc;
+            std::vector<uint32_t> successors;
+            std::vector<uint32_t> predecessors;
+            std::atomic<uint32_t> remaining{0};
+            std::vector<ChunkView> chunks;
+            Query* query = nullptr;
+        };
+
+        Jobs::JobSystem& jobs;
+        std::vector<std::unique_ptr<SystemNode>> nodes;
+        bool graphDirty;
+        World* queryWorld;          // world the node queries were made in
+
+        // per frame state
+        World* frameWorld;
+        float frameDeltaTime;
+        Memory::Allocator* frameAllocator;
+        std::atomic<uint32_t> systemsLeft;
+        std::mutex mainThreadMutex;
+        std::vector<uint32_t> mainThreadReady;
+        std::chrono::steady_clock::time_point frameStart;
+        SchedulerFrameStats stats;
+        std::vector<double> criticalFinish;
+        std::vector<uint32_t> criticalPrevious;
+
+        void buildGraph();
+        void resolveQueries(World& world);
+        void schedule(uint32_t index);
+        void execute(uint32_t index);
+        void computeCriticalPath();
+        static void runJob(void* data, uint32_t begin, uint32_t end);
+    };
+
+} // namespace ECS
+} // namespace Engine
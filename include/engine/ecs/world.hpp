@@ -0,0 +1,228 @@
+#pragma once
+
+#include "engine/ecs/archetype.hpp"
+#include "engine/ecs/component.hpp"
+#include "engine/ecs/entity.hpp"
+
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Engine {
+namespace ECS {
+
+    // view over one chunk handed to chunk level iteration, column pointers are fetched once
+    // per chunk instead of once per entity
+    struct ChunkView {
+        Archetype* archetype;
+        uint32_t chunkIndex;
+        uint32_t count;
+
+        Entity* entities() const { return archetype->entities(chunkIndex); }
+
+        template<typename T>
+        T* get() const {
+            int column = archetype->columnIndex(componentId<T>());
+            return column < 0 ? nullptr : static_cast<T*>(archetype->column(chunkIndex, column));
+        }
+    };
+
+    // cached list of archetypes matching a component mask, the world appends new archetypes
+    // to every existing query when they get created so iterating never searches
+    class Query {
+    public:
+        ComponentMask mask;
+        std::vector<Archetype*> archetypes;
+
+        explicit Query(const ComponentMask& mask) : mask(mask) {}
+
+        size_t entityCount() const {
+            size_t count = 0;
+            for (Archetype* archetype : archetypes) {
+                count += archetype->entityCount;
+            }
+            return count;
+        }
+
+        size_t chunkCount() const {
+            size_t count = 0;
+            for (Archetype* archetype : archetypes) {
+                count += archetype->chunks.size();
+            }
+            return count;
+        }
+
+        template<typename Fn>
+        void eachChunk(Fn&& fn) {
+            for (Archetype* archetype : archetypes) {
+                for (uint32_t c = 0; c < archetype->chunks.size(); c++) {
+                    uint32_t count = archetype->chunks[c].count;
+                    if (count == 0) {
+                        continue;
+                    }
+                    fn(ChunkView{archetype, c, count});
+                }
+            }
+        }
+
+        // calls fn(Ts&...) for every matching entity
+        template<typename... Ts, typename Fn>
+        void each(Fn&& fn) {
+            eachChunk([&](const ChunkView& view) {
+                eachInChunk<Ts...>(view, fn);
+            });
+        }
+
+        template<typename... Ts, typename Fn>
+        static void eachInChunk(const ChunkView& view, Fn& fn) {
+            auto columns = std::make_tuple(view.get<Ts>()...);
+            for (uint32_t i = 0; i < view.count; i++) {
+                fn(std::get<Ts*>(columns)[i]...);
+            }
+        }
+    };
+
+    class World {
+    public:
+        // chunk memory comes from `allocator`, which has to outlive the world
+        explicit World(Memory::Allocator& allocator = Memory::heapAllocator());
+        ~World();
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        Entity create();
+        void destroy(Entity entity);
+        bool isAlive(Entity entity) const {
+            return entity.index < records.size() && records[entity.index].generation == entity.generation;
+        }
+        size_t entityCount() const { return aliveCount; }
+
+        // creates an entity directly inside the archetype of its components, no intermediate moves
+        template<typename... Ts>
+        Entity create(const Ts&... components) {
+            Archetype* archetype = getArchetype(componentMask<Ts...>());
+            Entity entity = allocateEntity();
+            EntityRecord& record = records[entity.index];
+            record.archetype = archetype;
+            archetype->pushEntity(entity, record.chunk, record.row);
+            (writeComponent(record, componentId<Ts>(), &components), ...);
+            return entity;
+        }
+
+        template<typename T>
+        void add(Entity entity, const T& component) {
+            if (!isAlive(entity)) {
+                return;
+            }
+            ComponentId id = componentId<T>();
+            EntityRecord& record = records[entity.index];
+            if (!record.archetype->mask.test(id)) {
+                Archetype* target = record.archetype->addEdges[id];
+                if (!target) {
+                    ComponentMask mask = record.archetype->mask;
+                    mask.set(id);
+                    target = getArchetype(mask);
+                    record.archetype->addEdges[id] = target;
+                    target->removeEdges[id] = record.archetype;
+                }
+                moveEntity(entity, target);
+            }
+            writeComponent(record, id, &component);
+        }
+
+        template<typename T>
+        void remove(Entity entity) {
+            if (!isAlive(entity)) {
+                return;
+            }
+            ComponentId id = componentId<T>();
+            EntityRecord& record = records[entity.index];
+            if (!record.archetype->mask.test(id)) {
+                return;
+            }
+            Archetype* target = record.archetype->removeEdges[id];
+            if (!target) {
+                ComponentMask mask = record.archetype->mask;
+                mask.reset(id);
+                target = getArchetype(mask);
+                record.archetype->removeEdges[id] = target;
+                target->addEdges[id] = record.archetype;
+            }
+            moveEntity(entity, target);
+        }
+
+        template<typename T>
+        T* get(Entity entity) {
+            if (!isAlive(entity)) {
+                return nullptr;
+            }
+            const EntityRecord& record = records[entity.index];
+            int column = record.archetype->columnIndex(componentId<T>());
+            if (column < 0) {
+                return nullptr;
+            }
+            return static_cast<T*>(record.archetype->component(record.chunk, record.row, column));
+        }
+
+        template<typename T>
+        bool has(Entity entity) const {
+            return isAlive(entity) && records[entity.index].archetype->mask.test(componentId<T>());
+        }
+
+        // returns the cached query for a set of components, the pointer stays valid for the
+        // lifetime of the world
+        template<typename... Ts>
+        Query& query() {
+            return getQuery(componentMask<Ts...>());
+        }
+
+        template<typename... Ts, typename Fn>
+        void each(Fn&& fn) {
+            query<Ts...>().template each<Ts...>(std::forward<Fn>(fn));
+        }
+
+        Query& getQuery(const ComponentMask& mask);
+        // while locked, getQuery only hands out queries that already exist and aborts for new
+        // ones, as does creating an archetype. both change containers other threads are reading,
+        // a scheduler locks the world for as long as its systems run
+        void setQueriesLocked(bool locked) { queriesLocked = locked; }
+        bool areQueriesLocked() const { return queriesLocked; }
+        size_t archetypeCount() const { return archetypes.size(); }
+
+    private:
+        struct EntityRecord {
+            Archetype* archetype;
+            uint32_t chunk;
+            uint32_t row;
+            uint32_t generation;
+        };
+
+        std::vector<EntityRecord> records;
+        std::vector<uint32_t> freeIndices;
+        size_t aliveCount;
+
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::unordered_map<ComponentMask, Archetype*> archetypeLookup;
+        std::vector<std::unique_ptr<Query>> queries;
+        std::unordered_map<ComponentMask, Query*> queryLookup;
+
+        Archetype* emptyArchetype;
+        Memory::Allocator& allocator;
+        bool queriesLocked;
+
+        Entity allocateEntity();
+        Archetype* getArchetype(const ComponentMask& mask);
+        void moveEntity(Entity entity, Archetype* target);
+        void removeFromArchetype(EntityRecord& record);
+
+        void writeComponent(const EntityRecord& record, ComponentId id, const void* source) {
+            int column = record.archetype->columnIndex(id);
+            std::memcpy(record.archetype->component(record.chunk, record.row, column), source, record.archetype->columnSizes[column]);
+        }
+    };
+
+} // namespace ECS
+} // namespace Engine
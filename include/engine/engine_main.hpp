@@ -1,6 +1,6 @@
 #pragma once
 
-#include "GL/glew.h"
+#include "engine/renderer/gl.hpp"
 #include "GLFW/glfw3.h"
 
 namespace Engine {
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "engine/core/spsc_ring.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace Engine {
+namespace Input {
+
+    const int KEY_COUNT = 349;             // GLFW_KEY_LAST + 1
+    const int MOUSE_BUTTON_COUNT = 8;      // GLFW_MOUSE_BUTTON_LAST + 1
+
+    enum class EventType : uint8_t {
+        Key,
+        MouseButton,
+        CursorPosition,
+        Scroll,
+        Char
+    };
+
+    // what the GLFW callbacks push, callbacks do no work beyond filling one of these
+    struct Event {
+        uint64_t timestamp;     // Core::nowNanoseconds() when the callback fired
+        EventType type;
+        int code;               // key, mouse button or codepoint
+        int action;             // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+        double x;
+        double y;
+    };
+
+    enum class MouseAxis {
+        X,
+        Y,
+        ScrollX,
+        ScrollY
+    };
+
+    using ActionId = uint32_t;
+    using AxisId = uint32_t;
+
+    // queues GLFW input callbacks into a lock-free ring and folds them into key/button bitsets
+    // and per frame mouse deltas once per frame, gameplay code reads named actions and axes
+    class InputSystem {
+    public:
+        InputSystem();
+
+        // installs the GLFW callbacks and enables raw mouse motion when the platform has it
+        void attach(GLFWwindow* window);
+
+        // drains queued events, call once per frame after polling GLFW events
+        void update();
+
+        ActionId addAction(const std::string& name);
+        void bindKey(ActionId action, int key);
+        void bindMouseButton(ActionId action, int button);
+        // returns UINT32_MAX when there is no action with that name
+        ActionId findAction(const std::string& name) const;
+
+        AxisId addAxis(const std::string& name);
+        // adds +scale while `positiveKey` is down and -scale while `negativeKey` is down
+        void bindKeyAxis(AxisId axis, int positiveKey, int negativeKey, float scale = 1.0f);
+        void bindMouseAxis(AxisId axis, MouseAxis mouseAxis, float scale = 1.0f);
+        AxisId findAxis(const std::string& name) const;
+
+        // pressed and released are latched per event, a tap inside one frame reports both while
+        // isDown stays false
+        bool isDown(ActionId action) const { return actionDown.test(action); }
+        bool wasPressed(ActionId action) const { return actionPressed.test(action); }
+        bool wasReleased(ActionId action) const { return actionReleased.test(action); }
+        float axis(AxisId axis) const { return axes[axis].value; }
+
+        bool isKeyDown(int key) const { return key >= 0 && key < KEY_COUNT && keys.test(key); }
+        bool isMouseButtonDown(int button) const { return button >= 0 && button < MOUSE_BUTTON_COUNT && buttons.test(button); }
+        double mouseDeltaX() const { return deltaX; }
+        double mouseDeltaY() const { return deltaY; }
+        double mouseX() const { return cursorX; }
+        double mouseY() const { return cursorY; }
+
+        // events drained by the last update(), for consumers like UI that need text and ordering
+        const std::vector<Event>& frameEvents() const { return events; }
+        // age of the oldest event drained last update, a rough measure of input latency
+        uint64_t oldestEventAge() const { return oldestAge; }
+        uint64_t droppedEvents() const { return dropped; }
+
+        void push(const Event& event);
+
+    private:
+        static const size_t MAX_ACTIONS = 128;
+        static const size_t QUEUE_CAPACITY = 1024;
+
+        struct Binding {
+            ActionId action;
+            int code;
+            bool mouseButton;
+        };
+        struct Axis {
+            std::string name;
+            float value;
+        };
+        struct AxisBinding {
+            AxisId axis;
+            int positiveKey;
+            int negativeKey;
+            bool mouse;
+            MouseAxis mouseAxis;
+            float scale;
+        };
+
+        Core::SpscRing<Event, QUEUE_CAPACITY> queue;
+        std::vector<Event> events;
+
+        std::bitset<KEY_COUNT> keys;
+        std::bitset<MOUSE_BUTTON_COUNT> buttons;
+        std::bitset<MAX_ACTIONS> actionDown;
+        std::bitset<MAX_ACTIONS> actionPressed;
+        std::bitset<MAX_ACTIONS> actionReleased;
+
+        std::vector<std::string> actionNames;
+        std::vector<Binding> bindings;
+        std::vector<Axis> axes;
+        std::vector<AxisBinding> axisBindings;
+
+        double cursorX, cursorY;
+        double deltaX, deltaY;
+        double scrollX, scrollY;
+        bool haveCursor;
+        uint64_t oldestAge;
+        uint64_t dropped;
+
+        bool isBindingDown(const Binding& binding) const {
+            return binding.mouseButton ? buttons.test(binding.code) : keys.test(binding.code);
+        }
+        // applies one key or button transition and latches the actions it presses or releases
+        void applyButton(int code, bool mouseButton, bool down);
+    };
+
+    // feeds synthetic event sequences through an InputSystem and checks the actions they
+    // produce, prints what went wrong and returns false on a mismatch
+    bool runInputCheck();
+
+} // namespace Input
+} // namespace Engine
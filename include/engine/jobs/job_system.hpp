@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Engine {
+namespace Jobs {
+
+    // number of jobs still in flight for a batch, wait() returns once it drops to zero
+    struct JobCounter {
+        std::atomic<uint32_t> pending{0};
+    };
+
+    // plain function pointer + payload so submitting never allocates, `begin`/`end` carry the
+    // range for parallelFor jobs
+    struct Job {
+        void (*function)(void* data, uint32_t begin, uint32_t end);
+        void* data;
+        uint32_t begin;
+        uint32_t end;
+        JobCounter* counter;
+    };
+
+    class JobSystem {
+    public:
+        // workerCount 0 uses one worker per hardware thread minus the main thread
+        explicit JobSystem(unsigned int workerCount = 0);
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void submit(const Job& job);
+        // runs queued jobs on the calling thread until the counter reaches zero
+        void wait(JobCounter& counter);
+        // pops and runs a single job, returns false when the queue was empty
+        bool tryRunOne();
+
+        unsigned int workerCount() const { return (unsigned int)workers.size(); }
+        // nanoseconds thread `thread` (threadIndex() numbering) has spent running jobs since
+        // startup, sample it twice to get utilization over an interval
+        uint64_t busyNanoseconds(unsigned int thread) const { return busy[thread].load(std::memory_order_relaxed); }
+        // index of the calling thread, 0 for the main thread and 1..workerCount for workers
+        static unsigned int threadIndex();
+
+        // splits [0, count) into ranges of `grain` items and calls fn(begin, end) on the
+        // workers, blocks (while helping) until every range has run
+        template<typename Fn>
+        void parallelFor(uint32_t count, uint32_t grain, Fn&& fn) {
+            if (count == 0) {
+                return;
+            }
+            if (grain == 0) {
+                grain = 1;
+            }
+            if (workers.empty() || count <= grain) {
+                fn(0u, count);
+                return;
+            }
+            using Function = std::remove_reference_t<Fn>;
+            JobCounter counter;
+            auto invoke = [](void* data, uint32_t begin, uint32_t end) {
+                (*static_cast<Function*>(data))(begin, end);
+            };
+            for (uint32_t begin = 0; begin < count; begin += grain) {
+                uint32_t end = begin + grain < count ? begin + grain : count;
+                counter.pending.fetch_add(1, std::memory_order_relaxed);
+                submit(Job{invoke, (void*)&fn, begin, end, &counter});
+            }
+            wait(counter);
+        }
+
+    private:
+        static const uint32_t QUEUE_CAPACITY = 4096;
+
+        std::vector<std::thread> workers;
+        std::vector<Job> queue;          // fixed size ring buffer
+        uint32_t queueHead;
+        uint32_t queueSize;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        bool running;
+        std::unique_ptr<std::atomic<uint64_t>[]> busy;      // one per thread, main thread first
+
+        bool pop(Job& job);
+        void execute(const Job& job);
+        void workerLoop(unsigned int index);
+    };
+
+} // namespace Jobs
+} // namespace Engine
@@ -0,0 +1,568 @@
+#pragma once
+
+#include "lua.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// compile time Lua bindings for engine classes. a binding is declared once with member pointers
+//
+//   LuaBind::ClassBinding<Camera>("Camera")
+//       .field<&Camera::Zoom>("Zoom")
+//       .method<&Camera::ProcessMouseScroll>("ProcessMouseScroll")
+//       .bind(L);
+//
+// and every member gets two thunks stamped out by the templates below, a lua_CFunction reading
+// its arguments from fixed stack slots and a plain C function FFI calls through a function
+// pointer. the member pointer is a template argument so both calls are direct and inline, there
+// is no std::function, no type lookup and no per call dispatch. bind() also emits the FFI cdef
+// for the class, its registered fields at their C++ offsets, so scripts holding a cdata pointer
+// read and write fields with plain loads and stores
+
+namespace Engine {
+namespace LuaBind {
+
+    // value types both sides understand. slots is how many Lua stack values an argument takes
+    // through the C API, FfiArg is the C type crossing the FFI boundary, ctype its cdef spelling
+    template<typename T, typename Enable = void>
+    struct Marshal;
+
+    template<>
+    struct Marshal<bool> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = bool;
+        static const char* ctype() { return "bool"; }
+        static const char* argCtype() { return "bool"; }
+        static bool check(lua_State* L, int index) { return lua_toboolean(L, index) != 0; }
+        static int push(lua_State* L, bool value) { lua_pushboolean(L, value); return 1; }
+        static bool fromFfi(bool value) { return value; }
+        static bool toFfi(bool value) { return value; }
+    };
+
+    template<typename T>
+    struct Marshal<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = T;
+        static const char* ctype() {
+            static const char* const names[2][4] = {
+                {"uint8_t", "uint16_t", "uint32_t", "uint64_t"},
+                {"int8_t", "int16_t", "int32_t", "int64_t"},
+            };
+            return names[std::is_signed<T>::value][sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3];
+        }
+        static const char* argCtype() { return ctype(); }
+        static T check(lua_State* L, int index) { return (T)luaL_checkinteger(L, index); }
+        static int push(lua_State* L, T value) { lua_pushinteger(L, (lua_Integer)value); return 1; }
+        static T fromFfi(T value) { return value; }
+        static T toFfi(T value) { return value; }
+    };
+
+    template<typename T>
+    struct Marshal<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = T;
+        static const char* ctype() { return sizeof(T) == sizeof(float) ? "float" : "double"; }
+        static const char* argCtype() { return ctype(); }
+        static T check(lua_State* L, int index) { return (T)luaL_checknumber(L, index); }
+        static int push(lua_State* L, T value) { lua_pushnumber(L, (lua_Number)value); return 1; }
+        static T fromFfi(T value) { return value; }
+        static T toFfi(T value) { return value; }
+    };
+
+    // plain enums travel as their integer value
+    template<typename T>
+    struct Marshal<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = int32_t;
+        static const char* ctype() { return "int32_t"; }
+        static const char* argCtype() { return "int32_t"; }
+        static T check(lua_State* L, int index) { return (T)luaL_checkinteger(L, index); }
+        static int push(lua_State* L, T value) { lua_pushinteger(L, (lua_Integer)value); return 1; }
+        static T fromFfi(int32_t value) { return (T)value; }
+        static int32_t toFfi(T value) { return (int32_t)value; }
+    };
+
+    // strings are borrowed from Lua for the duration of the call, returning them through FFI
+    // would hand scripts a raw char pointer so that direction isn't supported
+    template<>
+    struct Marshal<const char*> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = const char*;
+        static const char* ctype() { return "const char*"; }
+        static const char* argCtype() { return "const char*"; }
+        static const char* check(lua_State* L, int index) { return luaL_checkstring(L, index); }
+        static int push(lua_State* L, const char* value) { lua_pushstring(L, value); return 1; }
+        static const char* fromFfi(const char* value) { return value; }
+    };
+
+    // copies on every call, a heap allocation once the string outgrows the small string buffer.
+    // only for methods that keep the string, anything that just reads it should take const char*
+    template<>
+    struct Marshal<std::string> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = false;
+        using FfiArg = const char*;
+        static const char* ctype() { return "const char*"; }
+        static const char* argCtype() { return "const char*"; }
+        static std::string check(lua_State* L, int index) {
+            size_t length;
+            const char* string = luaL_checklstring(L, index, &length);
+            return std::string(string, length);
+        }
+        static int push(lua_State* L, const std::string& value) { lua_pushlstring(L, value.data(), value.size()); return 1; }
+        static std::string fromFfi(const char* value) { return std::string(value); }
+    };
+
+    // x, y, z as three numbers through the C API, a vec3 cdata passed by pointer through FFI
+    template<>
+    struct Marshal<glm::vec3> {
+        static constexpr int slots = 3;
+        static constexpr bool returnsByPointer = true;
+        using FfiArg = const glm::vec3*;
+        static const char* ctype() { return "vec3"; }
+        static const char* argCtype() { return "const vec3*"; }
+        static glm::vec3 check(lua_State* L, int index) {
+            return glm::vec3((float)luaL_checknumber(L, index), (float)luaL_checknumber(L, index + 1),
+                             (float)luaL_checknumber(L, index + 2));
+        }
+        static int push(lua_State* L, const glm::vec3& value) {
+            lua_pushnumber(L, value.x);
+            lua_pushnumber(L, value.y);
+            lua_pushnumber(L, value.z);
+            return 3;
+        }
+        static const glm::vec3& fromFfi(const glm::vec3* value) { return *value; }
+    };
+
+    // column major table of 16 numbers through the C API, a mat4 cdata by pointer through FFI
+    template<>
+    struct Marshal<glm::mat4> {
+        static constexpr int slots = 1;
+        static constexpr bool returnsByPointer = true;
+        using FfiArg = const glm::mat4*;
+        static const char* ctype() { return "mat4"; }
+        static const char* argCtype() { return "const mat4*"; }
+        static glm::mat4 check(lua_State* L, int index) {
+            luaL_checktype(L, index, LUA_TTABLE);
+            glm::mat4 value;
+            for (int i = 0; i < 16; i++) {
+                lua_rawgeti(L, index, i + 1);
+                value[i / 4][i % 4] = (float)lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            }
+            return value;
+        }
+        static int push(lua_State* L, const glm::mat4& value) {
+            lua_createtable(L, 16, 0);
+            for (int i = 0; i < 16; i++) {
+                lua_pushnumber(L, value[i / 4][i % 4]);
+                lua_rawseti(L, -2, i + 1);
+            }
+            return 1;
+        }
+        static const glm::mat4& fromFfi(const glm::mat4* value) { return *value; }
+    };
+
+    template<typename T>
+    using Bare = typename std::remove_cv<typename std::remove_reference<T>::type>::type;
+
+    // registry keys for a bound class, [0] holds the C API metatable and [1] the FFI cast function
+    template<typename T>
+    struct ClassKeys {
+        static inline const char keys[2] = {};
+    };
+
+    // C API objects are boxed pointers, the type key makes the self check one compare instead
+    // of the metatable fetch luaL_checkudata does
+    struct Box {
+        const void* type;
+        void* object;
+    };
+
+    template<typename T>
+    void pushObject(lua_State* L, T* object) {
+        Box* box = static_cast<Box*>(lua_newuserdata(L, sizeof(Box)));
+        box->type = ClassKeys<T>::keys;
+        box->object = object;
+        lua_pushlightuserdata(L, (void*)&ClassKeys<T>::keys[0]);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        lua_setmetatable(L, -2);
+    }
+
+    template<typename T>
+    T* checkObject(lua_State* L, int index) {
+        using Class = typename std::remove_const<T>::type;
+        Box* box = lua_type(L, index) == LUA_TUSERDATA ? static_cast<Box*>(lua_touserdata(L, index)) : nullptr;
+        if (!box || box->type != ClassKeys<Class>::keys) {
+            luaL_argerror(L, index, "bound object expected");
+        }
+        return static_cast<T*>(box->object);
+    }
+
+    // pushes object as a cdata pointer of the class' FFI type, false when T isn't bound in L
+    template<typename T>
+    bool pushCData(lua_State* L, T* object) {
+        lua_pushlightuserdata(L, (void*)&ClassKeys<T>::keys[1]);
+        lua_rawget(L, LUA_REGISTRYINDEX);
+        if (!lua_isfunction(L, -1)) {
+            lua_pop(L, 1);
+            return false;
+        }
+        lua_pushlightuserdata(L, object);
+        lua_call(L, 1, 1);
+        return true;
+    }
+
+    // engine.<name> = object as cdata, the way engine objects are handed to scripts
+    template<typename T>
+    bool setEngineField(lua_State* L, const char* name, T* object) {
+        lua_getglobal(L, "engine");
+        if (!lua_istable(L, -1) || !pushCData(L, object)) {
+            lua_pop(L, 1);
+            return false;
+        }
+        lua_setfield(L, -2, name);
+        lua_pop(L, 1);
+        return true;
+    }
+
+    // stack index of argument i when argument k takes slots[k] values, starting at first
+    constexpr int argumentIndex(const int* slots, size_t i, int first) {
+        int index = first;
+        for (size_t k = 0; k < i; k++) {
+            index += slots[k];
+        }
+        return index;
+    }
+
+    template<typename C, typename R, typename... A>
+    struct MethodSignature {
+        using Class = typename std::remove_const<C>::type;
+        using Return = Bare<R>;
+        static constexpr size_t arity = sizeof...(A);
+        static constexpr int SLOTS[] = {Marshal<Bare<A>>::slots..., 0};
+
+        template<auto Method, size_t... I>
+        static int callCapi(lua_State* L, C* self, std::index_sequence<I...>) {
+            if constexpr (std::is_void<R>::value) {
+                (self->*Method)(Marshal<Bare<A>>::check(L, argumentIndex(SLOTS, I, 2))...);
+                return 0;
+            } else {
+                return Marshal<Return>::push(L, (self->*Method)(Marshal<Bare<A>>::check(L, argumentIndex(SLOTS, I, 2))...));
+            }
+        }
+
+        template<auto Method>
+        static int capi(lua_State* L) {
+            return callCapi<Method>(L, checkObject<C>(L, 1), std::index_sequence_for<A...>());
+        }
+
+        template<auto Method>
+        static void ffiVoid(C* self, typename Marshal<Bare<A>>::FfiArg... args) {
+            (self->*Method)(Marshal<Bare<A>>::fromFfi(args)...);
+        }
+
+        template<auto Method>
+        static auto ffiValue(C* self, typename Marshal<Bare<A>>::FfiArg... args) {
+            return Marshal<Return>::toFfi((self->*Method)(Marshal<Bare<A>>::fromFfi(args)...));
+        }
+
+        // aggregates come back through an out pointer, FFI only JIT compiles scalar returns
+        template<auto Method>
+        static void ffiOut(C* self, typename Marshal<Bare<A>>::FfiArg... args, Return* out) {
+            *out = (self->*Method)(Marshal<Bare<A>>::fromFfi(args)...);
+        }
+
+        template<auto Method>
+        static void* ffiPointer() {
+            if constexpr (std::is_void<R>::value) {
+                return reinterpret_cast<void*>(&ffiVoid<Method>);
+            } else if constexpr (Marshal<Return>::returnsByPointer) {
+                return reinterpret_cast<void*>(&ffiOut<Method>);
+            } else {
+                return reinterpret_cast<void*>(&ffiValue<Method>);
+            }
+        }
+
+        static const char* outCtype() {
+            if constexpr (std::is_void<R>::value) {
+                return nullptr;
+            } else if constexpr (Marshal<Return>::returnsByPointer) {
+                return Marshal<Return>::ctype();
+            } else {
+                return nullptr;
+            }
+        }
+
+        // "float (*)(Camera*, int32_t, float)", the out parameter last when there is one
+        static std::string ffiPointerType(const char* className) {
+            const char* out = outCtype();
+            std::string type;
+            if constexpr (std::is_void<R>::value) {
+                type = "void";
+            } else {
+                type = out ? "void" : Marshal<Return>::ctype();
+            }
+            type += " (*)(";
+            if (std::is_const<C>::value) {
+                type += "const ";
+            }
+            type += className;
+            type += "*";
+            const char* args[] = {Marshal<Bare<A>>::argCtype()..., nullptr};
+            for (size_t i = 0; i < arity; i++) {
+                type += ", ";
+                type += args[i];
+            }
+            if (out) {
+                type += ", ";
+                type += out;
+                type += "*";
+            }
+            return type + ")";
+        }
+    };
+
+    template<typename M>
+    struct MethodTraits;
+
+    template<typename C, typename R, typename... A>
+    struct MethodTraits<R (C::*)(A...)> : MethodSignature<C, R, A...> {};
+
+    template<typename C, typename R, typename... A>
+    struct MethodTraits<R (C::*)(A...) const> : MethodSignature<const C, R, A...> {};
+
+    template<typename M>
+    struct FieldTraits;
+
+    template<typename C, typename T>
+    struct FieldTraits<T C::*> {
+        using Class = C;
+        using Type = T;
+
+        template<auto Field>
+        static int get(lua_State* L) {
+            return Marshal<T>::push(L, checkObject<C>(L, 1)->*Field);
+        }
+
+        template<auto Field>
+        static int set(lua_State* L) {
+            checkObject<C>(L, 1)->*Field = Marshal<T>::check(L, 2);
+            return 0;
+        }
+
+        // byte offset of the member, measured on uninitialised storage without constructing a C
+        template<auto Field>
+        static size_t offset() {
+            alignas(C) static unsigned char storage[sizeof(C)];
+            C* object = reinterpret_cast<C*>(storage);
+            return (size_t)(reinterpret_cast<unsigned char*>(&(object->*Field)) - storage);
+        }
+    };
+
+    // registry key of the binder function. one key for every bound class, so each state loads
+    // the binder once no matter how many classes it binds
+    inline const char BINDER_KEY = 0;
+
+    // runs once per state, declares the math types the marshallers use and returns the function
+    // that turns a cdef plus method table into an FFI metatype
+    const char* const FFI_BINDER = R"lua(
+local ffi = require("ffi")
+if not pcall(ffi.typeof, "vec3") then
+    ffi.cdef("typedef struct { float x, y, z; } vec3;")
+end
+if not pcall(ffi.typeof, "mat4") then
+    ffi.cdef("typedef struct { float m[16]; } mat4;")
+end
+
+-- fixed arity so the out argument lands after the real ones, `...` can't be followed by more
+local function outWrapper(fn, outType, arity)
+    local names = {}
+    for i = 1, arity do
+        names[i] = "a" .. i
+    end
+    local list = arity > 0 and ", " .. table.concat(names, ", ") or ""
+    local source = "local fn, T = ... return function(self" .. list .. ") " ..
+        "local out = T() fn(self" .. list .. ", out) return out end"
+    return loadstring(source)(fn, outType)
+end
+
+return function(name, cdef, size, methods)
+    ffi.cdef(cdef)
+    if ffi.sizeof(name) ~= size then
+        error(name .. " is " .. ffi.sizeof(name) .. " bytes in Lua but " .. size .. " bytes in C++")
+    end
+    local index = {}
+    for method, binding in pairs(methods) do
+        local fn = ffi.cast(binding.ctype, binding.pointer)
+        index[method] = binding.out and outWrapper(fn, ffi.typeof(binding.out), binding.arity) or fn
+    end
+    ffi.metatype(name, { __index = index })
+    local pointerType = ffi.typeof("$*", ffi.typeof(name))
+    return function(pointer)
+        return ffi.cast(pointerType, pointer)
+    end
+end
+)lua";
+
+    // builder for one class, see the top of the file. fields become getter/setter pairs on the C
+    // API side (obj:Zoom(), obj:setZoom(v)) and struct members on the FFI side (obj.Zoom)
+    template<typename T>
+    class ClassBinding {
+    public:
+        explicit ClassBinding(const char* name) : className(name) {}
+
+        template<auto Field>
+        ClassBinding& field(const char* name) {
+            using Traits = FieldTraits<decltype(Field)>;
+            static_assert(std::is_same<typename Traits::Class, T>::value, "field of another class");
+            static_assert(std::is_standard_layout<T>::value, "FFI field access needs a standard layout class");
+            fields.push_back(FieldEntry{name, Marshal<typename Traits::Type>::ctype(), Traits::template offset<Field>(),
+                                        sizeof(typename Traits::Type), &Traits::template get<Field>,
+                                        &Traits::template set<Field>});
+            return *this;
+        }
+
+        template<auto Method>
+        ClassBinding& method(const char* name) {
+            using Traits = MethodTraits<decltype(Method)>;
+            static_assert(std::is_same<typename Traits::Class, T>::value, "method of another class");
+            methods.push_back(MethodEntry{name, &Traits::template capi<Method>, Traits::template ffiPointer<Method>(),
+                                          Traits::ffiPointerType(className.c_str()), Traits::outCtype(),
+                                          (uint32_t)Traits::arity});
+            return *this;
+        }
+
+        // "typedef struct Camera { ... } Camera;" with padding wherever no field is registered
+        std::string cdef() const {
+            std::vector<const FieldEntry*> ordered;
+            for (const FieldEntry& entry : fields) {
+                ordered.push_back(&entry);
+            }
+            for (size_t i = 1; i < ordered.size(); i++) {
+                for (size_t k = i; k > 0 && ordered[k]->offset < ordered[k - 1]->offset; k--) {
+                    std::swap(ordered[k], ordered[k - 1]);
+                }
+            }
+            std::string text = "typedef struct " + className + " { ";
+            size_t cursor = 0;
+            uint32_t paddings = 0;
+            for (const FieldEntry* entry : ordered) {
+                if (entry->offset > cursor) {
+                    text += "uint8_t _pad" + std::to_string(paddings++) + "[" + std::to_string(entry->offset - cursor) + "]; ";
+                }
+                text += entry->ctype + " " + entry->name + "; ";
+                cursor = entry->offset + entry->size;
+            }
+            if (sizeof(T) > cursor) {
+                text += "uint8_t _pad" + std::to_string(paddings) + "[" + std::to_string(sizeof(T) - cursor) + "]; ";
+            }
+            return text + "} " + className + ";";
+        }
+
+        // installs the C API metatable and the FFI metatype, prints the error and returns false
+        // when the FFI side rejects the declaration
+        bool bind(lua_State* L) {
+            lua_pushlightuserdata(L, (void*)&ClassKeys<T>::keys[0]);
+            lua_newtable(L);
+            lua_newtable(L);
+            for (const MethodEntry& entry : methods) {
+                lua_pushcfunction(L, entry.capi);
+                lua_setfield(L, -2, entry.name.c_str());
+            }
+            for (const FieldEntry& entry : fields) {
+                std::string setter = "set" + entry.name;
+                lua_pushcfunction(L, entry.get);
+                lua_setfield(L, -2, entry.name.c_str());
+                lua_pushcfunction(L, entry.set);
+                lua_setfield(L, -2, setter.c_str());
+            }
+            lua_setfield(L, -2, "__index");
+            lua_pushstring(L, className.c_str());
+            lua_setfield(L, -2, "__name");
+            lua_rawset(L, LUA_REGISTRYINDEX);
+
+            lua_pushlightuserdata(L, (void*)&BINDER_KEY);
+            lua_rawget(L, LUA_REGISTRYINDEX);
+            if (lua_isnil(L, -1)) {
+                lua_pop(L, 1);
+                if (luaL_loadbuffer(L, FFI_BINDER, strlen(FFI_BINDER), "=lua binder") != 0 ||
+                    lua_pcall(L, 0, 1, 0) != 0) {
+                    fprintf(stderr, "lua binding %s: %s\n", className.c_str(), lua_tostring(L, -1));
+                    lua_pop(L, 1);
+                    return false;
+                }
+                lua_pushlightuserdata(L, (void*)&BINDER_KEY);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, LUA_REGISTRYINDEX);
+            }
+
+            std::string declaration = cdef();
+            lua_pushstring(L, className.c_str());
+            lua_pushstring(L, declaration.c_str());
+            lua_pushinteger(L, (lua_Integer)sizeof(T));
+            lua_newtable(L);
+            for (const MethodEntry& entry : methods) {
+                lua_newtable(L);
+                lua_pushlightuserdata(L, entry.ffi);
+                lua_setfield(L, -2, "pointer");
+                lua_pushstring(L, entry.ffiType.c_str());
+                lua_setfield(L, -2, "ctype");
+                if (entry.outCtype) {
+                    lua_pushstring(L, entry.outCtype);
+                    lua_setfield(L, -2, "out");
+                }
+                lua_pushinteger(L, entry.arity);
+                lua_setfield(L, -2, "arity");
+                lua_setfield(L, -2, entry.name.c_str());
+            }
+            if (lua_pcall(L, 4, 1, 0) != 0) {
+                fprintf(stderr, "lua binding %s: %s\n", className.c_str(), lua_tostring(L, -1));
+                lua_pop(L, 1);
+                return false;
+            }
+            lua_pushlightuserdata(L, (void*)&ClassKeys<T>::keys[1]);
+            lua_insert(L, -2);
+            lua_rawset(L, LUA_REGISTRYINDEX);
+            return true;
+        }
+
+    private:
+        struct FieldEntry {
+            std::string name;
+            std::string ctype;
+            size_t offset;
+            size_t size;
+            lua_CFunction get;
+            lua_CFunction set;
+        };
+
+        struct MethodEntry {
+            std::string name;
+            lua_CFunction capi;
+            void* ffi;
+            std::string ffiType;
+            const char* outCtype;
+            uint32_t arity;
+        };
+
+        std::string className;
+        std::vector<FieldEntry> fields;
+        std::vector<MethodEntry> methods;
+    };
+
+} // namespace LuaBind
+} // namespace Engine
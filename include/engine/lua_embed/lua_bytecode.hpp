@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct lua_State;
+
+// cooked scripts: LuaJIT bytecode produced with string.dump behind a small header that records
+// the hash of the source it came from. tools/lua_cook writes them, the engine maps them and
+// hands the bytecode straight to luaL_loadbuffer, falling back to the source when the hash
+// no longer matches
+
+namespace Engine {
+
+    const char LUA_BYTECODE_MAGIC[4] = {'L', 'B', 'C', 'K'};
+    const uint32_t LUA_BYTECODE_VERSION = 1;
+    const char* const LUA_COOKED_EXTENSION = ".ljbc";
+
+    const uint32_t LUA_BYTECODE_STRIPPED = 1u << 0;
+
+    struct LuaBytecodeHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t flags;             // LUA_BYTECODE_* cook options, a change recooks the script
+        uint32_t reserved;
+        uint64_t sourceHash;
+        uint64_t bytecodeBytes;     // bytecode follows the header directly
+    };
+
+    // 64 bit FNV-1a, only has to notice edits, not resist anyone
+    uint64_t luaSourceHash(const void* data, size_t size);
+
+    // "<cookedRoot>/<relativePath>.ljbc"
+    std::string luaCookedPath(const std::string& cookedRoot, const std::string& relativePath);
+
+    // bytecode inside a cooked file if it was cooked from exactly `source`, nullptr when the
+    // file is stale, truncated or not a cooked script
+    const char* luaCookedBytecode(const char* cooked, size_t cookedBytes, const void* source, size_t sourceBytes,
+                                  size_t& bytecodeBytes);
+
+    enum class LuaCookResult {
+        Cooked,
+        UpToDate,
+        Failed
+    };
+
+    // compiles sourcePath with L and writes the cooked file, skipped when the existing one
+    // already matches the source hash and options. strip drops debug info (line numbers,
+    // local names)
+    LuaCookResult cookLuaScript(lua_State* L, const char* sourcePath, const char* cookedPath, bool strip);
+
+    struct LuaCookStats {
+        uint32_t cooked;
+        uint32_t upToDate;
+        uint32_t failed;
+    };
+
+    // cooks every .lua file below sourceRoot into the same relative path below cookedRoot
+    LuaCookStats cookLuaDirectory(lua_State* L, const std::string& sourceRoot, const std::string& cookedRoot, bool strip);
+
+} // namespace Engine
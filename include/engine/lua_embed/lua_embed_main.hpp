@@ -1,9 +1,158 @@
 #pragma once
 
-#include "Lua/lua.hpp"
+#include "engine/ecs/component.hpp"
+#include "engine/ecs/entity.hpp"
 
-namespace Engine {
-  class LuaJIT {
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
 
-  }
+namespace Engine {
+namespace ECS {
+    class World;
+    class Query;
 }
+
+    const uint32_t LUA_MAX_QUERY_COLUMNS = 8;
+
+    // one chunk as scripts see it, mirrored by the EngineChunk cdef in the prelude. columns
+    // follow the component order the query was created with and point straight into chunk memory
+    struct LuaChunk {
+        uint32_t count;
+        uint32_t columnCount;
+        ECS::Entity* entities;
+        void* columns[LUA_MAX_QUERY_COLUMNS];
+    };
+
+    class LuaJIT;
+
+    // function table handed to the prelude as a lightuserdata, scripts call through these
+    // pointers with FFI so there is no lua_CFunction or stack traffic on the way in
+    struct LuaEngineApi {
+        LuaJIT* self;
+        int32_t (*createQuery)(LuaJIT* self, const char* const* names, int32_t count);
+        uint32_t (*fetchChunks)(LuaJIT* self, int32_t query, LuaChunk** chunks);
+        int32_t (*addSystem)(LuaJIT* self, const char* name, int32_t query);
+    };
+
+    struct LuaFrameStats {
+        uint32_t calls;             // C to Lua transitions made by runSystems
+        uint64_t entities;          // entities handed to script systems
+        uint64_t nanoseconds;       // time spent inside script systems
+    };
+
+    // LuaJIT state bound to one ECS world. scripts reach component data through FFI cdata
+    // pointers into the chunk columns, so a field access compiles to a plain load or store
+    // instead of a C API call with a push/pop per value
+    class LuaJIT {
+    public:
+        LuaJIT();
+        ~LuaJIT();
+        LuaJIT(const LuaJIT&) = delete;
+        LuaJIT& operator=(const LuaJIT&) = delete;
+
+        // creates the state and installs the `engine` module, returns false when the prelude fails
+        bool init(ECS::World& world);
+        void shutdown();
+        lua_State* state() { return L; }
+
+        // makes component T visible to scripts as `typedef struct { <fields> } <name>;`, the
+        // FFI size is checked against sizeof(T) so a layout mismatch fails here instead of
+        // corrupting chunk memory later
+        template<typename T>
+        bool registerComponent(const char* name, const char* fields) {
+            return registerComponent(ECS::componentId<T>(), sizeof(T), name, fields);
+        }
+        bool registerComponent(ECS::ComponentId id, size_t size, const char* name, const char* fields);
+
+        // scripts below sourceRoot load from their cooked bytecode below cookedRoot (see
+        // tools/lua_cook) whenever its source hash matches, everything else loads from source
+        void setBytecodeCache(const std::string& sourceRoot, const std::string& cookedRoot);
+        // pushes the compiled chunk, prints the error and returns false on failure
+        bool loadFile(const char* path);
+        bool runString(const char* code, const char* chunkName);
+        bool runFile(const char* path);
+        uint32_t bytecodeLoads() const { return cookedLoads; }
+        // pcall with the error printed, expects the function and nargs arguments on the stack
+        bool call(int nargs, int nresults);
+
+        // runs every system registered with engine.system once, each call gets the whole batch
+        // of matching chunks and loops over it inside Lua. one thread at a time per state
+        void runSystems(float deltaTime);
+        // restricts every query of this state to the chunks whose (archetype id + chunk index)
+        // % count is index. the key belongs to the chunk, not the query, so states sharing a
+        // world with disjoint partitions can run side by side whatever their queries are
+        void setPartition(uint32_t index, uint32_t count);
+        // while frozen, engine.query only hands out queries this state already made and errors
+        // for new ones, making one changes the world's query cache. a pool freezes its states
+        // for the length of every update
+        void setQueriesFrozen(bool frozen) { queriesFrozen = frozen; }
+        // reports the calls and time per entity since the last endFrame to the profiler, states
+        // owned by a pool pass false and the pool reports the totals
+        void endFrame(bool report = true);
+        const LuaFrameStats& lastFrame() const { return lastStats; }
+        size_t systemCount() const { return systems.size(); }
+        // every component registered so far, for declaring script system access to a scheduler
+        const ECS::ComponentMask& componentMask() const { return registeredMask; }
+
+        // script facing entry points, called through the FFI function pointers in LuaEngineApi.
+        // createQuery returns -1 for bad components and -2 while queries are frozen or the world
+        // is locked by a running scheduler
+        int32_t createQuery(const char* const* names, int32_t count);
+        uint32_t fetchChunks(int32_t query, LuaChunk** chunks);
+        int32_t addSystem(const char* name, int32_t query);
+
+    private:
+        struct ScriptQuery {
+            ECS::Query* query;
+            std::vector<ECS::ComponentId> components;
+            std::vector<LuaChunk> chunks;
+            uint64_t fetchedEntities;   // in the chunks of the last fetch
+        };
+
+        struct ScriptSystem {
+            std::string name;
+            std::string counterName;    // "lua ns/entity <name>"
+            int32_t query;
+            uint64_t entities;
+            uint64_t nanoseconds;
+        };
+
+        lua_State* L;
+        ECS::World* world;
+        LuaEngineApi api;
+        int registerFunction;       // registry ref of the prelude's component registration
+        int systemFunctions;        // registry ref of the prelude's system table, indexed like systems
+        std::string scriptRoot;
+        std::string cookedRoot;
+        uint32_t cookedLoads;
+        uint32_t partitionIndex;
+        uint32_t partitionCount;
+        bool queriesFrozen;
+        std::unordered_map<std::string, ECS::ComponentId> componentsByName;
+        ECS::ComponentMask registeredMask;
+        std::vector<ScriptQuery> queries;
+        // deque so the names handed to the profiler stay put when systems get added
+        std::deque<ScriptSystem> systems;
+        LuaFrameStats frameStats;
+        LuaFrameStats lastStats;
+    };
+
+    // times entity updates four ways: native C++, a Lua script system over FFI views, a lua_pcall
+    // per entity and Lua through the classic C API with per-entity get/set calls
+    void runLuaComponentBenchmark(uint32_t entities, uint32_t iterations);
+
+    // generates `scripts` modules in a temp directory, cooks them and times loading all of them
+    // into a fresh state from source and from the mapped bytecode
+    void runLuaStartupBenchmark(uint32_t scripts);
+
+    // the same transform update over Lua tables and over the assets/scripts/vmath.lua FFI types,
+    // with operators and with in place methods. reports time and Lua heap allocations per frame
+    void runLuaMathBenchmark(uint32_t transforms, const std::string& scriptRoot);
+
+} // namespace Engine
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct lua_State;
+
+namespace Engine {
+
+    class LuaJIT;
+
+    struct LuaGCSettings {
+        double minStepMs = 0.2;             // spent every frame even without idle time so a cycle always progresses
+        double maxStepMs = 2.0;
+        double pause = 1.5;                 // next cycle starts once the heap grew this much since the last one
+        size_t ceilingBytes = 256u << 20;   // full collect above this, whatever the frame budget says
+    };
+
+    struct LuaGCStats {
+        double milliseconds;        // time spent collecting in the last frame
+        uint32_t steps;
+        uint32_t cycles;            // cycles finished in the last frame
+        uint32_t emergencyCollects; // since attach
+        size_t heapBytes;
+    };
+
+    // engine driven collection for a LuaJIT state. automatic stepping is off, the collector only
+    // runs in collect(), which the frame loop calls with the idle time left before the frame
+    // limiter releases the frame, so collection never lands in the middle of script work
+    class LuaGC {
+    public:
+        explicit LuaGC(const LuaGCSettings& settings = LuaGCSettings());
+        LuaGC(const LuaGC&) = delete;
+        LuaGC& operator=(const LuaGC&) = delete;
+
+        void attach(LuaJIT& lua);
+        // hands collection back to LuaJIT, call before the state is closed if it keeps running
+        void detach();
+
+        // incremental steps for idleNanoseconds clamped to the min/max step settings
+        void collect(uint64_t idleNanoseconds);
+        // reports GC time and heap size to the profiler
+        void endFrame();
+        const LuaGCStats& lastFrame() const { return lastStats; }
+
+        LuaGCSettings& getSettings() { return settings; }
+
+    private:
+        size_t heapBytes() const;
+
+        lua_State* L;
+        LuaGCSettings settings;
+        bool inCycle;
+        size_t heapAfterCycle;
+        LuaGCStats frameStats;
+        LuaGCStats lastStats;
+    };
+
+} // namespace Engine
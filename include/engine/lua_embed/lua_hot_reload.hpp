@@ -0,0 +1,109 @@
+#pragma once
+
+#include "engine/core/file_watcher.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct lua_State;
+
+namespace Engine {
+
+    class LuaJIT;
+
+    struct LuaReloadStats {
+        uint32_t files;             // changed files applied in the last frame
+        uint32_t modules;           // modules re-run for them, the changed ones plus their dependents
+        uint32_t failures;          // compile or run errors, the old code stays in place
+        double milliseconds;        // main thread time spent applying
+    };
+
+    // live reload of scripts while the engine runs. modules come from require(name), resolved
+    // to <scriptRoot>/<name with dots as slashes>.lua, and top level scripts from runScript.
+    // every require is recorded, so a change re-runs the changed module and only the modules
+    // that (transitively) required it, dependencies first.
+    //
+    // a re-run keeps state: the table a module returned the first time stays the module, new
+    // functions are copied into it (nested tables too, so metatables shared with live objects
+    // pick up new methods) while data fields keep their values and only new keys are added.
+    // non function upvalues of the new functions, of re-registered engine.system functions and
+    // of global functions the chunk defines are joined with the old ones of the same name, so
+    // module locals keep their values as well.
+    //
+    // the watcher thread waits on inotify and compiles changed files to bytecode in its own
+    // lua_State, the main thread only loads finished bytecode and runs the chunks in apply().
+    // besides the init() state, states added with addState (the LuaStatePool's) get the same
+    // loader and bookkeeping, a changed file is re-run in every state that loaded it
+    class LuaHotReload {
+    public:
+        LuaHotReload();
+        ~LuaHotReload();
+        LuaHotReload(const LuaHotReload&) = delete;
+        LuaHotReload& operator=(const LuaHotReload&) = delete;
+
+        // installs the module loader and the reload bookkeeping, works without watch() too
+        bool init(LuaJIT& lua, const std::string& scriptRoot);
+        void shutdown();
+
+        // installs the loader and bookkeeping in another state, after init()
+        bool addState(LuaJIT& lua);
+
+        // runFile for a top level script that should take part in reloads, in the init() state
+        // or in one added with addState
+        bool runScript(const char* path);
+        bool runScript(LuaJIT& lua, const char* path);
+
+        // starts the watcher thread on scriptRoot and the directories of the scripts run so far,
+        // in any state
+        bool watch();
+
+        // runs finished reloads, at least one per call when any is waiting and more while
+        // budgetNanoseconds lasts. meant for the frame's idle time like the script GC
+        void apply(uint64_t budgetNanoseconds);
+
+        // reports reload counts and time to the profiler
+        void endFrame();
+        const LuaReloadStats& lastFrame() const { return lastStats; }
+
+    private:
+        struct Compiled {
+            std::string path;
+            std::string bytecode;   // empty when the file didn't compile
+        };
+
+        struct Target {
+            LuaJIT* lua;
+            int runScriptFunction;  // registry refs to the Lua side of the bookkeeping
+            int reloadFunction;
+        };
+
+        bool install(LuaJIT& lua);
+        Target* find(LuaJIT& lua);
+        void watchThread();
+        void applyOne(const Compiled& compiled);
+        bool applyTo(Target& target, const Compiled& compiled, uint32_t& modules);
+
+        LuaJIT* lua;                // the init() state, also targets[0]
+        std::string root;
+        std::vector<std::string> scriptDirectories;
+        std::vector<Target> targets;
+
+        Core::FileWatcher watcher;
+        std::thread thread;
+        std::atomic<bool> running;
+
+        // filled by the watcher thread, moved to `ready` by apply()
+        std::mutex mutex;
+        std::vector<Compiled> compiled;
+        std::atomic<bool> pending;
+        std::vector<Compiled> ready;
+
+        LuaReloadStats frameStats;
+        LuaReloadStats lastStats;
+    };
+
+} // namespace Engine
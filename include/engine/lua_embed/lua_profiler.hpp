@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+struct lua_State;
+
+namespace Engine {
+
+    class LuaJIT;
+
+    struct LuaProfilerSettings {
+        int intervalMs = 1;         // sampling interval of LuaJIT's profiler
+        int depth = 3;              // stack frames in a sample name, innermost last
+    };
+
+    struct LuaProfilerStats {
+        uint32_t samples;
+        uint32_t compiled;          // samples in JIT compiled code
+        uint32_t interpreted;
+        uint32_t native;            // in C functions called from Lua
+        uint32_t gc;
+        uint32_t compiler;          // in the JIT compiler itself
+        uint32_t traces;            // traces compiled
+        uint32_t aborts;            // trace attempts aborted
+        uint32_t fallbacks;         // traces that exit to the interpreter
+    };
+
+    // samples the stacks of one LuaJIT state with luaJIT_profile_start and merges them into the
+    // engine's profiler timeline: runs of identical samples become spans on a "lua samples"
+    // track, named after the sampled stack and where the VM was ("[interpreted]", "[gc]", ...),
+    // so script hotspots line up with the C++ scopes around them in captures and flight
+    // recorder dumps. trace aborts and traces falling back to the interpreter are caught with
+    // jit.attach, printed the first time each location and reason shows up and marked on a
+    // "lua jit" track. LuaJIT has one profiler per process, so only one state at a time
+    class LuaProfiler {
+    public:
+        LuaProfiler();
+        ~LuaProfiler();
+        LuaProfiler(const LuaProfiler&) = delete;
+        LuaProfiler& operator=(const LuaProfiler&) = delete;
+
+        bool start(LuaJIT& lua, const LuaProfilerSettings& settings = LuaProfilerSettings());
+        void stop();
+
+        // closes the open sample span and reports sample and trace counts to the profiler
+        void endFrame();
+        const LuaProfilerStats& lastFrame() const { return lastStats; }
+
+        // hottest sampled functions since start with their interpreted share, then every
+        // trace abort and interpreter fallback location
+        void printReport(FILE* file, size_t top = 20) const;
+
+        // entry points for the VM sample callback and the jit.attach handler
+        void sample(lua_State* L, int samples, int vmstate);
+        void traceEvent(const char* kind, const char* location, const char* reason);
+
+    private:
+        struct Hotspot {
+            uint32_t samples;
+            uint32_t interpreted;
+        };
+
+        struct TraceProblem {
+            std::string kind;
+            std::string location;
+            std::string reason;
+            uint32_t count;
+        };
+
+        // span names have to outlive the trace rings, interned strings are never freed
+        const char* intern(const std::string& text);
+        void flushSpan();
+
+        lua_State* L;
+        int attachRef;              // registry ref to the jit.attach handler, for detaching
+        LuaProfilerSettings settings;
+        std::unordered_set<std::string> names;
+
+        // run of identical samples not yet written to the timeline
+        const char* spanName;
+        uint64_t spanStart;
+        uint64_t spanLast;
+
+        std::unordered_map<const char*, Hotspot> hotspots;  // by interned leaf frame
+        std::unordered_map<std::string, TraceProblem> problems;
+        uint64_t totalSamples;
+        uint64_t totalInterpreted;
+
+        LuaProfilerStats frameStats;
+        LuaProfilerStats lastStats;
+    };
+
+} // namespace Engine
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+struct lua_State;
+
+namespace Engine {
+
+    // Camera and Renderer::ShaderProgram for scripts, declared with LuaBind. also sets
+    // engine.CameraMovement to the Camera_Movement values
+    bool bindRendererTypes(lua_State* L);
+
+    // calls a camera method 1M times through a hand written C API binding, the generated C API
+    // thunk and the generated FFI thunk, and prints the cost per call
+    void runLuaBindingBenchmark(uint32_t calls);
+
+} // namespace Engine
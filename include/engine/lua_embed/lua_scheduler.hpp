@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace Engine {
+
+    class LuaJIT;
+
+    struct LuaSchedulerStats {
+        uint32_t resumed;       // resumes during the last frame
+        uint32_t sleeping;      // parked in the timing wheel
+        uint32_t waiting;       // parked on an event
+        uint32_t alive;
+    };
+
+    // resumes script coroutines only when what they wait for happens. scripts get
+    //   engine.spawn(fn)             run fn as a coroutine, first resume is the next update
+    //   engine.sleep(seconds)        timed wait in simulation time
+    //   engine.waitEvent(name)       returns the payload passed to engine.signal
+    //   engine.waitAsset(path)       waits for the "asset:<path>" event
+    //   engine.waitFrame()           resumes on the next update
+    //   engine.signal(name, payload) wakes every coroutine waiting on name, on the next update
+    // timed waits sit in a hierarchical timing wheel and event waits in per event lists, so a
+    // parked coroutine costs nothing per frame, update only touches the wheel slots it passes
+    class LuaScheduler {
+    public:
+        LuaScheduler();
+        ~LuaScheduler();
+        LuaScheduler(const LuaScheduler&) = delete;
+        LuaScheduler& operator=(const LuaScheduler&) = delete;
+
+        // installs the engine.* wait functions, the LuaJIT state has to stay alive until shutdown
+        bool init(LuaJIT& lua);
+        void shutdown();
+
+        // advances the wheel by deltaTime seconds and resumes everything that became ready
+        void update(float deltaTime);
+        void signal(const char* event);
+        void assetLoaded(const char* path);
+
+        // reports resumed, sleeping and waiting counts to the profiler
+        void endFrame();
+        const LuaSchedulerStats& lastFrame() const { return lastStats; }
+
+        // entry points for the engine.spawn and engine.signal closures
+        void spawn(lua_State* thread, int threadRef);
+        void queueSignal(const char* event, int payloadRef);
+
+    private:
+        static const uint32_t WHEEL_LEVELS = 4;
+        static const uint32_t WHEEL_BITS = 6;
+        static const uint32_t WHEEL_SLOTS = 1u << WHEEL_BITS;
+        static const uint32_t TICKS_PER_SECOND = 1000;
+
+        struct Coroutine {
+            lua_State* thread;
+            int ref;                // registry ref keeping the thread alive, LUA_NOREF when the slot is free
+            uint64_t deadline;      // in wheel ticks while sleeping
+        };
+
+        struct Wake {
+            uint32_t coroutine;
+            int payloadRef;
+        };
+
+        struct Signal {
+            uint32_t event;
+            int payloadRef;
+        };
+
+        uint32_t eventId(const char* event);
+        void scheduleSleep(uint32_t coroutine, uint64_t deadline);
+        void cascade(uint32_t level);
+        void advanceTick();
+        void resume(uint32_t coroutine, int payloadRef);
+        void release(uint32_t coroutine);
+
+        lua_State* L;
+        std::vector<Coroutine> coroutines;
+        std::vector<uint32_t> freeCoroutines;
+
+        // level k slot s holds coroutines due within the 64^k ticks starting at s * 64^k
+        std::vector<uint32_t> wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+        std::vector<uint32_t> cascading;
+        uint64_t currentTick;
+        double pendingTicks;
+
+        std::unordered_map<std::string, uint32_t> eventIds;
+        std::vector<std::vector<uint32_t>> waitLists;     // indexed by event id
+        std::vector<Signal> signals;
+        std::vector<Signal> dispatching;
+
+        // coroutines to resume this update, swapped with `resuming` so resumes can queue more
+        std::vector<Wake> ready;
+        std::vector<Wake> resuming;
+
+        LuaSchedulerStats frameStats;
+        LuaSchedulerStats lastStats;
+    };
+
+} // namespace Engine
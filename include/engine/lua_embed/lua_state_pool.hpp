@@ -0,0 +1,114 @@
+#pragma once
+
+#include "engine/core/mpsc_queue.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Engine {
+namespace Jobs {
+    class JobSystem;
+}
+
+    // one message between pool states. bytes hold the serialized payload and belong to the
+    // message until the receiver decodes it
+    struct LuaMessage {
+        uint32_t from;
+        uint32_t sequence;      // per sender, orders messages from one sender
+        uint32_t size;
+        char* bytes;
+    };
+
+    // immutable payload shared by reference instead of copied, freed with its last reference.
+    // scripts get it from engine.share(string) and read it with blob:pointer() through FFI
+    struct LuaSharedBlob {
+        std::atomic<uint32_t> references;
+        uint32_t size;
+        char data[1];
+    };
+
+    struct LuaPoolStats {
+        uint32_t calls;             // script system calls summed over all states
+        uint32_t sent;
+        uint32_t delivered;
+        uint32_t dropped;           // sends that found the target inbox full
+        double busiestStateMs;      // longest single state update, the parallel frame's floor
+    };
+
+    // isolated lua_States sharing one ECS world, each state sees a disjoint partition of the
+    // chunks so all of them run their script systems in parallel on the job system. a chunk
+    // belongs to the same state in every query, two systems over different components never
+    // hand one chunk to two states. queries have to be made outside update(), when scripts load:
+    // making one changes the shared world, so engine.query errors for new queries inside systems
+    // and onMessage handlers. states never touch each other, scripts talk through
+    //   engine.send(state, value)     value is deep copied (nil, booleans, numbers, strings,
+    //                                 tables of those) or a shared blob passed by reference
+    //   engine.onMessage(from, value) called with every message before the state's systems run
+    //   engine.share(string)          makes an immutable blob
+    //   engine.state, engine.stateCount
+    // every inbox is a lock-free MPSC queue. messages sent during an update are delivered at the
+    // start of the next one, ordered by sender then send order, so delivery is deterministic
+    class LuaStatePool {
+    public:
+        static const size_t INBOX_CAPACITY = 4096;
+
+        LuaStatePool();
+        ~LuaStatePool();
+        LuaStatePool(const LuaStatePool&) = delete;
+        LuaStatePool& operator=(const LuaStatePool&) = delete;
+
+        bool init(ECS::World& world, uint32_t stateCount);
+        void shutdown();
+
+        uint32_t stateCount() const { return (uint32_t)states.size(); }
+        LuaJIT& state(uint32_t index) { return *states[index]->lua; }
+
+        template<typename T>
+        bool registerComponent(const char* name, const char* fields) {
+            for (std::unique_ptr<State>& state : states) {
+                if (!state->lua->registerComponent<T>(name, fields)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        // loads the script into every state, each state registers its own copy of the systems
+        bool runFile(const char* path);
+        bool runString(const char* code, const char* chunkName);
+
+        // delivers last update's messages and runs every state's script systems, one job per state
+        void update(Jobs::JobSystem& jobs, float deltaTime);
+        // reports message counts, script calls and the busiest state's time to the profiler
+        void endFrame();
+        const LuaPoolStats& lastFrame() const { return lastStats; }
+
+        // engine.send, callable from any state's thread. takes ownership of bytes
+        bool post(uint32_t target, uint32_t from, char* bytes, uint32_t size);
+
+    private:
+        struct State {
+            std::unique_ptr<LuaJIT> lua;
+            Core::MpscQueue<LuaMessage, INBOX_CAPACITY> inbox;
+            std::vector<LuaMessage> delivering;
+            std::vector<uint32_t> sendSequence;     // next sequence per target, sender thread only
+            uint32_t delivered;
+            uint64_t updateNanoseconds;
+        };
+
+        void deliver(State& state);
+        void runState(uint32_t index, float deltaTime);
+
+        std::vector<std::unique_ptr<State>> states;
+        std::atomic<uint32_t> sent;
+        std::atomic<uint32_t> dropped;
+        LuaPoolStats lastStats;
+    };
+
+    // times the same script update with 1..maxStates pool states on a job system with one
+    // worker per extra state, maxStates 0 goes up to the hardware thread count
+    void runLuaPoolBenchmark(uint32_t entities, uint32_t maxStates);
+
+} // namespace Engine
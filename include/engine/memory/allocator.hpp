@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace Engine {
+namespace Memory {
+
+    const size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
+    inline size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // interface engine containers allocate through, deallocate gets the size back so pools and
+    // arenas don't need per allocation headers
+    class Allocator {
+    public:
+        virtual ~Allocator() {}
+        virtual void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) = 0;
+        virtual void deallocate(void* pointer, size_t size, size_t alignment = DEFAULT_ALIGNMENT) = 0;
+    };
+
+    // forwards to the global heap
+    class HeapAllocator : public Allocator {
+    public:
+        void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) override;
+        void deallocate(void* pointer, size_t size, size_t alignment = DEFAULT_ALIGNMENT) override;
+    };
+
+    Allocator& heapAllocator();
+
+    // std allocator adapter so standard containers can run on any engine allocator
+    template<typename T>
+    class StlAllocator {
+    public:
+        using value_type = T;
+
+        StlAllocator() : allocator(&heapAllocator()) {}
+        StlAllocator(Allocator& allocator) : allocator(&allocator) {}
+        template<typename U>
+        StlAllocator(const StlAllocator<U>& other) : allocator(other.allocator) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(allocator->allocate(count * sizeof(T), alignof(T)));
+        }
+        void deallocate(T* pointer, size_t count) {
+            allocator->deallocate(pointer, count * sizeof(T), alignof(T));
+        }
+
+        template<typename U>
+        bool operator==(const StlAllocator<U>& other) const { return allocator == other.allocator; }
+        template<typename U>
+        bool operator!=(const StlAllocator<U>& other) const { return allocator != other.allocator; }
+
+        Allocator* allocator;
+    };
+
+    template<typename T>
+    using Vector = std::vector<T, StlAllocator<T>>;
+
+    // process wide count of heap allocations: every global operator new plus the malloc and
+    // realloc calls made for C libraries through the memory tracker (Lua, GLFW, nuklear). only
+    // counted when the engine is built with ENGINE_TRACK_ALLOCATIONS, otherwise always 0
+    uint64_t heapAllocationCount();
+    // counts one allocation made outside operator new, for the tracker's malloc paths
+    void countHeapAllocation();
+    bool heapAllocationTrackingEnabled();
+
+} // namespace Memory
+} // namespace Engine
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "engine/memory/allocator.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace Engine {
+namespace Memory {
+
+    // bump allocator over one fixed block, allocation is a single atomic add so worker threads
+    // can share it, individual frees are no-ops and everything goes away on reset(). requests
+    // that don't fit spill to the heap instead of failing, reset() frees the spills too
+    class LinearArena : public Allocator {
+    public:
+        explicit LinearArena(size_t capacity);
+        ~LinearArena();
+        LinearArena(const LinearArena&) = delete;
+        LinearArena& operator=(const LinearArena&) = delete;
+
+        // never returns nullptr. a spilled request still counts towards the high water mark so
+        // the capacity can be tuned, and shows up as a heap allocation in the frame counts
+        void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) override;
+        void deallocate(void*, size_t, size_t = DEFAULT_ALIGNMENT) override {}
+
+        template<typename T>
+        T* allocateArray(size_t count) {
+            return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void reset();
+        size_t used() const { return offset.load(std::memory_order_relaxed) < capacity ? offset.load(std::memory_order_relaxed) : capacity; }
+        size_t getCapacity() const { return capacity; }
+        size_t highWaterMark() const { return peak; }
+        // requests that went to the heap since the last reset
+        size_t spillCount() const { return spillsSinceReset; }
+
+    private:
+        struct Spill {
+            void* pointer;
+            size_t alignment;
+        };
+
+        unsigned char* memory;
+        size_t capacity;
+        std::atomic<size_t> offset;
+        size_t peak;
+        std::mutex spillMutex;
+        std::vector<Spill> spills;
+        size_t spillsSinceReset;
+
+        void* spill(size_t size, size_t alignment);
+    };
+
+    // two arenas flipped every frame, memory handed out during frame N stays valid through frame
+    // N + 1 so the render side can consume what the simulation produced while the next frame
+    // is being built
+    class FrameArena : public Allocator {
+    public:
+        explicit FrameArena(size_t capacityPerFrame);
+
+        // flips buffers and resets the one that becomes current, call once at the start of a frame
+        void beginFrame();
+
+        void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) override { return current().allocate(size, alignment); }
+        void deallocate(void*, size_t, size_t = DEFAULT_ALIGNMENT) override {}
+
+        template<typename T>
+        T* allocateArray(size_t count) {
+            return current().allocateArray<T>(count);
+        }
+
+        LinearArena& current() { return arenas[index]; }
+        LinearArena& previous() { return arenas[index ^ 1]; }
+        size_t highWaterMark() const { return arenas[0].highWaterMark() > arenas[1].highWaterMark() ? arenas[0].highWaterMark() : arenas[1].highWaterMark(); }
+
+    private:
+        LinearArena arenas[2];
+        unsigned int index;
+    };
+
+} // namespace Memory
+} // namespace Engine
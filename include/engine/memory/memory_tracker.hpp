@@ -0,0 +1,77 @@
+#pragma once
+
+#include "engine/memory/allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine {
+namespace Memory {
+
+    // subsystem a tracked allocation is charged to. Gpu* tags count driver side storage the
+    // engine asked for, not CPU memory
+    enum class MemoryTag : uint8_t {
+        ECS,
+        Profiler,
+        UI,
+        Glfw,
+        Lua,
+        GpuBuffers,
+        GpuTextures,
+        Count
+    };
+
+    const char* memoryTagName(MemoryTag tag);
+
+    struct MemoryTagStats {
+        uint64_t currentBytes;
+        uint64_t peakBytes;
+        uint64_t totalAllocations;
+        uint64_t frameAllocations;      // allocations during the last completed frame
+    };
+
+    // every counter is a relaxed atomic per tag, cheap enough to leave on in release builds
+    void trackAllocation(MemoryTag tag, size_t size);
+    void trackFree(MemoryTag tag, size_t size);
+    // closes the per frame allocation counts, call once per frame
+    void memoryTrackerEndFrame();
+    MemoryTagStats memoryTagStats(MemoryTag tag);
+    // writes a table of every tag, returns false when the file can't be opened
+    bool dumpMemoryStats(const char* path);
+
+    // malloc style functions for C libraries that don't hand the size back on free, a small
+    // header in front of each block remembers it
+    void* taggedMalloc(MemoryTag tag, size_t size);
+    void* taggedRealloc(MemoryTag tag, void* pointer, size_t size);
+    void taggedFree(MemoryTag tag, void* pointer);
+
+    // lua_Alloc compatible allocator charged to MemoryTag::Lua, pass it to lua_newstate with a
+    // null userdata
+    void* luaAllocate(void* userdata, void* pointer, size_t oldSize, size_t newSize);
+
+    // wraps another allocator and charges everything going through it to one tag
+    class TaggedAllocator : public Allocator {
+    public:
+        TaggedAllocator(Allocator& backing, MemoryTag tag) : backing(backing), tag(tag) {}
+
+        void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) override {
+            void* pointer = backing.allocate(size, alignment);
+            if (pointer) {
+                trackAllocation(tag, size);
+            }
+            return pointer;
+        }
+        void deallocate(void* pointer, size_t size, size_t alignment = DEFAULT_ALIGNMENT) override {
+            if (pointer) {
+                trackFree(tag, size);
+            }
+            backing.deallocate(pointer, size, alignment);
+        }
+
+    private:
+        Allocator& backing;
+        MemoryTag tag;
+    };
+
+} // namespace Memory
+} // namespace Engine
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "engine/memory/allocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine {
+namespace Memory {
+
+    // fixed size block allocator, free blocks form an intrusive singly linked list and new
+    // pages are only requested when the list runs dry. not thread safe, one owner at a time
+    class PoolAllocator {
+    public:
+        PoolAllocator(size_t blockSize, size_t blocksPerPage);
+        ~PoolAllocator();
+        PoolAllocator(const PoolAllocator&) = delete;
+        PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+        void* allocate();
+        void deallocate(void* pointer);
+
+        size_t getBlockSize() const { return blockSize; }
+        size_t pageCount() const { return pages; }
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+        struct Page {
+            Page* next;
+        };
+
+        size_t blockSize;
+        size_t blocksPerPage;
+        FreeBlock* freeList;
+        Page* pageList;
+        size_t pages;
+
+        void grow();
+    };
+
+    const size_t SMALL_OBJECT_MAX_SIZE = 256;
+
+    // small object allocator backed by one set of size class pools per thread, no locking on
+    // the fast path. a block freed on another thread simply joins that thread's pool for the
+    // same size class, which is safe because the per thread pools are never torn down and
+    // their pages live until the process exits. per pool counts would drift with every cross
+    // thread free, so the live block count is one atomic for the whole process
+    class SmallObjectAllocator : public Allocator {
+    public:
+        void* allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT) override;
+        void deallocate(void* pointer, size_t size, size_t alignment = DEFAULT_ALIGNMENT) override;
+
+        // pooled blocks allocated and not freed yet, over all threads
+        static int64_t liveCount();
+    };
+
+    Allocator& smallObjectAllocator();
+
+} // namespace Memory
+} // namespace Engine
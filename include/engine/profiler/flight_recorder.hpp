@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Engine {
+namespace Profiler {
+
+    struct FlightRecorderSettings {
+        bool enabled = true;
+        double thresholdMs = 50.0;          // frames longer than this trigger a dump
+        uint32_t framesBefore = 120;        // frames before the spike included in the dump
+        uint32_t framesAfter = 30;          // frames after it, the dump is written once they ran
+        double minSecondsBetweenDumps = 30.0;
+        uint32_t maxDumps = 10;             // per run
+        std::string prefix = "hitch";       // files are <prefix>_<frame>.json
+    };
+
+    // watches frame times and dumps the profiler rings around a spike as a Chrome trace. the
+    // rings are always recording anyway, so the only per frame cost is one timestamp. dumps go
+    // through the profiler's capture writer (queueExport), so writing one can't cause the next
+    // hitch and finishCaptures() waits for them like for any other capture
+    class FlightRecorder {
+    public:
+        explicit FlightRecorder(const FlightRecorderSettings& settings);
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        // call once per frame right after PROFILE_FRAME(). frames that are slow on purpose
+        // (idle throttling, loading) pass countable = false and never trigger a dump
+        void endFrame(bool countable = true);
+
+        uint32_t dumpCount() const { return dumps; }
+        void setEnabled(bool enabled) { settings.enabled = enabled; }
+        bool isEnabled() const { return settings.enabled; }
+
+    private:
+        static const uint32_t FRAME_HISTORY = 1024;   // power of two, > framesBefore + framesAfter
+
+        FlightRecorderSettings settings;
+        uint64_t frameEnds[FRAME_HISTORY];            // profiler ticks at the end of each frame
+        uint64_t frame;
+        uint64_t spikeFrame;                          // frame that triggered the pending dump
+        double spikeMs;
+        bool pending;
+        uint64_t lastDumpTicks;
+        uint32_t dumps;
+
+        void startDump(uint64_t endTicks);
+    };
+
+} // namespace Profiler
+} // namespace Engine
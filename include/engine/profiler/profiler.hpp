@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace Engine {
+namespace Profiler {
+
+    enum class EventType : uint8_t {
+        Begin,
+        End,
+        Complete,       // data is the duration in ticks, for events recorded after the fact
+        Counter,        // data holds the bits of a double
+        FrameMark
+    };
+
+    struct Event {
+        uint64_t ticks;
+        const char* name;   // must outlive the profiler, string literals in practice
+        uint64_t data;
+        EventType type;
+    };
+
+    // raw timestamp, the TSC on x86, steady_clock nanoseconds elsewhere
+    inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // one ring entry, a seqlock of its own: sequence is odd while event i is being written
+    // (2i + 1) and even once it's done (2i + 2), so a reader on another thread can tell a torn
+    // or overwritten copy from a good one. the fields are relaxed atomics only to keep that
+    // reader well defined, on x86 they are the same plain stores as before
+    struct EventSlot {
+        std::atomic<uint64_t> ticks;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> data;
+        std::atomic<uint32_t> sequence;
+        std::atomic<EventType> type;
+    };
+
+    // per thread event ring, written only by its thread. the ring overwrites its oldest events,
+    // read() fails for slots overwritten or still being written
+    struct ThreadBuffer {
+        static const size_t CAPACITY = 1 << 15;
+
+        alignas(64) std::atomic<uint64_t> head;
+        uint32_t threadId;
+        char name[32];
+        EventSlot events[CAPACITY];
+
+        void push(EventType type, const char* eventName, uint64_t data) {
+            pushAt(ticks(), type, eventName, data);
+        }
+
+        void pushAt(uint64_t timestamp, EventType type, const char* eventName, uint64_t data) {
+            uint64_t index = head.load(std::memory_order_relaxed);
+            EventSlot& slot = events[index & (CAPACITY - 1)];
+            uint32_t sequence = (uint32_t)index * 2;
+            slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.ticks.store(timestamp, std::memory_order_relaxed);
+            slot.name.store(eventName, std::memory_order_relaxed);
+            slot.data.store(data, std::memory_order_relaxed);
+            slot.type.store(type, std::memory_order_relaxed);
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+            head.store(index + 1, std::memory_order_release);
+        }
+
+        // copies event `index` out of the ring, false once it was overwritten or while its
+        // owner is still writing it. safe from any thread
+        bool read(uint64_t index, Event& event) const {
+            const EventSlot& slot = events[index & (CAPACITY - 1)];
+            uint32_t expected = (uint32_t)index * 2 + 2;
+            if (slot.sequence.load(std::memory_order_acquire) != expected) {
+                return false;
+            }
+            event.ticks = slot.ticks.load(std::memory_order_relaxed);
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.data = slot.data.load(std::memory_order_relaxed);
+            event.type = slot.type.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == expected;
+        }
+    };
+
+    // registers the calling thread on first use, buffers are never freed so exported traces
+    // can still show threads that have exited
+    ThreadBuffer* registerThread();
+
+    inline thread_local ThreadBuffer* localBuffer = nullptr;
+
+    inline ThreadBuffer& threadBuffer() {
+        ThreadBuffer* buffer = localBuffer;
+        return buffer ? *buffer : *registerThread();
+    }
+
+    inline void emit(EventType type, const char* name, uint64_t data = 0) {
+        threadBuffer().push(type, name, data);
+    }
+
+    inline void counter(const char* name, double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        emit(EventType::Counter, name, bits);
+    }
+
+    // shows up as the thread's name in exported traces. cheapest as the thread's first profiler
+    // call, the buffer is then registered with its name already in place
+    void setThreadName(const char* name);
+
+    // records a span measured elsewhere (GPU timings) on a named pseudo thread, timestamps are
+    // Core::nowNanoseconds() values. main thread only
+    void recordSpan(const char* track, const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds);
+
+    // ticks <-> nanoseconds on the Core::nowNanoseconds() clock, calibrated once at startup
+    uint64_t ticksToNanoseconds(uint64_t ticks);
+    uint64_t nanosecondsToTicks(uint64_t nanoseconds);
+
+    // marks the end of a frame and advances an on-demand capture
+    void frameMark();
+    uint64_t frameNumber();
+
+    // captures the next `frames` frames and writes them to `path` as Chrome trace JSON once the
+    // last one ends, on a background writer so the frame ending the capture doesn't pay for it.
+    // ignored while a capture is already running
+    void requestCapture(uint32_t frames, const std::string& path);
+    bool isCapturing();
+
+    // hands exportTrace over the tick range to the background writer that also writes the
+    // requested captures, jobs are written in order
+    void queueExport(const std::string& path, uint64_t startTicks, uint64_t endTicks);
+    // blocks until every capture handed to the background writer is on disk, call before exiting
+    void finishCaptures();
+
+    // writes every event still in the thread rings between the two tick values as Chrome trace
+    // JSON (opens in Perfetto and chrome://tracing). returns false when the file can't be written.
+    // the rings keep recording meanwhile, events overwritten before they were copied are left out
+    bool exportTrace(const std::string& path, uint64_t startTicks, uint64_t endTicks);
+
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(name) { emit(EventType::Begin, name); }
+        ~Scope() { emit(EventType::End, name); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+    };
+
+} // namespace Profiler
+} // namespace Engine
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// instrumentation compiles to nothing without ENGINE_PROFILING (CMake option of the same name)
+#ifdef ENGINE_PROFILING
+#define PROFILE_SCOPE(name) Engine::Profiler::Scope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_COUNTER(name, value) Engine::Profiler::counter(name, (double)(value))
+#define PROFILE_FRAME() Engine::Profiler::frameMark()
+#define PROFILE_THREAD_NAME(name) Engine::Profiler::setThreadName(name)
+#define PROFILE_SPAN(track, name, startNs, endNs) Engine::Profiler::recordSpan(track, name, startNs, endNs)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_SPAN(track, name, startNs, endNs) ((void)0)
+#endif
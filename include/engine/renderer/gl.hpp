@@ -0,0 +1,140 @@
+#pragma once
+
+// engine code includes GL through this header. with ENGINE_GL_TRACE every GL call the engine
+// makes is routed through the tracer in engine/renderer/gl_trace.hpp, without it this is
+// plain GLEW and costs nothing
+#include "GL/glew.h"
+
+#ifdef ENGINE_GL_TRACE
+#include "engine/renderer/gl_trace.hpp"
+
+// glew defines most entry points as macros over its function pointers, the undefs drop those
+#undef glActiveTexture
+#define glActiveTexture Engine::Renderer::glTrace_ActiveTexture
+#undef glAttachShader
+#define glAttachShader Engine::Renderer::glTrace_AttachShader
+#undef glBeginQuery
+#define glBeginQuery Engine::Renderer::glTrace_BeginQuery
+#undef glBindBuffer
+#define glBindBuffer Engine::Renderer::glTrace_BindBuffer
+#undef glBindFramebuffer
+#define glBindFramebuffer Engine::Renderer::glTrace_BindFramebuffer
+#undef glBindRenderbuffer
+#define glBindRenderbuffer Engine::Renderer::glTrace_BindRenderbuffer
+#undef glBindTexture
+#define glBindTexture Engine::Renderer::glTrace_BindTexture
+#undef glBindVertexArray
+#define glBindVertexArray Engine::Renderer::glTrace_BindVertexArray
+#undef glBlendEquation
+#define glBlendEquation Engine::Renderer::glTrace_BlendEquation
+#undef glBlendFunc
+#define glBlendFunc Engine::Renderer::glTrace_BlendFunc
+#undef glBufferData
+#define glBufferData Engine::Renderer::glTrace_BufferData
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus Engine::Renderer::glTrace_CheckFramebufferStatus
+#undef glClear
+#define glClear Engine::Renderer::glTrace_Clear
+#undef glCompileShader
+#define glCompileShader Engine::Renderer::glTrace_CompileShader
+#undef glCreateProgram
+#define glCreateProgram Engine::Renderer::glTrace_CreateProgram
+#undef glCreateShader
+#define glCreateShader Engine::Renderer::glTrace_CreateShader
+#undef glDeleteBuffers
+#define glDeleteBuffers Engine::Renderer::glTrace_DeleteBuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers Engine::Renderer::glTrace_DeleteFramebuffers
+#undef glDeleteQueries
+#define glDeleteQueries Engine::Renderer::glTrace_DeleteQueries
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers Engine::Renderer::glTrace_DeleteRenderbuffers
+#undef glDeleteShader
+#define glDeleteShader Engine::Renderer::glTrace_DeleteShader
+#undef glDeleteTextures
+#define glDeleteTextures Engine::Renderer::glTrace_DeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays Engine::Renderer::glTrace_DeleteVertexArrays
+#undef glDisable
+#define glDisable Engine::Renderer::glTrace_Disable
+#undef glDrawArrays
+#define glDrawArrays Engine::Renderer::glTrace_DrawArrays
+#undef glDrawElements
+#define glDrawElements Engine::Renderer::glTrace_DrawElements
+#undef glEnable
+#define glEnable Engine::Renderer::glTrace_Enable
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray Engine::Renderer::glTrace_EnableVertexAttribArray
+#undef glEndQuery
+#define glEndQuery Engine::Renderer::glTrace_EndQuery
+#undef glFinish
+#define glFinish Engine::Renderer::glTrace_Finish
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer Engine::Renderer::glTrace_FramebufferRenderbuffer
+#undef glGenBuffers
+#define glGenBuffers Engine::Renderer::glTrace_GenBuffers
+#undef glGenFramebuffers
+#define glGenFramebuffers Engine::Renderer::glTrace_GenFramebuffers
+#undef glGenQueries
+#define glGenQueries Engine::Renderer::glTrace_GenQueries
+#undef glGenRenderbuffers
+#define glGenRenderbuffers Engine::Renderer::glTrace_GenRenderbuffers
+#undef glGenTextures
+#define glGenTextures Engine::Renderer::glTrace_GenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays Engine::Renderer::glTrace_GenVertexArrays
+#undef glGenerateMipmap
+#define glGenerateMipmap Engine::Renderer::glTrace_GenerateMipmap
+#undef glGetFloatv
+#define glGetFloatv Engine::Renderer::glTrace_GetFloatv
+#undef glGetInteger64v
+#define glGetInteger64v Engine::Renderer::glTrace_GetInteger64v
+#undef glGetIntegerv
+#define glGetIntegerv Engine::Renderer::glTrace_GetIntegerv
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog Engine::Renderer::glTrace_GetProgramInfoLog
+#undef glGetProgramiv
+#define glGetProgramiv Engine::Renderer::glTrace_GetProgramiv
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v Engine::Renderer::glTrace_GetQueryObjectui64v
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog Engine::Renderer::glTrace_GetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv Engine::Renderer::glTrace_GetShaderiv
+#undef glGetString
+#define glGetString Engine::Renderer::glTrace_GetString
+#undef glGetUniformLocation
+#define glGetUniformLocation Engine::Renderer::glTrace_GetUniformLocation
+#undef glLinkProgram
+#define glLinkProgram Engine::Renderer::glTrace_LinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange Engine::Renderer::glTrace_MapBufferRange
+#undef glQueryCounter
+#define glQueryCounter Engine::Renderer::glTrace_QueryCounter
+#undef glReadPixels
+#define glReadPixels Engine::Renderer::glTrace_ReadPixels
+#undef glRenderbufferStorage
+#define glRenderbufferStorage Engine::Renderer::glTrace_RenderbufferStorage
+#undef glScissor
+#define glScissor Engine::Renderer::glTrace_Scissor
+#undef glShaderSource
+#define glShaderSource Engine::Renderer::glTrace_ShaderSource
+#undef glTexImage2D
+#define glTexImage2D Engine::Renderer::glTrace_TexImage2D
+#undef glTexParameteri
+#define glTexParameteri Engine::Renderer::glTrace_TexParameteri
+#undef glUniform1f
+#define glUniform1f Engine::Renderer::glTrace_Uniform1f
+#undef glUniform1i
+#define glUniform1i Engine::Renderer::glTrace_Uniform1i
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv Engine::Renderer::glTrace_UniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer Engine::Renderer::glTrace_UnmapBuffer
+#undef glUseProgram
+#define glUseProgram Engine::Renderer::glTrace_UseProgram
+#undef glVertexAttribPointer
+#define glVertexAttribPointer Engine::Renderer::glTrace_VertexAttribPointer
+#undef glViewport
+#define glViewport Engine::Renderer::glTrace_Viewport
+#endif
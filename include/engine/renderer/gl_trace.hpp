@@ -0,0 +1,106 @@
+#pragma once
+
+#include "engine/renderer/gl_trace_format.hpp"
+
+#include "GL/glew.h"
+
+#include <cstdint>
+
+namespace Engine {
+namespace Renderer {
+
+    struct GLCallCounters {
+        uint32_t calls;
+        uint64_t nanoseconds;   // CPU time spent inside the driver call
+    };
+
+    struct GLFrameStats {
+        GLCallCounters functions[GL_FUNCTION_COUNT];
+        uint32_t totalCalls;
+        uint64_t totalNanoseconds;
+        uint32_t syncCalls;     // sync point calls between glTraceBeginFrame and glTraceEndFrame
+    };
+
+    // brackets the frame loop body. calls outside a frame (startup, the swap) are counted into
+    // the next frame but never reported as sync points
+    void glTraceBeginFrame();
+    void glTraceEndFrame();
+    const GLFrameStats& glTraceLastFrame();
+    void glTracePrintStats();
+
+    // records every traced call from now on, including the ones between frames, until the end of
+    // the `frames`th frame into a binary trace for tools/gl_replay. start it before the renderer creates its GL objects, the replay
+    // drops references to objects it never saw created (framebuffers become its own target).
+    // returns false when the file can't be opened
+    bool glTraceStartCapture(const char* path, uint32_t frames);
+    bool glTraceIsCapturing();
+
+    // drop-in replacements for the GL entry points the engine uses, engine code reaches them
+    // through the macros in engine/renderer/gl.hpp when built with ENGINE_GL_TRACE
+    void glTrace_ActiveTexture(GLenum texture);
+    void glTrace_AttachShader(GLuint program, GLuint shader);
+    void glTrace_BeginQuery(GLenum target, GLuint id);
+    void glTrace_BindBuffer(GLenum target, GLuint buffer);
+    void glTrace_BindFramebuffer(GLenum target, GLuint framebuffer);
+    void glTrace_BindRenderbuffer(GLenum target, GLuint renderbuffer);
+    void glTrace_BindTexture(GLenum target, GLuint texture);
+    void glTrace_BindVertexArray(GLuint array);
+    void glTrace_BlendEquation(GLenum mode);
+    void glTrace_BlendFunc(GLenum sfactor, GLenum dfactor);
+    void glTrace_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+    GLenum glTrace_CheckFramebufferStatus(GLenum target);
+    void glTrace_Clear(GLbitfield mask);
+    void glTrace_CompileShader(GLuint shader);
+    GLuint glTrace_CreateProgram();
+    GLuint glTrace_CreateShader(GLenum type);
+    void glTrace_DeleteBuffers(GLsizei n, const GLuint* buffers);
+    void glTrace_DeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+    void glTrace_DeleteQueries(GLsizei n, const GLuint* ids);
+    void glTrace_DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+    void glTrace_DeleteShader(GLuint shader);
+    void glTrace_DeleteTextures(GLsizei n, const GLuint* textures);
+    void glTrace_DeleteVertexArrays(GLsizei n, const GLuint* arrays);
+    void glTrace_Disable(GLenum cap);
+    void glTrace_DrawArrays(GLenum mode, GLint first, GLsizei count);
+    void glTrace_DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+    void glTrace_Enable(GLenum cap);
+    void glTrace_EnableVertexAttribArray(GLuint index);
+    void glTrace_EndQuery(GLenum target);
+    void glTrace_Finish();
+    void glTrace_FramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+    void glTrace_GenBuffers(GLsizei n, GLuint* buffers);
+    void glTrace_GenFramebuffers(GLsizei n, GLuint* framebuffers);
+    void glTrace_GenQueries(GLsizei n, GLuint* ids);
+    void glTrace_GenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+    void glTrace_GenTextures(GLsizei n, GLuint* textures);
+    void glTrace_GenVertexArrays(GLsizei n, GLuint* arrays);
+    void glTrace_GenerateMipmap(GLenum target);
+    void glTrace_GetFloatv(GLenum pname, GLfloat* data);
+    void glTrace_GetInteger64v(GLenum pname, GLint64* data);
+    void glTrace_GetIntegerv(GLenum pname, GLint* data);
+    void glTrace_GetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+    void glTrace_GetProgramiv(GLuint program, GLenum pname, GLint* params);
+    void glTrace_GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params);
+    void glTrace_GetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+    void glTrace_GetShaderiv(GLuint shader, GLenum pname, GLint* params);
+    const GLubyte* glTrace_GetString(GLenum name);
+    GLint glTrace_GetUniformLocation(GLuint program, const GLchar* name);
+    void glTrace_LinkProgram(GLuint program);
+    void* glTrace_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    void glTrace_QueryCounter(GLuint id, GLenum target);
+    void glTrace_ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+    void glTrace_RenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+    void glTrace_Scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void glTrace_ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+    void glTrace_TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+    void glTrace_TexParameteri(GLenum target, GLenum pname, GLint param);
+    void glTrace_Uniform1f(GLint location, GLfloat v0);
+    void glTrace_Uniform1i(GLint location, GLint v0);
+    void glTrace_UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+    GLboolean glTrace_UnmapBuffer(GLenum target);
+    void glTrace_UseProgram(GLuint program);
+    void glTrace_VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+    void glTrace_Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+} // namespace Renderer
+} // namespace Engine
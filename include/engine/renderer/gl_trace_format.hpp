@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+
+// binary GL trace shared by the engine's tracer and tools/gl_replay. a file is a GLTraceHeader
+// followed by records, each a GLTraceRecord, argCount 64 bit arguments and payloadBytes of data
+// (buffer contents, pixels, strings, generated object names) padded to 8 bytes so the next
+// record's arguments stay aligned. signed arguments are sign extended, floats are stored as
+// their 32 bit pattern
+
+namespace Engine {
+namespace Renderer {
+
+    // X(name, syncPoint), syncPoint marks calls that make the driver wait for the GPU or at
+    // least flush its command queue, they shouldn't show up inside a frame
+#define ENGINE_GL_FUNCTIONS(X) \
+    X(ActiveTexture, false) \
+    X(AttachShader, false) \
+    X(BeginQuery, false) \
+    X(BindBuffer, false) \
+    X(BindFramebuffer, false) \
+    X(BindRenderbuffer, false) \
+    X(BindTexture, false) \
+    X(BindVertexArray, false) \
+    X(BlendEquation, false) \
+    X(BlendFunc, false) \
+    X(BufferData, false) \
+    X(CheckFramebufferStatus, true) \
+    X(Clear, false) \
+    X(CompileShader, false) \
+    X(CreateProgram, false) \
+    X(CreateShader, false) \
+    X(DeleteBuffers, false) \
+    X(DeleteFramebuffers, false) \
+    X(DeleteQueries, false) \
+    X(DeleteRenderbuffers, false) \
+    X(DeleteShader, false) \
+    X(DeleteTextures, false) \
+    X(DeleteVertexArrays, false) \
+    X(Disable, false) \
+    X(DrawArrays, false) \
+    X(DrawElements, false) \
+    X(Enable, false) \
+    X(EnableVertexAttribArray, false) \
+    X(EndQuery, false) \
+    X(Finish, true) \
+    X(FramebufferRenderbuffer, false) \
+    X(GenBuffers, false) \
+    X(GenFramebuffers, false) \
+    X(GenQueries, false) \
+    X(GenRenderbuffers, false) \
+    X(GenTextures, false) \
+    X(GenVertexArrays, false) \
+    X(GenerateMipmap, false) \
+    X(GetFloatv, true) \
+    X(GetInteger64v, true) \
+    X(GetIntegerv, true) \
+    X(GetProgramInfoLog, true) \
+    X(GetProgramiv, true) \
+    X(GetQueryObjectui64v, true) \
+    X(GetShaderInfoLog, true) \
+    X(GetShaderiv, true) \
+    X(GetString, true) \
+    X(GetUniformLocation, true) \
+    X(LinkProgram, false) \
+    X(MapBufferRange, false) \
+    X(QueryCounter, false) \
+    X(ReadPixels, true) \
+    X(RenderbufferStorage, false) \
+    X(Scissor, false) \
+    X(ShaderSource, false) \
+    X(TexImage2D, false) \
+    X(TexParameteri, false) \
+    X(Uniform1f, false) \
+    X(Uniform1i, false) \
+    X(UniformMatrix4fv, false) \
+    X(UnmapBuffer, false) \
+    X(UseProgram, false) \
+    X(VertexAttribPointer, false) \
+    X(Viewport, false)
+
+    enum class GLFunction : uint16_t {
+#define ENGINE_GL_ENUM(name, sync) name,
+        ENGINE_GL_FUNCTIONS(ENGINE_GL_ENUM)
+#undef ENGINE_GL_ENUM
+        Count,
+        // trace only markers, no GL call behind them
+        FrameBegin = 0xfff0,
+        FrameEnd
+    };
+
+    const uint32_t GL_FUNCTION_COUNT = (uint32_t)GLFunction::Count;
+
+    inline const char* glFunctionName(GLFunction function) {
+        static const char* names[] = {
+#define ENGINE_GL_NAME(name, sync) "gl" #name,
+            ENGINE_GL_FUNCTIONS(ENGINE_GL_NAME)
+#undef ENGINE_GL_NAME
+        };
+        return (uint32_t)function < GL_FUNCTION_COUNT ? names[(uint32_t)function] : "marker";
+    }
+
+    inline bool glFunctionIsSyncPoint(GLFunction function) {
+        static const bool sync[] = {
+#define ENGINE_GL_SYNC(name, syncPoint) syncPoint,
+            ENGINE_GL_FUNCTIONS(ENGINE_GL_SYNC)
+#undef ENGINE_GL_SYNC
+        };
+        return (uint32_t)function < GL_FUNCTION_COUNT && sync[(uint32_t)function];
+    }
+
+    const char GL_TRACE_MAGIC[4] = {'G', 'L', 'T', 'R'};
+    // 2: calls between FrameEnd and the next FrameBegin are recorded too
+    const uint32_t GL_TRACE_VERSION = 2;
+
+    struct GLTraceHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t functionCount;     // GL_FUNCTION_COUNT of the writer, ids are only stable per version
+        uint32_t reserved;
+    };
+
+    struct GLTraceRecord {
+        uint16_t function;
+        uint16_t argCount;
+        uint32_t payloadBytes;      // without the padding
+    };
+
+    inline uint64_t glTracePaddedSize(uint64_t payloadBytes) {
+        return (payloadBytes + 7) & ~(uint64_t)7;
+    }
+
+} // namespace Renderer
+} // namespace Engine
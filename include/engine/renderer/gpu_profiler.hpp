@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+namespace Renderer {
+
+    // one resolved scope of the most recent finished frame, in the Core::nowNanoseconds() clock
+    // domain so it lines up with CPU trace events
+    struct GpuScopeEvent {
+        const char* name;
+        uint32_t depth;
+        uint64_t startNanoseconds;
+        uint64_t endNanoseconds;
+    };
+
+    struct GpuScopeStats {
+        const char* name;
+        uint32_t depth;
+        double lastMs;
+        double averageMs;           // over the last AVERAGE_WINDOW resolved frames it appeared in
+    };
+
+    // nested GPU timing scopes built on GL_TIMESTAMP queries. every frame owns its own slice of
+    // a query ring and is read back FRAME_LATENCY frames later, by which point the GPU has
+    // normally finished it. a frame whose results still aren't available then is dropped rather
+    // than waited for. scope names must outlive the profiler, string literals in practice
+    class GpuProfiler {
+    public:
+        static const uint32_t FRAME_LATENCY = 4;
+        static const uint32_t MAX_SCOPES_PER_FRAME = 64;
+        static const uint32_t AVERAGE_WINDOW = 64;
+
+        GpuProfiler();
+        ~GpuProfiler();
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        // creates the query objects, needs a current GL context
+        void init();
+        // deletes the queries, call before the context goes away
+        void shutdown();
+        bool isInitialized() const { return initialized; }
+        // a disabled profiler issues no queries, frames already in flight are dropped
+        void setEnabled(bool enabled);
+        bool isEnabled() const { return enabled; }
+
+        // reads back the frame whose ring slot the next beginFrame reuses and refreshes the clock
+        // offset every CALIBRATION_INTERVAL frames. both are GL queries, call it before
+        // glTraceBeginFrame so they stay out of the frame's sync point count
+        void collect();
+        // starts recording a new frame, a slot that wasn't collected is dropped
+        void beginFrame();
+        void endFrame();
+
+        // returns UINT32_MAX when the frame ran out of scopes, endScope ignores that
+        uint32_t beginScope(const char* name);
+        void endScope(uint32_t scope);
+
+        // rolling per scope statistics, in order of first appearance
+        const std::vector<GpuScopeStats>& getStats() const { return stats; }
+        // scopes of the latest resolved frame, parents before their children
+        const std::vector<GpuScopeEvent>& getResolvedEvents() const { return resolvedEvents; }
+        // frame number (counted by beginFrame) the resolved events belong to, 0 before any
+        uint64_t getResolvedFrame() const { return resolvedFrame; }
+        // frames whose results weren't ready when their slot came up again
+        uint64_t getDroppedFrames() const { return droppedFrames; }
+
+        void printStats() const;
+
+    private:
+        struct Scope {
+            const char* name;
+            uint32_t depth;
+            bool closed;
+        };
+        struct Frame {
+            uint64_t number;
+            uint32_t scopeCount;
+            bool pending;
+            Scope scopes[MAX_SCOPES_PER_FRAME];
+        };
+        struct History {
+            double samples[AVERAGE_WINDOW];
+            uint32_t count;
+            uint32_t next;
+            double sum;
+        };
+
+        // two queries per scope, begin and end, laid out frame by frame
+        std::vector<unsigned int> queries;
+        Frame frames[FRAME_LATENCY];
+        uint64_t frameNumber;
+        uint32_t depth;
+        bool recording;
+        bool initialized;
+        bool enabled;
+
+        std::vector<GpuScopeStats> stats;
+        std::vector<History> histories;
+        std::vector<GpuScopeEvent> resolvedEvents;
+        uint64_t resolvedFrame;
+        uint64_t droppedFrames;
+        // Core::nowNanoseconds() minus the GL timestamp, refreshed every CALIBRATION_INTERVAL frames
+        int64_t clockOffset;
+
+        unsigned int query(uint32_t slot, uint32_t scope, bool end) const;
+        bool resultsAvailable(const Frame& frame, uint32_t slot) const;
+        void resolve(Frame& frame, uint32_t slot);
+        void calibrate();
+        size_t statsIndex(const char* name, uint32_t depth);
+    };
+
+    class GpuScope {
+    public:
+        GpuScope(GpuProfiler& profiler, const char* name) : profiler(profiler), scope(profiler.beginScope(name)) {}
+        ~GpuScope() { profiler.endScope(scope); }
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuProfiler& profiler;
+        uint32_t scope;
+    };
+
+} // namespace Renderer
+} // namespace Engine
+
+#define GPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define GPU_PROFILE_CONCAT(a, b) GPU_PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing block on the GPU
+#define GPU_PROFILE_SCOPE(profiler, name) Engine::Renderer::GpuScope GPU_PROFILE_CONCAT(gpuScope_, __LINE__)(profiler, name)
@@ -0,0 +1,29 @@
+#pragma once
+
+namespace Engine {
+namespace Renderer {
+
+    // OpenGL core context without any window system, prefers EGL_MESA_platform_surfaceless and
+    // falls back to a 1x1 pbuffer on the default display. rendering has to go to an FBO
+    class HeadlessContext {
+    public:
+        HeadlessContext();
+        ~HeadlessContext();
+        HeadlessContext(const HeadlessContext&) = delete;
+        HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+        bool create(int majorVersion, int minorVersion);
+        void destroy();
+        bool makeCurrent();
+        // "surfaceless" or "pbuffer", empty before create()
+        const char* getMode() const { return mode; }
+
+    private:
+        void* display;
+        void* context;
+        void* surface;
+        const char* mode;
+    };
+
+} // namespace Renderer
+} // namespace Engine
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Engine {
+namespace Renderer {
+
+    // per frame counters filled in by whoever issues the GL calls, reset at the start of a frame
+    struct RenderStats {
+        uint32_t drawCalls = 0;
+        uint64_t triangles = 0;
+        uint32_t stateChanges = 0;      // program, texture and vertex array binds
+
+        void reset() { *this = RenderStats(); }
+    };
+
+} // namespace Renderer
+} // namespace Engine
@@ -11,10 +11,17 @@ namespace Renderer {
         unsigned int ID;
         ShaderProgram(const char* vertexPath, const char* fragmentPath);
         void Use();
-        void setBool(const std::string &name, bool value) const;
-        void setInt(const std::string &name, int value) const;
-        void setFloat(const std::string &name, float value) const;
-        void setMat4(const std::string &name, glm::mat4 value) const;
+        // names are plain C strings so the Lua bindings pass script strings through without a copy
+        void setBool(const char* name, bool value) const;
+        void setInt(const char* name, int value) const;
+        void setFloat(const char* name, float value) const;
+        void setMat4(const char* name, glm::mat4 value) const;
+
+        // the setters above look the name up in the driver on every call, per frame uniforms
+        // should look their location up once after linking and use these
+        int uniformLocation(const char* name) const;
+        void setIntAt(int location, int value) const;
+        void setMat4At(int location, const glm::mat4& value) const;
     private:
         char* readShaderFile(const char* fileName);
     };
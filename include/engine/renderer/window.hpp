@@ -0,0 +1,61 @@
+#pragma once
+
+#include "engine/renderer/headless_context.hpp"
+
+struct GLFWwindow;
+
+namespace Engine {
+namespace Renderer {
+
+    struct WindowSettings {
+        int width = 1280;
+        int height = 720;
+        const char* title = "Hello World";
+        // no window system at all, renders into an offscreen framebuffer of width x height
+        bool headless = false;
+    };
+
+    // the render target the engine loop draws into, either a GLFW window or an offscreen
+    // framebuffer on a headless EGL context. everything after create() is the same GL either way
+    class Window {
+    public:
+        Window();
+        ~Window();
+        Window(const Window&) = delete;
+        Window& operator=(const Window&) = delete;
+
+        // initializes GLFW, creates the OpenGL 3.3 core context, makes it current and loads
+        // GLEW. headless windows also get their framebuffer created and bound
+        bool create(const WindowSettings& settings);
+        // destroys the context and terminates GLFW
+        void destroy();
+
+        // null when headless
+        GLFWwindow* handle() const { return window; }
+        bool isHeadless() const { return settings.headless; }
+        int getWidth() const { return settings.width; }
+        int getHeight() const { return settings.height; }
+        // GL name of the offscreen framebuffer, 0 (the default framebuffer) for a real window
+        unsigned int getFramebuffer() const { return framebuffer; }
+
+        bool shouldClose() const;
+        void requestClose();
+        // presents a real window, headless windows wait for the GPU instead so frames can't
+        // queue up without bound the way they would with nothing ever blocking on a swap
+        void swapBuffers();
+
+    private:
+        WindowSettings settings;
+        GLFWwindow* window;
+        HeadlessContext headlessContext;
+        unsigned int framebuffer;
+        unsigned int colorBuffer;
+        unsigned int depthBuffer;
+        bool closeRequested;
+        bool glfwInitialized;
+
+        bool createFramebuffer();
+    };
+
+} // namespace Renderer
+} // namespace Engine
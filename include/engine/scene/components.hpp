@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Engine {
+namespace Scene {
+
+    struct Position {
+        glm::vec3 value;
+    };
+
+    // position at the previous simulation step, rendering blends towards Position with the
+    // fixed timestep's interpolation factor
+    struct PreviousPosition {
+        glm::vec3 value;
+    };
+
+    struct Velocity {
+        glm::vec3 value;
+    };
+
+    // tag for entities drawn with the cube mesh
+    struct CubeMesh {
+        unsigned int texture;
+    };
+
+} // namespace Scene
+} // namespace Engine
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+namespace Scene {
+
+    // affine matrix stored as three rows of (rotation/scale | translation), 48 bytes instead of 64
+    struct alignas(16) Mat3x4 {
+        float m[12];
+
+        glm::mat4 toMat4() const;
+    };
+
+    struct TransformHandle {
+        uint32_t id = UINT32_MAX;
+
+        bool isNull() const { return id == UINT32_MAX; }
+    };
+
+    // ECS component linking an entity to its node in the transform hierarchy
+    struct Transform {
+        TransformHandle node;
+    };
+
+    // parent/child transforms stored in depth-first order, every subtree is one contiguous
+    // range of slots so a dirty node and all its descendants are [slot, slot + subtreeSize).
+    // local TRS is kept as SoA arrays so world matrices can be built four at a time with SIMD,
+    // update() only touches subtrees that were modified since the last call, static nodes cost
+    // nothing per frame
+    class TransformHierarchy {
+    public:
+        TransformHierarchy();
+
+        TransformHandle create(TransformHandle parent = TransformHandle());
+        // destroys the node together with its whole subtree
+        void destroy(TransformHandle handle);
+        void setParent(TransformHandle handle, TransformHandle parent);
+        TransformHandle getParent(TransformHandle handle) const;
+        bool isValid(TransformHandle handle) const { return handle.id < slotOf.size() && slotOf[handle.id] != UINT32_MAX; }
+
+        void setPosition(TransformHandle handle, const glm::vec3& position);
+        void setRotation(TransformHandle handle, const glm::quat& rotation);
+        void setScale(TransformHandle handle, const glm::vec3& scale);
+        void setLocal(TransformHandle handle, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+        glm::vec3 getPosition(TransformHandle handle) const;
+        glm::quat getRotation(TransformHandle handle) const;
+        glm::vec3 getScale(TransformHandle handle) const;
+
+        // world matrix as of the last update()
+        const Mat3x4& getWorld(TransformHandle handle) const { return world[slotOf[handle.id]]; }
+
+        // recomputes world matrices of every modified subtree, returns the number of nodes updated
+        uint32_t update();
+
+        size_t size() const { return parent.size(); }
+
+    private:
+        // SoA local transform, indexed by slot
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        std::vector<uint32_t> parent;        // slot of the parent or UINT32_MAX for roots
+        std::vector<uint32_t> subtreeSize;   // including the node itself
+        std::vector<uint32_t> handleOf;      // slot -> handle id
+        std::vector<uint8_t> dirty;
+        std::vector<Mat3x4> local;
+        std::vector<Mat3x4> world;
+
+        std::vector<uint32_t> slotOf;        // handle id -> slot
+        std::vector<uint32_t> freeHandles;
+        std::vector<uint32_t> dirtyHandles;
+
+        // scratch for update() and structural changes, kept to avoid reallocating every frame
+        std::vector<uint32_t> dirtyRanges;
+        std::vector<uint32_t> order;
+
+        void markDirty(uint32_t slot);
+        // reorders every slot array so that new slot i holds old slot order[i]
+        void applyOrder(const std::vector<uint32_t>& order);
+        void appendSubtree(std::vector<uint32_t>& out, uint32_t slot) const;
+        void computeLocal(uint32_t begin, uint32_t end);
+    };
+
+} // namespace Scene
+} // namespace Engine
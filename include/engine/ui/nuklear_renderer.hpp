@@ -0,0 +1,70 @@
+#pragma once
+
+#include "engine/ui/nuklear.hpp"
+#include "engine/renderer/shader.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace Engine {
+namespace Input {
+    class InputSystem;
+}
+
+namespace UI {
+
+    // nuklear backend for the GL 3.3 core context. all UI geometry of a frame is converted into
+    // one streamed vertex/index buffer pair and drawn with a single program, one draw per
+    // nuklear command (clip rect / texture change)
+    class NuklearRenderer {
+    public:
+        NuklearRenderer();
+        ~NuklearRenderer();
+        NuklearRenderer(const NuklearRenderer&) = delete;
+        NuklearRenderer& operator=(const NuklearRenderer&) = delete;
+
+        // compiles the shader, creates the buffers and bakes the default font, needs a current
+        // GL context
+        bool init();
+        void shutdown();
+
+        nk_context* context() { return &ctx; }
+
+        // replays the events InputSystem drained this frame into nuklear
+        void input(const Input::InputSystem& input);
+        // draws everything queued since the last render and clears the command list. depth
+        // testing is restored afterwards, blending and scissoring are left disabled. the UI is
+        // laid out in window coordinates like the input events, only the scissor rects are
+        // scaled to the framebuffer, which is larger on HiDPI displays
+        void render(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight);
+
+        uint32_t lastDrawCalls() const { return drawCalls; }
+
+    private:
+        static const size_t MAX_VERTEX_BYTES = 512 * 1024;
+        static const size_t MAX_ELEMENT_BYTES = 128 * 1024;
+
+        // everything init creates before the nuklear context itself
+        void releaseResources();
+
+        nk_allocator allocator;     // charges nuklear's own memory to MemoryTag::UI
+        nk_context ctx;
+        nk_font_atlas atlas;
+        nk_buffer commands;
+        nk_draw_null_texture nullTexture;
+        std::unique_ptr<Renderer::ShaderProgram> shader;
+        int projectionLocation;
+        int atlasLocation;
+        unsigned int vao;
+        unsigned int vbo;
+        unsigned int ebo;
+        unsigned int fontTexture;
+        size_t fontTextureBytes;
+        uint32_t drawCalls;
+        bool initialized;
+        bool convertFailed;         // reported once, not every frame
+        bool mapFailed;             // same
+    };
+
+} // namespace UI
+} // namespace Engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "engine/renderer/render_stats.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine {
+class LuaGC;
+namespace Core { class FramePacer; }
+namespace ECS { class SystemScheduler; }
+namespace Input { class InputSystem; }
+namespace Jobs { class JobSystem; }
+namespace Memory { class FrameArena; }
+namespace Profiler { class FlightRecorder; }
+namespace Renderer { class GpuProfiler; }
+
+namespace UI {
+
+    class NuklearRenderer;
+
+    // everything the overlay reads or toggles, any pointer may be null and its section is skipped
+    struct PerfOverlaySources {
+        struct SchedulerEntry {
+            const char* label;
+            const ECS::SystemScheduler* scheduler;
+        };
+        std::vector<SchedulerEntry> schedulers;
+        Renderer::GpuProfiler* gpuProfiler = nullptr;
+        const Jobs::JobSystem* jobs = nullptr;
+        Core::FramePacer* pacer = nullptr;
+        Profiler::FlightRecorder* flightRecorder = nullptr;
+        Memory::FrameArena* frameArena = nullptr;
+        const LuaGC* luaGC = nullptr;
+    };
+
+    // performance HUD drawn with nuklear. while hidden update() and render() return before
+    // touching anything, so the overlay costs one branch per frame when it isn't shown
+    class PerfOverlay {
+    public:
+        PerfOverlay(NuklearRenderer& ui, const PerfOverlaySources& sources);
+
+        void toggle() { setVisible(!visible); }
+        void setVisible(bool value);
+        bool isVisible() const { return visible; }
+
+        // builds the UI for this frame. frameMs is the wall time of the previous frame,
+        // renderStats and heapAllocations describe it as well
+        void update(const Input::InputSystem& input, double frameMs, const Renderer::RenderStats& renderStats, uint64_t heapAllocations);
+        // layout happens in window coordinates, see NuklearRenderer::render
+        void render(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight);
+
+    private:
+        static const uint32_t HISTORY = 240;
+
+        NuklearRenderer& ui;
+        PerfOverlaySources sources;
+        bool visible;
+
+        float frameHistory[HISTORY];
+        uint32_t historyCount;
+        uint32_t historyNext;
+
+        std::vector<uint64_t> lastBusy;         // job system busy nanoseconds per thread
+        std::vector<float> utilization;         // smoothed, 0..1
+        uint64_t lastSample;
+
+        void sampleJobs();
+    };
+
+} // namespace UI
+} // namespace Engine
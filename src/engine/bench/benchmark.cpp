@@ -0,0 +1,189 @@
+#include "engine/bench/benchmark.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/memory/allocator.hpp"
+
+#include "engine/renderer/gl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+namespace Engine {
+namespace Bench {
+
+    Percentiles computePercentiles(std::vector<double>& values) {
+        Percentiles result;
+        if (values.empty()) {
+            return result;
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double value : values) {
+            sum += value;
+        }
+        auto rank = [&values](double percentile) {
+            size_t index = (size_t)std::ceil(percentile * (double)values.size());
+            return values[index > 0 ? index - 1 : 0];
+        };
+        result.mean = sum / (double)values.size();
+        result.p50 = rank(0.50);
+        result.p95 = rank(0.95);
+        result.p99 = rank(0.99);
+        result.max = values.back();
+        return result;
+    }
+
+    BenchmarkRecorder::BenchmarkRecorder(const BenchmarkSettings& settings)
+        : settings(settings), frame(0), frameStart(0), allocationsAtStart(0), drawCalls(0), frameTriangles(0), initialized(false) {
+        // reserved up front so recording never allocates inside the frame loop
+        samples.reserve(settings.frames);
+        for (uint32_t i = 0; i < QUERY_RING; i++) {
+            queries[i] = 0;
+            querySample[i] = -1;
+        }
+    }
+
+    BenchmarkRecorder::~BenchmarkRecorder() {
+        if (initialized) {
+            glDeleteQueries(QUERY_RING, queries);
+        }
+    }
+
+    void BenchmarkRecorder::init() {
+        glGenQueries(QUERY_RING, queries);
+        initialized = true;
+    }
+
+    float BenchmarkRecorder::progress() const {
+        uint32_t total = settings.warmupFrames + settings.frames;
+        return total ? (float)frame / (float)total : 0.0f;
+    }
+
+    void BenchmarkRecorder::collectQuery(uint32_t slot) {
+        if (querySample[slot] < 0) {
+            return;
+        }
+        // by the time a slot comes around again the result is normally ready, this only
+        // blocks when the GPU is more than QUERY_RING frames behind
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &elapsed);
+        samples[(size_t)querySample[slot]].gpuMs = (double)elapsed / 1000000.0;
+        querySample[slot] = -1;
+    }
+
+    void BenchmarkRecorder::beginFrame() {
+        drawCalls = 0;
+        frameTriangles = 0;
+        frameStart = Core::nowNanoseconds();
+        allocationsAtStart = Memory::heapAllocationCount();
+        uint32_t slot = frame % QUERY_RING;
+        collectQuery(slot);
+        glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+    }
+
+    void BenchmarkRecorder::endFrame() {
+        glEndQuery(GL_TIME_ELAPSED);
+        uint64_t frameEnd = Core::nowNanoseconds();
+        uint64_t allocations = Memory::heapAllocationCount() - allocationsAtStart;
+        if (!isWarmup() && !isFinished()) {
+            uint32_t slot = frame % QUERY_RING;
+            querySample[slot] = (int64_t)samples.size();
+            samples.push_back(FrameSample{Core::nanosecondsToMilliseconds(frameEnd - frameStart), 0.0, drawCalls, frameTriangles, allocations});
+        }
+        frame++;
+    }
+
+    bool BenchmarkRecorder::finish(int width, int height) {
+        if (initialized) {
+            for (uint32_t slot = 0; slot < QUERY_RING; slot++) {
+                collectQuery(slot);
+            }
+            glDeleteQueries(QUERY_RING, queries);
+            initialized = false;
+        }
+
+        std::vector<double> cpu, gpu;
+        cpu.reserve(samples.size());
+        gpu.reserve(samples.size());
+        double drawCallSum = 0.0;
+        double triangleSum = 0.0;
+        double allocationSum = 0.0;
+        for (const FrameSample& sample : samples) {
+            cpu.push_back(sample.cpuMs);
+            gpu.push_back(sample.gpuMs);
+            drawCallSum += sample.drawCalls;
+            triangleSum += (double)sample.triangles;
+            allocationSum += (double)sample.heapAllocations;
+        }
+        Percentiles cpuStats = computePercentiles(cpu);
+        Percentiles gpuStats = computePercentiles(gpu);
+        double frames = samples.empty() ? 1.0 : (double)samples.size();
+
+        printf("bench: %zu frames at %dx%d\n", samples.size(), width, height);
+        printf("  cpu ms  mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+            cpuStats.mean, cpuStats.p50, cpuStats.p95, cpuStats.p99, cpuStats.max);
+        printf("  gpu ms  mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+            gpuStats.mean, gpuStats.p50, gpuStats.p95, gpuStats.p99, gpuStats.max);
+        printf("  %.1f draw calls, %.0f triangles, %.2f heap allocations per frame\n", drawCallSum / frames, triangleSum / frames,
+            allocationSum / frames);
+
+        bool written = writeCsv(settings.output + ".csv") && writeJson(settings.output + ".json", width, height);
+        if (written) {
+            printf("bench: wrote %s.csv and %s.json\n", settings.output.c_str(), settings.output.c_str());
+        }
+        return written;
+    }
+
+    bool BenchmarkRecorder::writeCsv(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "bench: failed to write %s\n", path.c_str());
+            return false;
+        }
+        fprintf(file, "frame,cpu_ms,gpu_ms,draw_calls,triangles,heap_allocations\n");
+        for (size_t i = 0; i < samples.size(); i++) {
+            const FrameSample& sample = samples[i];
+            fprintf(file, "%zu,%.4f,%.4f,%u,%llu,%llu\n", i, sample.cpuMs, sample.gpuMs, sample.drawCalls, (unsigned long long)sample.triangles,
+                (unsigned long long)sample.heapAllocations);
+        }
+        fclose(file);
+        return true;
+    }
+
+    static void writePercentiles(FILE* file, const char* name, const Percentiles& stats, bool last) {
+        fprintf(file, "    \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+            name, stats.mean, stats.p50, stats.p95, stats.p99, stats.max, last ? "" : ",");
+    }
+
+    bool BenchmarkRecorder::writeJson(const std::string& path, int width, int height) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "bench: failed to write %s\n", path.c_str());
+            return false;
+        }
+        std::vector<double> cpu, gpu, draws, triangles, allocations;
+        for (const FrameSample& sample : samples) {
+            cpu.push_back(sample.cpuMs);
+            gpu.push_back(sample.gpuMs);
+            draws.push_back(sample.drawCalls);
+            triangles.push_back((double)sample.triangles);
+            allocations.push_back((double)sample.heapAllocations);
+        }
+        fprintf(file, "{\n");
+        fprintf(file, "  \"frames\": %zu,\n", samples.size());
+        fprintf(file, "  \"width\": %d,\n", width);
+        fprintf(file, "  \"height\": %d,\n", height);
+        fprintf(file, "  \"metrics\": {\n");
+        writePercentiles(file, "cpu_ms", computePercentiles(cpu), false);
+        writePercentiles(file, "gpu_ms", computePercentiles(gpu), false);
+        writePercentiles(file, "draw_calls", computePercentiles(draws), false);
+        writePercentiles(file, "triangles", computePercentiles(triangles), false);
+        writePercentiles(file, "heap_allocations", computePercentiles(allocations), true);
+        fprintf(file, "  }\n");
+        fprintf(file, "}\n");
+        fclose(file);
+        return true;
+    }
+
+} // namespace Bench
+} // namespace Engine
@@ -0,0 +1,113 @@
+#include "engine/bench/camera_path.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <stdio.h>
+
+namespace Engine {
+namespace Bench {
+
+    static float catmullRom(float p0, float p1, float p2, float p3, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                       (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+    }
+
+    // moves `angle` by whole turns so it is within 180 degrees of `reference`, keeps the
+    // closing segment of a loop from spinning the camera all the way around
+    static float unwrapDegrees(float angle, float reference) {
+        while (angle - reference > 180.0f) {
+            angle -= 360.0f;
+        }
+        while (angle - reference < -180.0f) {
+            angle += 360.0f;
+        }
+        return angle;
+    }
+
+    CameraPath CameraPath::defaultPath() {
+        const int KEYS = 8;
+        const glm::vec3 center(0.0f, 0.0f, -6.0f);
+        const float radius = 12.0f;
+
+        CameraPath path;
+        for (int i = 0; i < KEYS; i++) {
+            float angle = 2.0f * 3.14159265f * (float)i / (float)KEYS;
+            glm::vec3 position = center + glm::vec3(radius * std::cos(angle), 2.0f * std::sin(2.0f * angle), radius * std::sin(angle));
+            glm::vec3 toCenter = center - position;
+            float yaw = std::atan2(toCenter.z, toCenter.x) * 57.2957795f;
+            float pitch = std::atan2(toCenter.y, std::sqrt(toCenter.x * toCenter.x + toCenter.z * toCenter.z)) * 57.2957795f;
+            path.addKey(CameraKey{position, yaw, pitch});
+        }
+        return path;
+    }
+
+    bool CameraPath::load(const char* path) {
+        std::ifstream file(path);
+        if (!file) {
+            fprintf(stderr, "failed to open camera path %s\n", path);
+            return false;
+        }
+        keys.clear();
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.resize(comment);
+            }
+            std::istringstream stream(line);
+            CameraKey key;
+            if (stream >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch) {
+                keys.push_back(key);
+            }
+        }
+        if (keys.size() < 2) {
+            fprintf(stderr, "camera path %s needs at least two keys\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    CameraPose CameraPath::evaluate(float t) const {
+        if (keys.empty()) {
+            return CameraPose{glm::vec3(0.0f), -90.0f, 0.0f};
+        }
+        size_t count = keys.size();
+        t -= std::floor(t);
+        float scaled = t * (float)count;
+        size_t segment = (size_t)scaled;
+        if (segment >= count) {
+            segment = count - 1;
+        }
+        float local = scaled - (float)segment;
+
+        const CameraKey& k0 = keys[(segment + count - 1) % count];
+        const CameraKey& k1 = keys[segment];
+        const CameraKey& k2 = keys[(segment + 1) % count];
+        const CameraKey& k3 = keys[(segment + 2) % count];
+
+        CameraPose pose;
+        pose.position.x = catmullRom(k0.position.x, k1.position.x, k2.position.x, k3.position.x, local);
+        pose.position.y = catmullRom(k0.position.y, k1.position.y, k2.position.y, k3.position.y, local);
+        pose.position.z = catmullRom(k0.position.z, k1.position.z, k2.position.z, k3.position.z, local);
+
+        float yaw1 = k1.yaw;
+        float yaw0 = unwrapDegrees(k0.yaw, yaw1);
+        float yaw2 = unwrapDegrees(k2.yaw, yaw1);
+        float yaw3 = unwrapDegrees(k3.yaw, yaw2);
+        pose.yaw = catmullRom(yaw0, yaw1, yaw2, yaw3, local);
+        pose.pitch = catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, local);
+        if (pose.pitch > 89.0f) {
+            pose.pitch = 89.0f;
+        }
+        if (pose.pitch < -89.0f) {
+            pose.pitch = -89.0f;
+        }
+        return pose;
+    }
+
+} // namespace Bench
+} // namespace Engine
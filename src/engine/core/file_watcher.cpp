@@ -0,0 +1,92 @@
+#include "engine/core/file_watcher.hpp"
+
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+namespace Engine {
+namespace Core {
+
+    bool FileWatcher::open() {
+        close();
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            perror("inotify_init1");
+            return false;
+        }
+        return true;
+    }
+
+    void FileWatcher::close() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        directories.clear();
+    }
+
+    bool FileWatcher::watchTree(const std::string& directory) {
+        if (fd < 0) {
+            return false;
+        }
+        int watch = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+        if (watch < 0) {
+            return false;
+        }
+        directories[watch] = directory;
+
+        DIR* listing = opendir(directory.c_str());
+        if (!listing) {
+            return true;
+        }
+        while (dirent* entry = readdir(listing)) {
+            if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+                watchTree(directory + "/" + entry->d_name);
+            }
+        }
+        closedir(listing);
+        return true;
+    }
+
+    size_t FileWatcher::wait(int timeoutMs, std::vector<std::string>& changed) {
+        if (fd < 0) {
+            return 0;
+        }
+        pollfd request{fd, POLLIN, 0};
+        if (poll(&request, 1, timeoutMs) <= 0) {
+            return 0;
+        }
+
+        size_t found = 0;
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t bytes = read(fd, buffer, sizeof(buffer));
+            if (bytes <= 0) {
+                break;
+            }
+            for (char* p = buffer; p < buffer + bytes;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0) {
+                    continue;
+                }
+                std::string path = directory->second + "/" + event->name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        watchTree(path);
+                    }
+                } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    changed.push_back(path);
+                    found++;
+                }
+            }
+        }
+        return found;
+    }
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,35 @@
+#include "engine/core/fixed_timestep.hpp"
+
+namespace Engine {
+namespace Core {
+
+    FixedTimestep::FixedTimestep(uint64_t stepNanoseconds, uint32_t maxStepsPerFrame)
+        : step(stepNanoseconds ? stepNanoseconds : 1), maxSteps(maxStepsPerFrame ? maxStepsPerFrame : 1),
+          lastTime(0), accumulator(0), frameDelta(0), simulationTime(0), steps(0), dropped(0), started(false) {
+    }
+
+    uint32_t FixedTimestep::advance(uint64_t nowNanoseconds) {
+        if (!started) {
+            started = true;
+            lastTime = nowNanoseconds;
+        }
+        frameDelta = nowNanoseconds - lastTime;
+        lastTime = nowNanoseconds;
+        accumulator += frameDelta;
+
+        uint64_t due = accumulator / step;
+        if (due > maxSteps) {
+            // keep the fractional part so interpolation stays smooth after the hitch
+            uint64_t excess = (due - maxSteps) * step;
+            accumulator -= excess;
+            dropped += excess;
+            due = maxSteps;
+        }
+        accumulator -= due * step;
+        simulationTime += due * step;
+        steps += due;
+        return (uint32_t)due;
+    }
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,168 @@
+#include "engine/core/frame_pacer.hpp"
+#include "engine/core/clock.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdio.h>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <immintrin.h>
+#   define ENGINE_CPU_RELAX() _mm_pause()
+#else
+#   define ENGINE_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace Engine {
+namespace Core {
+
+    // the OS scheduler routinely oversleeps by up to a millisecond, sleep until this far from
+    // the deadline and spin the rest
+    static const uint64_t SPIN_THRESHOLD_NS = 1500000;
+
+    const char* vsyncModeName(VsyncMode mode) {
+        switch (mode) {
+            case VsyncMode::On: return "on";
+            case VsyncMode::Adaptive: return "adaptive";
+            case VsyncMode::Off: return "off";
+            default: return "unknown";
+        }
+    }
+
+    bool parseVsyncMode(const char* text, VsyncMode& mode) {
+        for (int i = 0; i < (int)VsyncMode::Count; i++) {
+            if (strcmp(text, vsyncModeName((VsyncMode)i)) == 0) {
+                mode = (VsyncMode)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void FrameTimeStats::add(double ms) {
+        frames++;
+        if (frames == 1) {
+            minMs = ms;
+            maxMs = ms;
+        } else {
+            minMs = ms < minMs ? ms : minMs;
+            maxMs = ms > maxMs ? ms : maxMs;
+        }
+        double delta = ms - meanMs;
+        meanMs += delta / (double)frames;
+        m2 += delta * (ms - meanMs);
+    }
+
+    double FrameTimeStats::standardDeviation() const {
+        return std::sqrt(variance());
+    }
+
+    FramePacer::FramePacer(GLFWwindow* window, const FramePacerSettings& settings)
+        : window(window), settings(settings), vsync(settings.vsync), frameInterval(0), lastFrameEnd(0), idle(false) {
+        setFrameLimit(settings.fpsLimit);
+        setVsync(settings.vsync);
+    }
+
+    // a negative swap interval is only honoured with the tear extension of the context's API,
+    // everywhere else it gets clamped to the minimum interval and behaves like vsync off
+    static bool adaptiveVsyncSupported() {
+        return glfwExtensionSupported("EGL_EXT_swap_control_tear") ||
+            glfwExtensionSupported("GLX_EXT_swap_control_tear") ||
+            glfwExtensionSupported("WGL_EXT_swap_control_tear");
+    }
+
+    void FramePacer::setVsync(VsyncMode mode) {
+        // without a window there is nothing to swap, the mode only labels the frame stats
+        if (mode == VsyncMode::Adaptive && window && !adaptiveVsyncSupported()) {
+            fprintf(stderr, "adaptive vsync needs EGL_EXT_swap_control_tear, which this context lacks, using vsync on\n");
+            mode = VsyncMode::On;
+        }
+        vsync = mode;
+        if (window) {
+            glfwSwapInterval(mode == VsyncMode::On ? 1 : mode == VsyncMode::Adaptive ? -1 : 0);
+        }
+        // the first interval after a switch straddles two modes, don't count it
+        lastFrameEnd = 0;
+    }
+
+    void FramePacer::cycleVsync() {
+        setVsync((VsyncMode)(((int)vsync + 1) % (int)VsyncMode::Count));
+        printf("vsync: %s\n", vsyncModeName(vsync));
+    }
+
+    void FramePacer::setFrameLimit(double fps) {
+        settings.fpsLimit = fps;
+        frameInterval = fps > 0.0 ? secondsToNanoseconds(1.0 / fps) : 0;
+    }
+
+    void FramePacer::waitUntil(uint64_t deadline) {
+        uint64_t now = nowNanoseconds();
+        if (now + SPIN_THRESHOLD_NS < deadline) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - SPIN_THRESHOLD_NS));
+        }
+        while (nowNanoseconds() < deadline) {
+            ENGINE_CPU_RELAX();
+        }
+    }
+
+    void FramePacer::endFrame() {
+        if (frameInterval != 0 && lastFrameEnd != 0 && !idle) {
+            waitUntil(lastFrameEnd + frameInterval);
+        }
+        uint64_t now = nowNanoseconds();
+        if (lastFrameEnd != 0 && !idle) {
+            modeStats[(int)vsync].add(nanosecondsToMilliseconds(now - lastFrameEnd));
+        }
+        lastFrameEnd = now;
+    }
+
+    uint64_t FramePacer::remainingNanoseconds() const {
+        if (frameInterval == 0 || lastFrameEnd == 0 || idle) {
+            return 0;
+        }
+        uint64_t deadline = lastFrameEnd + frameInterval;
+        uint64_t now = nowNanoseconds();
+        return now < deadline ? deadline - now : 0;
+    }
+
+    bool FramePacer::pollEvents() {
+        bool iconified = window && glfwGetWindowAttrib(window, GLFW_ICONIFIED);
+        bool focused = !window || glfwGetWindowAttrib(window, GLFW_FOCUSED);
+        bool wasIdle = idle;
+        idle = settings.throttleWhenIdle && (iconified || !focused);
+
+        if (!idle) {
+            glfwPollEvents();
+            if (wasIdle) {
+                lastFrameEnd = 0;
+            }
+            return true;
+        }
+
+        // sleep in the event wait instead of spinning, any input wakes us up right away
+        double idleInterval = settings.idleFps > 0.0 ? 1.0 / settings.idleFps : 0.1;
+        double elapsed = lastFrameEnd ? nanosecondsToSeconds(nowNanoseconds() - lastFrameEnd) : 0.0;
+        if (elapsed < idleInterval) {
+            glfwWaitEventsTimeout(idleInterval - elapsed);
+        } else {
+            glfwPollEvents();
+        }
+        return !iconified;
+    }
+
+    void FramePacer::printStats() const {
+        for (int i = 0; i < (int)VsyncMode::Count; i++) {
+            const FrameTimeStats& stats = modeStats[i];
+            if (stats.frames == 0) {
+                continue;
+            }
+            printf("vsync %-8s frames %llu, mean %.3fms, stddev %.3fms, variance %.4fms^2, min %.3fms, max %.3fms\n",
+                vsyncModeName((VsyncMode)i), (unsigned long long)stats.frames, stats.meanMs, stats.standardDeviation(),
+                stats.variance(), stats.minMs, stats.maxMs);
+        }
+    }
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,46 @@
+#include "engine/core/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Engine {
+namespace Core {
+
+    bool MappedFile::open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        // mmap refuses zero length mappings, an empty file is still a valid file
+        if (info.st_size > 0) {
+            void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+            bytes = static_cast<const char*>(mapping);
+            byteCount = (size_t)info.st_size;
+        }
+        // the mapping keeps the file referenced on its own
+        ::close(fd);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (bytes) {
+            munmap(const_cast<char*>(bytes), byteCount);
+        }
+        bytes = nullptr;
+        byteCount = 0;
+    }
+
+} // namespace Core
+} // namespace Engine
@@ -0,0 +1,99 @@
+#include "engine/ecs/archetype.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Engine {
+namespace ECS {
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    Archetype::Archetype(uint32_t id, const ComponentMask& mask, Memory::Allocator& allocator)
+        : id(id), mask(mask), chunkCapacity(0), entityCount(0), allocator(&allocator) {
+        addEdges.fill(nullptr);
+        removeEdges.fill(nullptr);
+        columnLookup.fill(-1);
+
+        size_t bytesPerEntity = sizeof(Entity);
+        for (ComponentId id = 0; id < MAX_COMPONENTS; id++) {
+            if (!mask.test(id)) {
+                continue;
+            }
+            columnLookup[id] = (int16_t)components.size();
+            components.push_back(id);
+            columnSizes.push_back((uint32_t)getComponentInfo(id).size);
+            bytesPerEntity += getComponentInfo(id).size;
+        }
+
+        // start from the ideal capacity and shrink until the padded columns fit in the chunk
+        uint32_t capacity = (uint32_t)(CHUNK_SIZE / bytesPerEntity);
+        columnOffsets.resize(components.size());
+        for (; capacity > 0; capacity--) {
+            size_t offset = alignUp(sizeof(Entity) * capacity, COLUMN_ALIGNMENT);
+            for (size_t c = 0; c < components.size(); c++) {
+                columnOffsets[c] = (uint32_t)offset;
+                offset = alignUp(offset + (size_t)columnSizes[c] * capacity, COLUMN_ALIGNMENT);
+            }
+            if (offset <= CHUNK_SIZE) {
+                break;
+            }
+        }
+        // a combination of components that doesn't fit once would be written past the chunk
+        if (capacity == 0) {
+            fprintf(stderr, "ECS archetype of %zu components needs %zu bytes per entity, more than a %zu byte chunk\n",
+                    components.size(), bytesPerEntity, CHUNK_SIZE);
+            abort();
+        }
+        chunkCapacity = capacity;
+    }
+
+    Archetype::~Archetype() {
+        for (Chunk& chunk : chunks) {
+            allocator->deallocate(chunk.data, CHUNK_SIZE, COLUMN_ALIGNMENT);
+        }
+    }
+
+    void Archetype::pushEntity(Entity entity, uint32_t& chunk, uint32_t& row) {
+        if (chunks.empty() || chunks.back().count == chunkCapacity) {
+            Chunk newChunk;
+            newChunk.data = static_cast<unsigned char*>(allocator->allocate(CHUNK_SIZE, COLUMN_ALIGNMENT));
+            newChunk.count = 0;
+            chunks.push_back(newChunk);
+        }
+        chunk = (uint32_t)chunks.size() - 1;
+        row = chunks.back().count++;
+        entities(chunk)[row] = entity;
+        entityCount++;
+    }
+
+    Entity Archetype::removeEntity(uint32_t chunk, uint32_t row) {
+        uint32_t lastChunk = (uint32_t)chunks.size() - 1;
+        uint32_t lastRow = chunks[lastChunk].count - 1;
+        Entity moved = NULL_ENTITY;
+
+        // keep every chunk but the last one full by filling the hole with the very last entity
+        if (chunk != lastChunk || row != lastRow) {
+            for (size_t c = 0; c < components.size(); c++) {
+                std::memcpy(component(chunk, row, (int)c), component(lastChunk, lastRow, (int)c), columnSizes[c]);
+            }
+            moved = entities(lastChunk)[lastRow];
+            entities(chunk)[row] = moved;
+        }
+
+        chunks[lastChunk].count--;
+        entityCount--;
+
+        // the last chunk is the only one that can be partially filled, drop it once it empties
+        // so removals always find the tail entity in chunks.back()
+        if (chunks[lastChunk].count == 0 && lastChunk > 0) {
+            allocator->deallocate(chunks[lastChunk].data, CHUNK_SIZE, COLUMN_ALIGNMENT);
+            chunks.pop_back();
+        }
+        return moved;
+    }
+
+} // namespace ECS
+} // namespace Engine
@@ -0,0 +1,54 @@
+#include "engine/ecs/component.hpp"
+
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace Engine {
+namespace ECS {
+
+    static std::mutex registryMutex;
+    static std::vector<ComponentInfo>& registry() {
+        // reserved up front so references from getComponentInfo never dangle
+        static std::vector<ComponentInfo> infos = [] {
+            std::vector<ComponentInfo> v;
+            v.reserve(MAX_COMPONENTS);
+            return v;
+        }();
+        return infos;
+    }
+
+    ComponentId registerComponent(size_t size, size_t alignment, const char* name) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::vector<ComponentInfo>& infos = registry();
+        if (infos.size() >= MAX_COMPONENTS) {
+            fprintf(stderr, "Too many ECS component types (max %zu), failed to register %s\n", MAX_COMPONENTS, name);
+            abort();
+        }
+        if (alignment > COLUMN_ALIGNMENT) {
+            fprintf(stderr, "ECS component %s needs %zu byte alignment, columns are only %zu byte aligned\n", name,
+                    alignment, COLUMN_ALIGNMENT);
+            abort();
+        }
+        // one entity handle in front of the column, both padded to the column alignment
+        if (COLUMN_ALIGNMENT + ((size + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1)) > CHUNK_SIZE) {
+            fprintf(stderr, "ECS component %s is %zu bytes, too big for a %zu byte chunk\n", name, size, CHUNK_SIZE);
+            abort();
+        }
+        infos.push_back(ComponentInfo{size, alignment, name});
+        return (ComponentId)(infos.size() - 1);
+    }
+
+    const ComponentInfo& getComponentInfo(ComponentId id) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return registry()[id];
+    }
+
+    size_t getComponentCount() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return registry().size();
+    }
+
+} // namespace ECS
+} // namespace Engine
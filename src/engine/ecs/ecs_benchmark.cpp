@@ -0,0 +1,120 @@
+#include "engine/ecs/ecs_benchmark.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/ecs/system_scheduler.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/scene/components.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace Engine {
+namespace ECS {
+
+    namespace {
+
+        const float ITERATION_BENCH_DT = 1.0f / 60.0f;
+
+        // position read and written, velocity read
+        const double BYTES_PER_ENTITY = 3.0 * sizeof(glm::vec3);
+
+        // best of `iterations` runs, the first one is a warmup that faults the memory in
+        template<typename Fn>
+        uint64_t bestNanoseconds(uint32_t iterations, Fn&& fn) {
+            fn();
+            uint64_t best = UINT64_MAX;
+            for (uint32_t i = 0; i < iterations; i++) {
+                uint64_t start = Core::nowNanoseconds();
+                fn();
+                best = std::min(best, Core::nowNanoseconds() - start);
+            }
+            return best;
+        }
+
+        void printRow(const char* name, uint64_t nanoseconds, uint32_t entities) {
+            printf("  %-12s %10.3f %10.3f %10.2f\n", name, Core::nanosecondsToMilliseconds(nanoseconds),
+                   (double)nanoseconds / entities, BYTES_PER_ENTITY * entities / (double)nanoseconds);
+        }
+
+        const uint32_t SCHEDULER_CHECK_ENTITIES = 20000;
+        const uint32_t SCHEDULER_CHECK_FRAMES = 50;
+
+        // two systems that don't conflict, so they run side by side on the workers, each
+        // iterating a component set nobody queried before. their queries have to be made by
+        // the scheduler up front, a query made from inside a running system would race
+        bool checkSchedulerQueries() {
+            World world;
+            for (uint32_t i = 0; i < SCHEDULER_CHECK_ENTITIES; i++) {
+                world.create(Scene::Position{glm::vec3(0.0f)}, Scene::Velocity{glm::vec3(1.0f, 0.0f, 0.0f)},
+                             Scene::PreviousPosition{glm::vec3(0.0f)});
+            }
+            Jobs::JobSystem jobs(2);
+            SystemScheduler scheduler(jobs);
+            scheduler.addSystem("check movement", Reads<Scene::Velocity>(), Writes<Scene::Position>(), [](SystemContext& context) {
+                float dt = context.deltaTime;
+                context.parallelEach<Scene::Position, Scene::Velocity>([dt](Scene::Position& position, Scene::Velocity& velocity) {
+                    position.value += velocity.value * dt;
+                }, 1);
+            });
+            scheduler.addSystem("check counter", Reads<>(), Writes<Scene::PreviousPosition>(), [](SystemContext& context) {
+                context.parallelEach<Scene::PreviousPosition>([](Scene::PreviousPosition& previous) {
+                    previous.value.y += 1.0f;
+                }, 1);
+            });
+            for (uint32_t frame = 0; frame < SCHEDULER_CHECK_FRAMES; frame++) {
+                scheduler.run(world, 1.0f);
+            }
+
+            uint32_t wrong = 0;
+            world.each<Scene::Position, Scene::PreviousPosition>([&](Scene::Position& position, Scene::PreviousPosition& previous) {
+                if (position.value.x != (float)SCHEDULER_CHECK_FRAMES || previous.value.y != (float)SCHEDULER_CHECK_FRAMES) {
+                    wrong++;
+                }
+            });
+            if (wrong > 0) {
+                fprintf(stderr, "ecs scheduler check: %u of %u entities missed updates\n", wrong, SCHEDULER_CHECK_ENTITIES);
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace
+
+    void runIterationBenchmark(uint32_t entities, uint32_t iterations) {
+        if (!checkSchedulerQueries()) {
+            return;
+        }
+        World world;
+        std::vector<glm::vec3> positions(entities);
+        std::vector<glm::vec3> velocities(entities);
+        for (uint32_t i = 0; i < entities; i++) {
+            glm::vec3 position((float)(i % 1000), (float)(i / 1000), 0.0f);
+            glm::vec3 velocity(1.0f, 0.5f, 0.25f);
+            world.create(Scene::Position{position}, Scene::Velocity{velocity});
+            positions[i] = position;
+            velocities[i] = velocity;
+        }
+        Query& query = world.query<Scene::Position, Scene::Velocity>();
+
+        uint64_t arrays = bestNanoseconds(iterations, [&] {
+            glm::vec3* p = positions.data();
+            const glm::vec3* v = velocities.data();
+            for (uint32_t i = 0; i < entities; i++) {
+                p[i] += v[i] * ITERATION_BENCH_DT;
+            }
+        });
+        uint64_t chunks = bestNanoseconds(iterations, [&] {
+            query.each<Scene::Position, Scene::Velocity>([](Scene::Position& position, Scene::Velocity& velocity) {
+                position.value += velocity.value * ITERATION_BENCH_DT;
+            });
+        });
+
+        printf("ecs iteration benchmark, %u entities, best of %u\n", entities, iterations);
+        printf("  %-12s %10s %10s %10s\n", "", "ms", "ns/entity", "GB/s");
+        printRow("plain arrays", arrays, entities);
+        printRow("ecs query", chunks, entities);
+        printf("  ecs query at %.0f%% of the plain array throughput\n", 100.0 * (double)arrays / (double)chunks);
+    }
+
+} // namespace ECS
+} // namespace Engine
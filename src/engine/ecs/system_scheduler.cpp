@@ -0,0 +1,188 @@
+#include "engine/ecs/system_scheduler.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace Engine {
+namespace ECS {
+
+    static bool conflicts(const SystemDesc& a, const SystemDesc& b) {
+        return (a.writes & (b.reads | b.writes)).any() || (a.reads & b.writes).any();
+    }
+
+    SystemScheduler::SystemScheduler(Jobs::JobSystem& jobs)
+        : jobs(jobs), graphDirty(true), queryWorld(nullptr), frameWorld(nullptr), frameDeltaTime(0.0f), frameAllocator(nullptr), systemsLeft(0) {
+        stats.wallMs = 0.0;
+        stats.criticalPathMs = 0.0;
+    }
+
+    uint32_t SystemScheduler::addSystem(const SystemDesc& desc) {
+        nodes.push_back(std::make_unique<SystemNode>());
+        nodes.back()->desc = desc;
+        graphDirty = true;
+        return (uint32_t)(nodes.size() - 1);
+    }
+
+    // the graph only depends on the registered systems so it is rebuilt when they change,
+    // registration order is a valid topological order because edges always point forward
+    void SystemScheduler::buildGraph() {
+        for (std::unique_ptr<SystemNode>& node : nodes) {
+            node->successors.clear();
+            node->predecessors.clear();
+        }
+        for (uint32_t j = 0; j < nodes.size(); j++) {
+            for (uint32_t i = 0; i < j; i++) {
+                if (conflicts(nodes[i]->desc, nodes[j]->desc)) {
+                    nodes[i]->successors.push_back(j);
+                    nodes[j]->predecessors.push_back(i);
+                }
+            }
+        }
+        stats.systems.resize(nodes.size());
+        mainThreadReady.reserve(nodes.size());
+        graphDirty = false;
+        queryWorld = nullptr;
+    }
+
+    // World::getQuery isn't safe to call while systems run on several threads, so the queries
+    // systems iterate are made here, once per world and registered system set
+    void SystemScheduler::resolveQueries(World& world) {
+        for (std::unique_ptr<SystemNode>& node : nodes) {
+            ComponentMask access = node->desc.reads | node->desc.writes;
+            node->query = access.any() ? &world.getQuery(access) : nullptr;
+        }
+        queryWorld = &world;
+    }
+
+    void SystemScheduler::runJob(void* data, uint32_t begin, uint32_t) {
+        static_cast<SystemScheduler*>(data)->execute(begin);
+    }
+
+    void SystemScheduler::schedule(uint32_t index) {
+        if (nodes[index]->desc.mainThread) {
+            std::lock_guard<std::mutex> lock(mainThreadMutex);
+            mainThreadReady.push_back(index);
+            return;
+        }
+        jobs.submit(Jobs::Job{runJob, this, index, index + 1, nullptr});
+    }
+
+    void SystemScheduler::execute(uint32_t index) {
+        SystemNode& node = *nodes[index];
+        // nodes are heap allocated and never move, the name outlives any trace
+        PROFILE_SCOPE(node.desc.name.c_str());
+        auto start = std::chrono::steady_clock::now();
+
+        SystemContext context{*frameWorld, jobs, frameDeltaTime, node.chunks, frameAllocator, node.query};
+        node.desc.function(context);
+
+        auto end = std::chrono::steady_clock::now();
+        SystemTiming& timing = stats.systems[index];
+        timing.startMs = std::chrono::duration<double, std::milli>(start - frameStart).count();
+        timing.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+        timing.thread = Jobs::JobSystem::threadIndex();
+
+        for (uint32_t successor : node.successors) {
+            if (nodes[successor]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule(successor);
+            }
+        }
+        systemsLeft.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void SystemScheduler::run(World& world, float deltaTime) {
+        if (nodes.empty()) {
+            return;
+        }
+        if (graphDirty) {
+            buildGraph();
+        }
+        if (queryWorld != &world) {
+            resolveQueries(world);
+        }
+        world.setQueriesLocked(true);
+
+        frameWorld = &world;
+        frameDeltaTime = deltaTime;
+        frameStart = std::chrono::steady_clock::now();
+        systemsLeft.store((uint32_t)nodes.size(), std::memory_order_relaxed);
+        for (std::unique_ptr<SystemNode>& node : nodes) {
+            node->remaining.store((uint32_t)node->predecessors.size(), std::memory_order_relaxed);
+        }
+        for (uint32_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i]->predecessors.empty()) {
+                schedule(i);
+            }
+        }
+
+        // the calling thread owns the main thread systems and helps with worker jobs otherwise
+        while (systemsLeft.load(std::memory_order_acquire) != 0) {
+            uint32_t index = UINT32_MAX;
+            {
+                std::lock_guard<std::mutex> lock(mainThreadMutex);
+                if (!mainThreadReady.empty()) {
+                    index = mainThreadReady.back();
+                    mainThreadReady.pop_back();
+                }
+            }
+            if (index != UINT32_MAX) {
+                execute(index);
+            } else if (!jobs.tryRunOne()) {
+                std::this_thread::yield();
+            }
+        }
+
+        world.setQueriesLocked(false);
+        stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        computeCriticalPath();
+    }
+
+    // longest chain of dependent systems by measured duration, this is the lower bound on the
+    // frame no matter how many workers there are
+    void SystemScheduler::computeCriticalPath() {
+        size_t count = nodes.size();
+        std::vector<double>& finish = criticalFinish;
+        std::vector<uint32_t>& previous = criticalPrevious;
+        finish.assign(count, 0.0);
+        previous.assign(count, UINT32_MAX);
+
+        uint32_t last = 0;
+        for (uint32_t j = 0; j < count; j++) {
+            double longest = 0.0;
+            for (uint32_t i : nodes[j]->predecessors) {
+                if (finish[i] > longest) {
+                    longest = finish[i];
+                    previous[j] = i;
+                }
+            }
+            finish[j] = longest + stats.systems[j].durationMs;
+            if (finish[j] > finish[last]) {
+                last = j;
+            }
+        }
+
+        stats.criticalPathMs = finish[last];
+        stats.criticalPath.clear();
+        for (uint32_t i = last; i != UINT32_MAX; i = previous[i]) {
+            stats.criticalPath.push_back(i);
+        }
+        std::reverse(stats.criticalPath.begin(), stats.criticalPath.end());
+    }
+
+    std::string SystemScheduler::criticalPathString() const {
+        std::string result;
+        char buffer[64];
+        for (uint32_t index : stats.criticalPath) {
+            if (!result.empty()) {
+                result += " -> ";
+            }
+            snprintf(buffer, sizeof(buffer), " (%.3fms)", stats.systems[index].durationMs);
+            result += nodes[index]->desc.name;
+            result += buffer;
+        }
+        return result;
+    }
+
+} // namespace ECS
+} // namespace Engine
@@ -0,0 +1,133 @@
+#include "engine/ecs/world.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Engine {
+namespace ECS {
+
+    World::World(Memory::Allocator& allocator) : aliveCount(0), allocator(allocator), queriesLocked(false) {
+        emptyArchetype = getArchetype(ComponentMask());
+    }
+
+    World::~World() {
+    }
+
+    Entity World::allocateEntity() {
+        Entity entity;
+        if (!freeIndices.empty()) {
+            entity.index = freeIndices.back();
+            freeIndices.pop_back();
+        } else {
+            entity.index = (uint32_t)records.size();
+            records.push_back(EntityRecord{nullptr, 0, 0, 0});
+        }
+        entity.generation = records[entity.index].generation;
+        aliveCount++;
+        return entity;
+    }
+
+    Entity World::create() {
+        Entity entity = allocateEntity();
+        EntityRecord& record = records[entity.index];
+        record.archetype = emptyArchetype;
+        emptyArchetype->pushEntity(entity, record.chunk, record.row);
+        return entity;
+    }
+
+    void World::destroy(Entity entity) {
+        if (!isAlive(entity)) {
+            return;
+        }
+        EntityRecord& record = records[entity.index];
+        removeFromArchetype(record);
+        record.archetype = nullptr;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+        aliveCount--;
+    }
+
+    void World::removeFromArchetype(EntityRecord& record) {
+        Entity moved = record.archetype->removeEntity(record.chunk, record.row);
+        if (!moved.isNull()) {
+            records[moved.index].chunk = record.chunk;
+            records[moved.index].row = record.row;
+        }
+    }
+
+    void World::moveEntity(Entity entity, Archetype* target) {
+        EntityRecord& record = records[entity.index];
+        Archetype* source = record.archetype;
+
+        uint32_t chunk, row;
+        target->pushEntity(entity, chunk, row);
+
+        // copy every column the two archetypes share, both column lists are sorted by id
+        size_t s = 0, t = 0;
+        while (s < source->components.size() && t < target->components.size()) {
+            if (source->components[s] == target->components[t]) {
+                std::memcpy(target->component(chunk, row, (int)t), source->component(record.chunk, record.row, (int)s), source->columnSizes[s]);
+                s++;
+                t++;
+            } else if (source->components[s] < target->components[t]) {
+                s++;
+            } else {
+                t++;
+            }
+        }
+
+        removeFromArchetype(record);
+        record.archetype = target;
+        record.chunk = chunk;
+        record.row = row;
+    }
+
+    Archetype* World::getArchetype(const ComponentMask& mask) {
+        auto found = archetypeLookup.find(mask);
+        if (found != archetypeLookup.end()) {
+            return found->second;
+        }
+        if (queriesLocked) {
+            fprintf(stderr, "ecs: archetype created while systems are running, structural changes have to wait for the scheduler\n");
+            abort();
+        }
+
+        archetypes.push_back(std::make_unique<Archetype>((uint32_t)archetypes.size(), mask, allocator));
+        Archetype* archetype = archetypes.back().get();
+        archetypeLookup[mask] = archetype;
+
+        for (std::unique_ptr<Query>& query : queries) {
+            if ((mask & query->mask) == query->mask) {
+                query->archetypes.push_back(archetype);
+            }
+        }
+        return archetype;
+    }
+
+    Query& World::getQuery(const ComponentMask& mask) {
+        auto found = queryLookup.find(mask);
+        if (found != queryLookup.end()) {
+            return *found->second;
+        }
+        if (queriesLocked) {
+            fprintf(stderr, "ecs: query created while systems are running, iterate the components the system declares "
+                            "or make the query before SystemScheduler::run\n");
+            abort();
+        }
+
+        queries.push_back(std::make_unique<Query>(mask));
+        Query* query = queries.back().get();
+        queryLookup[mask] = query;
+
+        for (std::unique_ptr<Archetype>& archetype : archetypes) {
+            if ((archetype->mask & mask) == mask) {
+                query->archetypes.push_back(archetype.get());
+            }
+        }
+        return *query;
+    }
+
+} // namespace ECS
+} // namespace Engine
@@ -0,0 +1,242 @@
+#include "engine/input/input.hpp"
+#include "engine/core/clock.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include <stdio.h>
+
+namespace Engine {
+namespace Input {
+
+    static InputSystem* fromWindow(GLFWwindow* window) {
+        return static_cast<InputSystem*>(glfwGetWindowUserPointer(window));
+    }
+
+    static void keyCallback(GLFWwindow* window, int key, int, int action, int) {
+        fromWindow(window)->push(Event{Core::nowNanoseconds(), EventType::Key, key, action, 0.0, 0.0});
+    }
+
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int) {
+        fromWindow(window)->push(Event{Core::nowNanoseconds(), EventType::MouseButton, button, action, 0.0, 0.0});
+    }
+
+    static void cursorPositionCallback(GLFWwindow* window, double x, double y) {
+        fromWindow(window)->push(Event{Core::nowNanoseconds(), EventType::CursorPosition, 0, 0, x, y});
+    }
+
+    static void scrollCallback(GLFWwindow* window, double x, double y) {
+        fromWindow(window)->push(Event{Core::nowNanoseconds(), EventType::Scroll, 0, 0, x, y});
+    }
+
+    static void charCallback(GLFWwindow* window, unsigned int codepoint) {
+        fromWindow(window)->push(Event{Core::nowNanoseconds(), EventType::Char, (int)codepoint, 0, 0.0, 0.0});
+    }
+
+    InputSystem::InputSystem()
+        : cursorX(0.0), cursorY(0.0), deltaX(0.0), deltaY(0.0), scrollX(0.0), scrollY(0.0),
+          haveCursor(false), oldestAge(0), dropped(0) {
+        events.reserve(QUEUE_CAPACITY);
+    }
+
+    void InputSystem::attach(GLFWwindow* window) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, keyCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetCursorPosCallback(window, cursorPositionCallback);
+        glfwSetScrollCallback(window, scrollCallback);
+        glfwSetCharCallback(window, charCallback);
+
+        // unaccelerated, unscaled motion straight from the device, only applies while the
+        // cursor is disabled
+        if (glfwRawMouseMotionSupported()) {
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+        }
+    }
+
+    void InputSystem::push(const Event& event) {
+        if (!queue.push(event)) {
+            dropped++;
+        }
+    }
+
+    void InputSystem::applyButton(int code, bool mouseButton, bool down) {
+        bool wasDown = mouseButton ? buttons.test(code) : keys.test(code);
+        if (wasDown == down) {
+            return;
+        }
+        for (const Binding& binding : bindings) {
+            if (binding.code != code || binding.mouseButton != mouseButton) {
+                continue;
+            }
+            // another key bound to the same action may already hold it down
+            bool held = false;
+            for (const Binding& other : bindings) {
+                bool same = other.code == code && other.mouseButton == mouseButton;
+                if (other.action == binding.action && !same && isBindingDown(other)) {
+                    held = true;
+                    break;
+                }
+            }
+            if (!held) {
+                if (down) {
+                    actionPressed.set(binding.action);
+                } else {
+                    actionReleased.set(binding.action);
+                }
+            }
+        }
+        if (mouseButton) {
+            buttons.set(code, down);
+        } else {
+            keys.set(code, down);
+        }
+    }
+
+    void InputSystem::update() {
+        actionPressed.reset();
+        actionReleased.reset();
+        deltaX = 0.0;
+        deltaY = 0.0;
+        scrollX = 0.0;
+        scrollY = 0.0;
+        oldestAge = 0;
+
+        events.clear();
+        Event event;
+        uint64_t now = Core::nowNanoseconds();
+        while (queue.pop(event)) {
+            if (events.empty()) {
+                oldestAge = now - event.timestamp;
+            }
+            events.push_back(event);
+
+            switch (event.type) {
+                case EventType::Key:
+                    if (event.code >= 0 && event.code < KEY_COUNT && event.action != GLFW_REPEAT) {
+                        applyButton(event.code, false, event.action == GLFW_PRESS);
+                    }
+                    break;
+                case EventType::MouseButton:
+                    if (event.code >= 0 && event.code < MOUSE_BUTTON_COUNT) {
+                        applyButton(event.code, true, event.action == GLFW_PRESS);
+                    }
+                    break;
+                case EventType::CursorPosition:
+                    // all motion of the frame collapses into one delta, the first position
+                    // only establishes where the cursor is
+                    if (haveCursor) {
+                        deltaX += event.x - cursorX;
+                        deltaY += event.y - cursorY;
+                    }
+                    haveCursor = true;
+                    cursorX = event.x;
+                    cursorY = event.y;
+                    break;
+                case EventType::Scroll:
+                    scrollX += event.x;
+                    scrollY += event.y;
+                    break;
+                case EventType::Char:
+                    break;
+            }
+        }
+
+        actionDown.reset();
+        for (const Binding& binding : bindings) {
+            if (isBindingDown(binding)) {
+                actionDown.set(binding.action);
+            }
+        }
+
+        for (Axis& axis : axes) {
+            axis.value = 0.0f;
+        }
+        for (const AxisBinding& binding : axisBindings) {
+            float value = 0.0f;
+            if (binding.mouse) {
+                switch (binding.mouseAxis) {
+                    case MouseAxis::X: value = (float)deltaX; break;
+                    case MouseAxis::Y: value = (float)deltaY; break;
+                    case MouseAxis::ScrollX: value = (float)scrollX; break;
+                    case MouseAxis::ScrollY: value = (float)scrollY; break;
+                }
+            } else {
+                if (binding.positiveKey >= 0 && keys.test(binding.positiveKey)) {
+                    value += 1.0f;
+                }
+                if (binding.negativeKey >= 0 && keys.test(binding.negativeKey)) {
+                    value -= 1.0f;
+                }
+            }
+            axes[binding.axis].value += value * binding.scale;
+        }
+    }
+
+    ActionId InputSystem::addAction(const std::string& name) {
+        ActionId existing = findAction(name);
+        if (existing != UINT32_MAX) {
+            return existing;
+        }
+        if (actionNames.size() >= MAX_ACTIONS) {
+            fprintf(stderr, "Too many input actions, can't add %s\n", name.c_str());
+            return UINT32_MAX;
+        }
+        actionNames.push_back(name);
+        return (ActionId)(actionNames.size() - 1);
+    }
+
+    void InputSystem::bindKey(ActionId action, int key) {
+        if (action < actionNames.size() && key >= 0 && key < KEY_COUNT) {
+            bindings.push_back(Binding{action, key, false});
+        }
+    }
+
+    void InputSystem::bindMouseButton(ActionId action, int button) {
+        if (action < actionNames.size() && button >= 0 && button < MOUSE_BUTTON_COUNT) {
+            bindings.push_back(Binding{action, button, true});
+        }
+    }
+
+    ActionId InputSystem::findAction(const std::string& name) const {
+        for (size_t i = 0; i < actionNames.size(); i++) {
+            if (actionNames[i] == name) {
+                return (ActionId)i;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    AxisId InputSystem::addAxis(const std::string& name) {
+        AxisId existing = findAxis(name);
+        if (existing != UINT32_MAX) {
+            return existing;
+        }
+        axes.push_back(Axis{name, 0.0f});
+        return (AxisId)(axes.size() - 1);
+    }
+
+    void InputSystem::bindKeyAxis(AxisId axis, int positiveKey, int negativeKey, float scale) {
+        if (axis < axes.size()) {
+            positiveKey = positiveKey >= 0 && positiveKey < KEY_COUNT ? positiveKey : -1;
+            negativeKey = negativeKey >= 0 && negativeKey < KEY_COUNT ? negativeKey : -1;
+            axisBindings.push_back(AxisBinding{axis, positiveKey, negativeKey, false, MouseAxis::X, scale});
+        }
+    }
+
+    void InputSystem::bindMouseAxis(AxisId axis, MouseAxis mouseAxis, float scale) {
+        if (axis < axes.size()) {
+            axisBindings.push_back(AxisBinding{axis, -1, -1, true, mouseAxis, scale});
+        }
+    }
+
+    AxisId InputSystem::findAxis(const std::string& name) const {
+        for (size_t i = 0; i < axes.size(); i++) {
+            if (axes[i].name == name) {
+                return (AxisId)i;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+} // namespace Input
+} // namespace Engine
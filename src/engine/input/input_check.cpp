@@ -0,0 +1,78 @@
+#include "engine/input/input.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include <stdio.h>
+
+namespace Engine {
+namespace Input {
+
+    namespace {
+
+        struct Expected {
+            bool down;
+            bool pressed;
+            bool released;
+        };
+
+        bool expect(const InputSystem& input, ActionId action, const char* what, Expected expected) {
+            bool down = input.isDown(action);
+            bool pressed = input.wasPressed(action);
+            bool released = input.wasReleased(action);
+            if (down == expected.down && pressed == expected.pressed && released == expected.released) {
+                return true;
+            }
+            fprintf(stderr, "input check: %s: down %d pressed %d released %d, expected %d %d %d\n", what,
+                    down, pressed, released, expected.down, expected.pressed, expected.released);
+            return false;
+        }
+
+        void key(InputSystem& input, int code, int action) {
+            input.push(Event{0, EventType::Key, code, action, 0.0, 0.0});
+        }
+
+    } // namespace
+
+    bool runInputCheck() {
+        InputSystem input;
+        ActionId jump = input.addAction("jump");
+        input.bindKey(jump, GLFW_KEY_SPACE);
+        input.bindMouseButton(jump, GLFW_MOUSE_BUTTON_LEFT);
+        bool ok = true;
+
+        // a tap shorter than a frame
+        key(input, GLFW_KEY_SPACE, GLFW_PRESS);
+        key(input, GLFW_KEY_SPACE, GLFW_RELEASE);
+        input.update();
+        ok &= expect(input, jump, "tap within one frame", {false, true, true});
+        input.update();
+        ok &= expect(input, jump, "frame after the tap", {false, false, false});
+
+        // held over several frames, repeats don't press again
+        key(input, GLFW_KEY_SPACE, GLFW_PRESS);
+        input.update();
+        ok &= expect(input, jump, "press", {true, true, false});
+        key(input, GLFW_KEY_SPACE, GLFW_REPEAT);
+        input.update();
+        ok &= expect(input, jump, "key repeat", {true, false, false});
+
+        // a second binding of the same action neither presses nor releases it while held
+        input.push(Event{0, EventType::MouseButton, GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0.0, 0.0});
+        input.push(Event{0, EventType::MouseButton, GLFW_MOUSE_BUTTON_LEFT, GLFW_RELEASE, 0.0, 0.0});
+        input.update();
+        ok &= expect(input, jump, "click while the key is held", {true, false, false});
+
+        // release then press again inside one frame ends down, with both edges seen
+        key(input, GLFW_KEY_SPACE, GLFW_RELEASE);
+        key(input, GLFW_KEY_SPACE, GLFW_PRESS);
+        input.update();
+        ok &= expect(input, jump, "release and press within one frame", {true, true, true});
+
+        key(input, GLFW_KEY_SPACE, GLFW_RELEASE);
+        input.update();
+        ok &= expect(input, jump, "release", {false, false, true});
+        return ok;
+    }
+
+} // namespace Input
+} // namespace Engine
@@ -0,0 +1,119 @@
+#include "engine/jobs/job_system.hpp"
+#include "engine/profiler/profiler.hpp"
+#include "engine/core/clock.hpp"
+
+#include <stdio.h>
+
+namespace Engine {
+namespace Jobs {
+
+    static thread_local unsigned int currentThreadIndex = 0;
+
+    JobSystem::JobSystem(unsigned int workerCount) : queue(QUEUE_CAPACITY), queueHead(0), queueSize(0), running(true) {
+        if (workerCount == 0) {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            workerCount = hardware > 1 ? hardware - 1 : 1;
+        }
+        busy.reset(new std::atomic<uint64_t>[workerCount + 1]);
+        for (unsigned int i = 0; i <= workerCount; i++) {
+            busy[i].store(0, std::memory_order_relaxed);
+        }
+        for (unsigned int i = 0; i < workerCount; i++) {
+            workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            running = false;
+        }
+        queueCondition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    unsigned int JobSystem::threadIndex() {
+        return currentThreadIndex;
+    }
+
+    void JobSystem::submit(const Job& job) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (queueSize < QUEUE_CAPACITY) {
+                queue[(queueHead + queueSize) % QUEUE_CAPACITY] = job;
+                queueSize++;
+                lock.unlock();
+                queueCondition.notify_one();
+                return;
+            }
+        }
+        // queue is full, running it inline is always correct and keeps submit allocation free
+        execute(job);
+    }
+
+    bool JobSystem::pop(Job& job) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queueSize == 0) {
+            return false;
+        }
+        job = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+        queueSize--;
+        return true;
+    }
+
+    void JobSystem::execute(const Job& job) {
+        PROFILE_SCOPE("job");
+        uint64_t start = Core::nowNanoseconds();
+        job.function(job.data, job.begin, job.end);
+        // only the owning thread writes its counter, relaxed is enough
+        busy[currentThreadIndex].fetch_add(Core::nowNanoseconds() - start, std::memory_order_relaxed);
+        if (job.counter) {
+            job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    bool JobSystem::tryRunOne() {
+        Job job;
+        if (!pop(job)) {
+            return false;
+        }
+        execute(job);
+        return true;
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        while (counter.pending.load(std::memory_order_acquire) != 0) {
+            if (!tryRunOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::workerLoop(unsigned int index) {
+        currentThreadIndex = index;
+#ifdef ENGINE_PROFILING
+        char name[32];
+        snprintf(name, sizeof(name), "worker %u", index);
+        PROFILE_THREAD_NAME(name);
+#endif
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueCondition.wait(lock, [this] { return queueSize > 0 || !running; });
+                if (!running && queueSize == 0) {
+                    return;
+                }
+                job = queue[queueHead];
+                queueHead = (queueHead + 1) % QUEUE_CAPACITY;
+                queueSize--;
+            }
+            execute(job);
+        }
+    }
+
+} // namespace Jobs
+} // namespace Engine
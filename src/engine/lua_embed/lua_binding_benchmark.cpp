@@ -0,0 +1,156 @@
+#include "engine/lua_embed/lua_renderer_bindings.hpp"
+#include "engine/lua_embed/lua_binding.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/renderer/camera.hpp"
+
+#include <cstdio>
+
+namespace Engine {
+
+    namespace {
+
+        // the same loops run against all three camera objects, the FFI one only differs in how
+        // SetPose takes its position
+        const char* BINDING_BENCH_SCRIPT = R"lua(
+local ffi = require("ffi")
+
+function benchScroll(camera, n)
+    for i = 1, n do
+        camera:ProcessMouseScroll(0)
+    end
+end
+
+function benchPose(camera, n)
+    for i = 1, n do
+        camera:SetPose(i, 2, 3, -90, 0)
+    end
+end
+
+function benchPoseFfi(camera, n)
+    local position = ffi.new("vec3", 0, 2, 3)
+    for i = 1, n do
+        position.x = i
+        camera:SetPose(position, -90, 0)
+    end
+end
+
+function benchZoom(camera, n)
+    local sum = 0
+    for i = 1, n do
+        sum = sum + camera:Zoom()
+    end
+    return sum
+end
+
+function benchZoomFfi(camera, n)
+    local sum = 0
+    for i = 1, n do
+        sum = sum + camera.Zoom
+    end
+    return sum
+end
+)lua";
+
+        const char* HAND_CAMERA = "HandCamera";
+
+        // what a binding written by hand usually looks like: luaL_checkudata resolves the
+        // metatable by name on every call
+        Camera* handCamera(lua_State* L) {
+            return *static_cast<Camera**>(luaL_checkudata(L, 1, HAND_CAMERA));
+        }
+
+        int handProcessMouseScroll(lua_State* L) {
+            handCamera(L)->ProcessMouseScroll((float)luaL_checknumber(L, 2));
+            return 0;
+        }
+
+        int handSetPose(lua_State* L) {
+            Camera* camera = handCamera(L);
+            glm::vec3 position((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3), (float)luaL_checknumber(L, 4));
+            camera->SetPose(position, (float)luaL_checknumber(L, 5), (float)luaL_checknumber(L, 6));
+            return 0;
+        }
+
+        int handZoom(lua_State* L) {
+            lua_pushnumber(L, handCamera(L)->Zoom);
+            return 1;
+        }
+
+        void pushHandCamera(lua_State* L, Camera* camera) {
+            *static_cast<Camera**>(lua_newuserdata(L, sizeof(Camera*))) = camera;
+            if (luaL_newmetatable(L, HAND_CAMERA)) {
+                lua_newtable(L);
+                lua_pushcfunction(L, handProcessMouseScroll);
+                lua_setfield(L, -2, "ProcessMouseScroll");
+                lua_pushcfunction(L, handSetPose);
+                lua_setfield(L, -2, "SetPose");
+                lua_pushcfunction(L, handZoom);
+                lua_setfield(L, -2, "Zoom");
+                lua_setfield(L, -2, "__index");
+            }
+            lua_setmetatable(L, -2);
+        }
+
+        // calls function(camera, calls) after a warmup, returns nanoseconds per call
+        double bindingMeasure(LuaJIT& lua, const char* function, int cameraRef, uint32_t calls) {
+            lua_State* L = lua.state();
+            uint64_t elapsed = 0;
+            for (int pass = 0; pass < 2; pass++) {
+                uint64_t start = Core::nowNanoseconds();
+                lua_getglobal(L, function);
+                lua_rawgeti(L, LUA_REGISTRYINDEX, cameraRef);
+                lua_pushinteger(L, pass == 0 ? 1000 : calls);
+                if (!lua.call(2, 0)) {
+                    return 0.0;
+                }
+                elapsed = Core::nowNanoseconds() - start;
+            }
+            return (double)elapsed / calls;
+        }
+
+    } // namespace
+
+    void runLuaBindingBenchmark(uint32_t calls) {
+        ECS::World world;
+        LuaJIT lua;
+        if (!lua.init(world) || !bindRendererTypes(lua.state()) ||
+            !lua.runString(BINDING_BENCH_SCRIPT, "=lua binding benchmark")) {
+            return;
+        }
+        lua_State* L = lua.state();
+        Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+        pushHandCamera(L, &camera);
+        int handRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        LuaBind::pushObject(L, &camera);
+        int capiRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        LuaBind::pushCData(L, &camera);
+        int ffiRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        struct Row {
+            const char* name;
+            const char* capiFunction;
+            const char* ffiFunction;
+        };
+        const Row rows[] = {
+            {"ProcessMouseScroll(float)", "benchScroll", "benchScroll"},
+            {"SetPose(vec3, float, float)", "benchPose", "benchPoseFfi"},
+            {"Zoom field read", "benchZoom", "benchZoomFfi"},
+        };
+        printf("lua binding benchmark, %u calls per row, ns/call\n", calls);
+        printf("  %-30s %10s %10s %10s\n", "", "hand C API", "generated", "ffi");
+        for (const Row& row : rows) {
+            double hand = bindingMeasure(lua, row.capiFunction, handRef, calls);
+            double generated = bindingMeasure(lua, row.capiFunction, capiRef, calls);
+            double ffi = bindingMeasure(lua, row.ffiFunction, ffiRef, calls);
+            printf("  %-30s %10.2f %10.2f %10.2f\n", row.name, hand, generated, ffi);
+        }
+
+        luaL_unref(L, LUA_REGISTRYINDEX, handRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, capiRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, ffiRef);
+    }
+
+} // namespace Engine
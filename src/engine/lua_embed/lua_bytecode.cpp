@@ -0,0 +1,133 @@
+#include "engine/lua_embed/lua_bytecode.hpp"
+#include "engine/core/mapped_file.hpp"
+
+#include "lua.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace Engine {
+
+    uint64_t luaSourceHash(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string luaCookedPath(const std::string& cookedRoot, const std::string& relativePath) {
+        return cookedRoot + "/" + relativePath + LUA_COOKED_EXTENSION;
+    }
+
+    const char* luaCookedBytecode(const char* cooked, size_t cookedBytes, const void* source, size_t sourceBytes,
+                                  size_t& bytecodeBytes) {
+        LuaBytecodeHeader header;
+        if (!cooked || cookedBytes < sizeof(header)) {
+            return nullptr;
+        }
+        memcpy(&header, cooked, sizeof(header));
+        if (memcmp(header.magic, LUA_BYTECODE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != LUA_BYTECODE_VERSION ||
+            header.bytecodeBytes != cookedBytes - sizeof(header) ||
+            header.sourceHash != luaSourceHash(source, sourceBytes)) {
+            return nullptr;
+        }
+        bytecodeBytes = (size_t)header.bytecodeBytes;
+        return cooked + sizeof(header);
+    }
+
+    LuaCookResult cookLuaScript(lua_State* L, const char* sourcePath, const char* cookedPath, bool strip) {
+        Core::MappedFile source;
+        if (!source.open(sourcePath)) {
+            fprintf(stderr, "failed to open %s\n", sourcePath);
+            return LuaCookResult::Failed;
+        }
+        uint32_t flags = strip ? LUA_BYTECODE_STRIPPED : 0;
+        {
+            Core::MappedFile existing;
+            size_t bytecodeBytes;
+            LuaBytecodeHeader existingHeader;
+            if (existing.open(cookedPath) &&
+                luaCookedBytecode(existing.data(), existing.size(), source.data(), source.size(), bytecodeBytes)) {
+                memcpy(&existingHeader, existing.data(), sizeof(existingHeader));
+                if (existingHeader.flags == flags) {
+                    return LuaCookResult::UpToDate;
+                }
+            }
+        }
+
+        std::string chunkName = std::string("@") + sourcePath;
+        if (luaL_loadbuffer(L, source.data(), source.size(), chunkName.c_str()) != 0) {
+            fprintf(stderr, "%s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return LuaCookResult::Failed;
+        }
+        lua_getglobal(L, "string");
+        lua_getfield(L, -1, "dump");
+        lua_remove(L, -2);
+        lua_insert(L, -2);
+        lua_pushboolean(L, strip);
+        if (lua_pcall(L, 2, 1, 0) != 0) {
+            fprintf(stderr, "%s: %s\n", sourcePath, lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return LuaCookResult::Failed;
+        }
+        size_t bytecodeBytes;
+        const char* bytecode = lua_tolstring(L, -1, &bytecodeBytes);
+
+        LuaBytecodeHeader header;
+        memcpy(header.magic, LUA_BYTECODE_MAGIC, sizeof(header.magic));
+        header.version = LUA_BYTECODE_VERSION;
+        header.flags = flags;
+        header.reserved = 0;
+        header.sourceHash = luaSourceHash(source.data(), source.size());
+        header.bytecodeBytes = bytecodeBytes;
+
+        // written next to the target and renamed so a running engine never maps a half written file
+        std::string temporaryPath = std::string(cookedPath) + ".tmp";
+        FILE* file = fopen(temporaryPath.c_str(), "wb");
+        bool ok = file &&
+            fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(bytecode, 1, bytecodeBytes, file) == bytecodeBytes;
+        if (file) {
+            ok = fclose(file) == 0 && ok;
+        }
+        lua_pop(L, 1);
+        if (!ok || rename(temporaryPath.c_str(), cookedPath) != 0) {
+            fprintf(stderr, "failed to write %s\n", cookedPath);
+            remove(temporaryPath.c_str());
+            return LuaCookResult::Failed;
+        }
+        return LuaCookResult::Cooked;
+    }
+
+    LuaCookStats cookLuaDirectory(lua_State* L, const std::string& sourceRoot, const std::string& cookedRoot, bool strip) {
+        namespace fs = std::filesystem;
+        LuaCookStats stats{};
+        std::error_code error;
+        for (fs::recursive_directory_iterator it(sourceRoot, error), end; !error && it != end; it.increment(error)) {
+            if (!it->is_regular_file() || it->path().extension() != ".lua") {
+                continue;
+            }
+            std::string relative = fs::relative(it->path(), sourceRoot).generic_string();
+            std::string cookedPath = luaCookedPath(cookedRoot, relative);
+            fs::create_directories(fs::path(cookedPath).parent_path(), error);
+            switch (cookLuaScript(L, it->path().string().c_str(), cookedPath.c_str(), strip)) {
+                case LuaCookResult::Cooked: stats.cooked++; break;
+                case LuaCookResult::UpToDate: stats.upToDate++; break;
+                case LuaCookResult::Failed: stats.failed++; break;
+            }
+        }
+        if (error) {
+            fprintf(stderr, "%s: %s\n", sourceRoot.c_str(), error.message().c_str());
+            stats.failed++;
+        }
+        return stats;
+    }
+
+} // namespace Engine
@@ -0,0 +1,213 @@
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/scene/components.hpp"
+
+#include "lua.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace Engine {
+
+    namespace {
+
+        const float BENCH_DT = 1.0f / 60.0f;
+
+        // same update three ways: a script system looping over FFI views of the whole batch,
+        // an update function called once per entity with the values pushed on the stack, and the
+        // classic binding where every entity costs a getter call per component and a setter call
+        const char* BENCH_SCRIPT = R"lua(
+engine.system("bench movement", { "Position", "Velocity" }, function(batch, dt)
+    for c = 0, batch.count - 1 do
+        local chunk = batch.chunks[c]
+        local positions = batch:column(chunk, 0)
+        local velocities = batch:column(chunk, 1)
+        for i = 0, chunk.count - 1 do
+            local p, v = positions[i], velocities[i]
+            p.x = p.x + v.x * dt
+            p.y = p.y + v.y * dt
+            p.z = p.z + v.z * dt
+        end
+    end
+end)
+
+function entityUpdate(x, y, z, vx, vy, vz, dt)
+    return x + vx * dt, y + vy * dt, z + vz * dt
+end
+
+function capiUpdate(dt, count)
+    local getPosition, getVelocity, setPosition = capi.getPosition, capi.getVelocity, capi.setPosition
+    for i = 0, count - 1 do
+        local x, y, z = getPosition(i)
+        local vx, vy, vz = getVelocity(i)
+        setPosition(i, x + vx * dt, y + vy * dt, z + vz * dt)
+    end
+end
+)lua";
+
+        struct BenchContext {
+            ECS::World* world;
+            std::vector<ECS::Entity> entities;
+        };
+
+        BenchContext* benchContext(lua_State* L) {
+            return static_cast<BenchContext*>(lua_touserdata(L, lua_upvalueindex(1)));
+        }
+
+        ECS::Entity benchEntity(lua_State* L) {
+            BenchContext* context = benchContext(L);
+            lua_Integer index = luaL_checkinteger(L, 1);
+            if (index < 0 || (size_t)index >= context->entities.size()) {
+                luaL_error(L, "entity index %d out of range", (int)index);
+            }
+            return context->entities[index];
+        }
+
+        int benchPushVec3(lua_State* L, const glm::vec3& value) {
+            lua_pushnumber(L, value.x);
+            lua_pushnumber(L, value.y);
+            lua_pushnumber(L, value.z);
+            return 3;
+        }
+
+        int benchGetPosition(lua_State* L) {
+            ECS::Entity entity = benchEntity(L);
+            return benchPushVec3(L, benchContext(L)->world->get<Scene::Position>(entity)->value);
+        }
+
+        int benchGetVelocity(lua_State* L) {
+            ECS::Entity entity = benchEntity(L);
+            return benchPushVec3(L, benchContext(L)->world->get<Scene::Velocity>(entity)->value);
+        }
+
+        int benchSetPosition(lua_State* L) {
+            ECS::Entity entity = benchEntity(L);
+            glm::vec3& value = benchContext(L)->world->get<Scene::Position>(entity)->value;
+            value.x = (float)luaL_checknumber(L, 2);
+            value.y = (float)luaL_checknumber(L, 3);
+            value.z = (float)luaL_checknumber(L, 4);
+            return 0;
+        }
+
+        // runs `update` `iterations` times after a warmup that lets the JIT record its traces,
+        // returns nanoseconds per entity update
+        template<typename Fn>
+        double benchMeasure(uint32_t entities, uint32_t iterations, Fn&& update) {
+            for (uint32_t i = 0; i < 10; i++) {
+                update();
+            }
+            uint64_t start = Core::nowNanoseconds();
+            for (uint32_t i = 0; i < iterations; i++) {
+                update();
+            }
+            uint64_t elapsed = Core::nowNanoseconds() - start;
+            return (double)elapsed / ((double)entities * iterations);
+        }
+
+        // the per entity script callback design, one lua_pcall per entity per frame
+        bool benchCallPerEntity(LuaJIT& lua, ECS::Query& query) {
+            lua_State* L = lua.state();
+            bool ok = true;
+            query.each<Scene::Position, Scene::Velocity>([&](Scene::Position& position, Scene::Velocity& velocity) {
+                lua_getglobal(L, "entityUpdate");
+                for (int k = 0; k < 3; k++) {
+                    lua_pushnumber(L, position.value[k]);
+                }
+                for (int k = 0; k < 3; k++) {
+                    lua_pushnumber(L, velocity.value[k]);
+                }
+                lua_pushnumber(L, BENCH_DT);
+                if (!lua.call(7, 3)) {
+                    ok = false;
+                    return;
+                }
+                for (int k = 0; k < 3; k++) {
+                    position.value[k] = (float)lua_tonumber(L, k - 3);
+                }
+                lua_pop(L, 3);
+            });
+            return ok;
+        }
+
+        bool benchCallCApi(LuaJIT& lua, uint32_t count) {
+            lua_State* L = lua.state();
+            lua_getglobal(L, "capiUpdate");
+            lua_pushnumber(L, BENCH_DT);
+            lua_pushinteger(L, (lua_Integer)count);
+            return lua.call(2, 0);
+        }
+
+    } // namespace
+
+    void runLuaComponentBenchmark(uint32_t entities, uint32_t iterations) {
+        ECS::World world;
+        BenchContext context{&world, {}};
+        context.entities.reserve(entities);
+        for (uint32_t i = 0; i < entities; i++) {
+            context.entities.push_back(world.create(
+                Scene::Position{glm::vec3((float)i, 0.0f, 0.0f)},
+                Scene::Velocity{glm::vec3(1.0f, 2.0f, 3.0f)}));
+        }
+
+        LuaJIT lua;
+        if (!lua.init(world)) {
+            fprintf(stderr, "lua component benchmark: failed to create the lua state\n");
+            return;
+        }
+        if (!lua.registerComponent<Scene::Position>("Position", "float x, y, z;") ||
+            !lua.registerComponent<Scene::Velocity>("Velocity", "float x, y, z;")) {
+            fprintf(stderr, "lua component benchmark: failed to register Position and Velocity with lua\n");
+            return;
+        }
+        lua_State* L = lua.state();
+        lua_newtable(L);
+        const luaL_Reg functions[] = {
+            {"getPosition", benchGetPosition},
+            {"getVelocity", benchGetVelocity},
+            {"setPosition", benchSetPosition},
+        };
+        for (const luaL_Reg& function : functions) {
+            lua_pushlightuserdata(L, &context);
+            lua_pushcclosure(L, function.func, 1);
+            lua_setfield(L, -2, function.name);
+        }
+        lua_setglobal(L, "capi");
+        if (!lua.runString(BENCH_SCRIPT, "=lua component benchmark")) {
+            fprintf(stderr, "lua component benchmark: the benchmark script failed to load\n");
+            return;
+        }
+
+        ECS::Query& query = world.query<Scene::Position, Scene::Velocity>();
+        double nativeNs = benchMeasure(entities, iterations, [&]() {
+            query.each<Scene::Position, Scene::Velocity>([](Scene::Position& position, Scene::Velocity& velocity) {
+                position.value += velocity.value * BENCH_DT;
+            });
+        });
+        double systemNs = benchMeasure(entities, iterations, [&]() {
+            lua.runSystems(BENCH_DT);
+        });
+        lua.endFrame();
+        bool ok = true;
+        double perEntityNs = benchMeasure(entities, iterations, [&]() {
+            ok = ok && benchCallPerEntity(lua, query);
+        });
+        double capiNs = benchMeasure(entities, iterations, [&]() {
+            ok = ok && benchCallCApi(lua, entities);
+        });
+        if (!ok) {
+            fprintf(stderr, "lua component benchmark: a per entity lua call failed\n");
+            return;
+        }
+
+        printf("lua component benchmark, %u entities x %u iterations\n", entities, iterations);
+        printf("  native C++            %8.2f ns/entity\n", nativeNs);
+        printf("  lua system, ffi batch %8.2f ns/entity (%.1fx native, 1 call per update)\n",
+            systemNs, systemNs / nativeNs);
+        printf("  lua pcall per entity  %8.2f ns/entity (%.1fx native, %.1fx batch)\n",
+            perEntityNs, perEntityNs / nativeNs, perEntityNs / systemNs);
+        printf("  lua C API accessors   %8.2f ns/entity (%.1fx native, %.1fx batch)\n",
+            capiNs, capiNs / nativeNs, capiNs / systemNs);
+    }
+
+} // namespace Engine
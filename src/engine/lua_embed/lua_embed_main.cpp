@@ -0,0 +1,383 @@
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/lua_embed/lua_bytecode.hpp"
+#include "engine/core/mapped_file.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/memory/memory_tracker.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace Engine {
+
+    namespace {
+
+        static_assert(LUA_MAX_QUERY_COLUMNS == 8, "EngineChunk in the prelude hardcodes the column count");
+
+        // runs once per state with the LuaEngineApi pointer as its argument and returns the
+        // component registration function and the system table. everything scripts touch lives
+        // in the global `engine`
+        const char* PRELUDE = R"lua(
+local ffi = require("ffi")
+
+ffi.cdef[[
+typedef struct { uint32_t index, generation; } EngineEntity;
+typedef struct {
+    uint32_t count;
+    uint32_t columnCount;
+    EngineEntity* entities;
+    void* columns[8];
+} EngineChunk;
+typedef struct EngineApi EngineApi;
+struct EngineApi {
+    void* self;
+    int32_t (*createQuery)(void* self, const char** names, int32_t count);
+    uint32_t (*fetchChunks)(void* self, int32_t query, EngineChunk** chunks);
+    int32_t (*addSystem)(void* self, const char* name, int32_t query);
+};
+]]
+
+local api = ffi.cast("EngineApi*", ...)
+local pointerTypes = {}
+local systems = {}
+
+engine = {}
+
+local Query = {}
+Query.__index = Query
+
+-- engine.query("Position", "Velocity") returns a query whose column k (0 based) is the k-th
+-- component passed in
+function engine.query(...)
+    local count = select("#", ...)
+    local names = { ... }
+    local id = api.createQuery(api.self, ffi.new("const char*[?]", count, names), count)
+    if id == -2 then
+        error("engine.query: new queries can't be made while systems are running, make them when the script loads", 2)
+    elseif id < 0 then
+        error("engine.query: unknown component or too many components in (" .. table.concat(names, ", ") .. ")", 2)
+    end
+    local types = {}
+    for k = 1, count do
+        types[k - 1] = pointerTypes[names[k]]
+    end
+    return setmetatable({ id = id, types = types, out = ffi.new("EngineChunk*[1]") }, Query)
+end
+
+-- returns the chunk array and its length. the pointers are only valid until the next
+-- structural change (create, destroy, add, remove) in the world
+function Query:fetch()
+    local count = api.fetchChunks(api.self, self.id, self.out)
+    return self.out[0], count
+end
+
+-- typed pointer to column k of a chunk, index it from 0 to chunk.count - 1
+function Query:column(chunk, k)
+    return ffi.cast(self.types[k], chunk.columns[k])
+end
+
+-- engine.system("drift", { "Position", "Velocity" }, function(batch, dt) ... end)
+-- fn runs once per simulation step with every matching chunk in batch.chunks[0 .. batch.count - 1],
+-- the loop over entities stays inside Lua where the JIT can trace it. registering a name
+-- again replaces its function
+function engine.system(name, components, fn)
+    local batch = engine.query(unpack(components))
+    local index = api.addSystem(api.self, name, batch.id)
+    systems[index + 1] = function(dt)
+        batch.chunks, batch.count = batch:fetch()
+        fn(batch, dt)
+    end
+end
+
+local function registerComponent(name, fields, size)
+    ffi.cdef("typedef struct { " .. fields .. " } " .. name .. ";")
+    if ffi.sizeof(name) ~= size then
+        error(name .. " is " .. ffi.sizeof(name) .. " bytes in Lua but " .. size .. " bytes in C++")
+    end
+    pointerTypes[name] = ffi.typeof("$*", ffi.typeof(name))
+end
+
+return registerComponent, systems
+)lua";
+
+        int32_t apiCreateQuery(LuaJIT* self, const char* const* names, int32_t count) {
+            return self->createQuery(names, count);
+        }
+
+        uint32_t apiFetchChunks(LuaJIT* self, int32_t query, LuaChunk** chunks) {
+            return self->fetchChunks(query, chunks);
+        }
+
+        int32_t apiAddSystem(LuaJIT* self, const char* name, int32_t query) {
+            return self->addSystem(name, query);
+        }
+
+    } // namespace
+
+    LuaJIT::LuaJIT()
+        : L(nullptr), world(nullptr), api{this, apiCreateQuery, apiFetchChunks, apiAddSystem},
+          registerFunction(LUA_NOREF), systemFunctions(LUA_NOREF), cookedLoads(0),
+          partitionIndex(0), partitionCount(1), queriesFrozen(false), frameStats{}, lastStats{} {}
+
+    LuaJIT::~LuaJIT() {
+        shutdown();
+    }
+
+    bool LuaJIT::init(ECS::World& world) {
+        this->world = &world;
+        // GC64, the LuaJIT 2.1 default on x64 and arm64, takes a custom allocator. only a 64 bit
+        // build with LUAJIT_DISABLE_GC64 returns NULL here, its GC objects have to live in the low
+        // 2 GB that only LuaJIT's own allocator guarantees, so the state falls back to that and
+        // loses per tag accounting
+        L = lua_newstate(Memory::luaAllocate, nullptr);
+        if (!L) {
+            L = luaL_newstate();
+        }
+        if (!L) {
+            fprintf(stderr, "failed to create lua state\n");
+            return false;
+        }
+        luaL_openlibs(L);
+#ifdef ENGINE_LUAJIT_SHARE_DIR
+        // LuaJIT's own Lua modules (jit.vmdef, jit.v, jit.p) aren't linked in, they load from its share dir
+        lua_getglobal(L, "package");
+        lua_getfield(L, -1, "path");
+        lua_pushfstring(L, "%s;%s/?.lua", lua_tostring(L, -1), ENGINE_LUAJIT_SHARE_DIR);
+        lua_setfield(L, -3, "path");
+        lua_pop(L, 2);
+#endif
+
+        if (luaL_loadbuffer(L, PRELUDE, strlen(PRELUDE), "=engine prelude") != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            shutdown();
+            return false;
+        }
+        lua_pushlightuserdata(L, &api);
+        if (!call(1, 2)) {
+            shutdown();
+            return false;
+        }
+        systemFunctions = luaL_ref(L, LUA_REGISTRYINDEX);
+        registerFunction = luaL_ref(L, LUA_REGISTRYINDEX);
+        return true;
+    }
+
+    void LuaJIT::shutdown() {
+        if (L) {
+            lua_close(L);
+            L = nullptr;
+        }
+        registerFunction = LUA_NOREF;
+        systemFunctions = LUA_NOREF;
+        componentsByName.clear();
+        registeredMask.reset();
+        queries.clear();
+        systems.clear();
+    }
+
+    bool LuaJIT::registerComponent(ECS::ComponentId id, size_t size, const char* name, const char* fields) {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, registerFunction);
+        lua_pushstring(L, name);
+        lua_pushstring(L, fields);
+        lua_pushinteger(L, (lua_Integer)size);
+        if (!call(3, 0)) {
+            return false;
+        }
+        componentsByName[name] = id;
+        registeredMask.set(id);
+        return true;
+    }
+
+    bool LuaJIT::runString(const char* code, const char* chunkName) {
+        if (luaL_loadbuffer(L, code, strlen(code), chunkName) != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return false;
+        }
+        return call(0, 0);
+    }
+
+    void LuaJIT::setBytecodeCache(const std::string& sourceRoot, const std::string& cookedRoot) {
+        scriptRoot = sourceRoot;
+        this->cookedRoot = cookedRoot;
+    }
+
+    bool LuaJIT::loadFile(const char* path) {
+        Core::MappedFile source;
+        if (!source.open(path)) {
+            fprintf(stderr, "lua: cannot open %s\n", path);
+            return false;
+        }
+        std::string chunkName = std::string("@") + path;
+
+        size_t rootLength = scriptRoot.size();
+        if (!cookedRoot.empty() && strncmp(path, scriptRoot.c_str(), rootLength) == 0 && path[rootLength] == '/') {
+            Core::MappedFile cooked;
+            size_t bytecodeBytes;
+            const char* bytecode = nullptr;
+            if (cooked.open(luaCookedPath(cookedRoot, path + rootLength + 1).c_str())) {
+                bytecode = luaCookedBytecode(cooked.data(), cooked.size(), source.data(), source.size(), bytecodeBytes);
+            }
+            if (bytecode) {
+                // the parser never runs, the mapping goes away once the prototypes are built
+                if (luaL_loadbufferx(L, bytecode, bytecodeBytes, chunkName.c_str(), "b") == 0) {
+                    cookedLoads++;
+                    return true;
+                }
+                // bytecode from another LuaJIT version, the source is still good
+                fprintf(stderr, "lua: %s, loading %s from source\n", lua_tostring(L, -1), path);
+                lua_pop(L, 1);
+            }
+        }
+
+        if (luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t") != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return false;
+        }
+        return true;
+    }
+
+    bool LuaJIT::runFile(const char* path) {
+        if (!loadFile(path)) {
+            return false;
+        }
+        return call(0, 0);
+    }
+
+    bool LuaJIT::call(int nargs, int nresults) {
+        if (lua_pcall(L, nargs, nresults, 0) != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return false;
+        }
+        return true;
+    }
+
+    int32_t LuaJIT::createQuery(const char* const* names, int32_t count) {
+        if (count <= 0 || (uint32_t)count > LUA_MAX_QUERY_COLUMNS) {
+            return -1;
+        }
+        std::vector<ECS::ComponentId> components;
+        ECS::ComponentMask mask;
+        for (int32_t i = 0; i < count; i++) {
+            auto found = componentsByName.find(names[i]);
+            if (found == componentsByName.end()) {
+                return -1;
+            }
+            components.push_back(found->second);
+            mask.set(found->second);
+        }
+        // scripts usually build their queries once at load time, but a reload shouldn't grow the list
+        for (size_t i = 0; i < queries.size(); i++) {
+            if (queries[i].components == components) {
+                return (int32_t)i;
+            }
+        }
+        // World::getQuery changes the shared world, other states or systems may be iterating it
+        if (queriesFrozen || world->areQueriesLocked()) {
+            return -2;
+        }
+        queries.push_back(ScriptQuery{&world->getQuery(mask), components, {}, 0});
+        return (int32_t)(queries.size() - 1);
+    }
+
+    uint32_t LuaJIT::fetchChunks(int32_t query, LuaChunk** chunks) {
+        if (query < 0 || (size_t)query >= queries.size()) {
+            *chunks = nullptr;
+            return 0;
+        }
+        ScriptQuery& scriptQuery = queries[query];
+        // rebuilt on every fetch, archetypes and chunks appear as entities get created and the
+        // vector keeps its capacity so steady state fetching doesn't allocate
+        scriptQuery.chunks.clear();
+        scriptQuery.fetchedEntities = 0;
+        uint32_t columnCount = (uint32_t)scriptQuery.components.size();
+        scriptQuery.query->eachChunk([&](const ECS::ChunkView& view) {
+            // keyed on the chunk itself rather than its position in this query's iteration, so
+            // queries over different components still agree on which state owns a chunk
+            if ((view.archetype->id + view.chunkIndex) % partitionCount != partitionIndex) {
+                return;
+            }
+            LuaChunk chunk{};
+            chunk.count = view.count;
+            chunk.columnCount = columnCount;
+            chunk.entities = view.entities();
+            for (uint32_t k = 0; k < columnCount; k++) {
+                int column = view.archetype->columnIndex(scriptQuery.components[k]);
+                chunk.columns[k] = view.archetype->column(view.chunkIndex, column);
+            }
+            scriptQuery.chunks.push_back(chunk);
+            scriptQuery.fetchedEntities += view.count;
+        });
+        *chunks = scriptQuery.chunks.data();
+        return (uint32_t)scriptQuery.chunks.size();
+    }
+
+    void LuaJIT::setPartition(uint32_t index, uint32_t count) {
+        partitionCount = count > 0 ? count : 1;
+        partitionIndex = index % partitionCount;
+    }
+
+    int32_t LuaJIT::addSystem(const char* name, int32_t query) {
+        for (size_t i = 0; i < systems.size(); i++) {
+            if (systems[i].name == name) {
+                systems[i].query = query;
+                return (int32_t)i;
+            }
+        }
+        std::string counterName = std::string("lua ns/entity ") + name;
+        systems.push_back(ScriptSystem{name, counterName, query, 0, 0});
+        return (int32_t)(systems.size() - 1);
+    }
+
+    void LuaJIT::runSystems(float deltaTime) {
+        if (systems.empty()) {
+            return;
+        }
+        PROFILE_SCOPE("lua systems");
+        lua_rawgeti(L, LUA_REGISTRYINDEX, systemFunctions);
+        for (size_t i = 0; i < systems.size(); i++) {
+            ScriptSystem& system = systems[i];
+            PROFILE_SCOPE(system.name.c_str());
+            queries[system.query].fetchedEntities = 0;
+            uint64_t start = Core::nowNanoseconds();
+            lua_rawgeti(L, -1, (int)i + 1);
+            lua_pushnumber(L, deltaTime);
+            call(1, 0);
+            uint64_t elapsed = Core::nowNanoseconds() - start;
+            // by index, a system creating a query while it runs may grow the vector
+            uint64_t entities = queries[system.query].fetchedEntities;
+
+            system.entities += entities;
+            system.nanoseconds += elapsed;
+            frameStats.calls++;
+            frameStats.entities += entities;
+            frameStats.nanoseconds += elapsed;
+        }
+        lua_pop(L, 1);
+    }
+
+    void LuaJIT::endFrame(bool report) {
+        if (report) {
+            PROFILE_COUNTER("lua calls", frameStats.calls);
+            PROFILE_COUNTER("lua entities", frameStats.entities);
+            if (frameStats.entities > 0) {
+                PROFILE_COUNTER("lua ns/entity", (double)frameStats.nanoseconds / frameStats.entities);
+            }
+        }
+        for (ScriptSystem& system : systems) {
+            if (report && system.entities > 0) {
+                PROFILE_COUNTER(system.counterName.c_str(), (double)system.nanoseconds / system.entities);
+            }
+            system.entities = 0;
+            system.nanoseconds = 0;
+        }
+        lastStats = frameStats;
+        frameStats = LuaFrameStats{};
+    }
+
+} // namespace Engine
@@ -0,0 +1,83 @@
+#include "engine/lua_embed/lua_gc.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+
+#include <algorithm>
+
+namespace Engine {
+
+    LuaGC::LuaGC(const LuaGCSettings& settings)
+        : L(nullptr), settings(settings), inCycle(false), heapAfterCycle(0), frameStats{}, lastStats{} {}
+
+    void LuaGC::attach(LuaJIT& lua) {
+        L = lua.state();
+        lua_gc(L, LUA_GCSTOP, 0);
+        inCycle = false;
+        heapAfterCycle = heapBytes();
+        frameStats = LuaGCStats{};
+        lastStats = LuaGCStats{};
+    }
+
+    void LuaGC::detach() {
+        if (L) {
+            lua_gc(L, LUA_GCRESTART, 0);
+            L = nullptr;
+        }
+    }
+
+    size_t LuaGC::heapBytes() const {
+        return ((size_t)lua_gc(L, LUA_GCCOUNT, 0) << 10) + (size_t)lua_gc(L, LUA_GCCOUNTB, 0);
+    }
+
+    void LuaGC::collect(uint64_t idleNanoseconds) {
+        if (!L) {
+            return;
+        }
+        uint64_t start = Core::nowNanoseconds();
+        size_t heap = heapBytes();
+        if (heap > settings.ceilingBytes) {
+            PROFILE_SCOPE("lua full gc");
+            lua_gc(L, LUA_GCCOLLECT, 0);
+            frameStats.emergencyCollects++;
+            frameStats.cycles++;
+            inCycle = false;
+            heapAfterCycle = heapBytes();
+        } else if (inCycle || heap >= (size_t)((double)heapAfterCycle * settings.pause)) {
+            PROFILE_SCOPE("lua gc");
+            uint64_t minStep = Core::secondsToNanoseconds(settings.minStepMs / 1000.0);
+            uint64_t maxStep = Core::secondsToNanoseconds(settings.maxStepMs / 1000.0);
+            uint64_t deadline = start + std::min(std::max(idleNanoseconds, minStep), maxStep);
+            inCycle = true;
+            do {
+                frameStats.steps++;
+                if (lua_gc(L, LUA_GCSTEP, 0)) {
+                    // stop at the end of the cycle, the next one waits for the heap to grow again
+                    inCycle = false;
+                    frameStats.cycles++;
+                    heapAfterCycle = heapBytes();
+                    break;
+                }
+            } while (Core::nowNanoseconds() < deadline);
+        }
+        // a step or full collect recomputes the GC threshold, which turns automatic stepping back on
+        lua_gc(L, LUA_GCSTOP, 0);
+        frameStats.milliseconds += Core::nanosecondsToMilliseconds(Core::nowNanoseconds() - start);
+    }
+
+    void LuaGC::endFrame() {
+        if (!L) {
+            return;
+        }
+        frameStats.heapBytes = heapBytes();
+        PROFILE_COUNTER("lua gc ms", frameStats.milliseconds);
+        PROFILE_COUNTER("lua heap KB", frameStats.heapBytes / 1024.0);
+        lastStats = frameStats;
+        uint32_t emergencyCollects = frameStats.emergencyCollects;
+        frameStats = LuaGCStats{};
+        frameStats.emergencyCollects = emergencyCollects;
+    }
+
+} // namespace Engine
@@ -0,0 +1,476 @@
+#include "engine/lua_embed/lua_hot_reload.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/core/mapped_file.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace Engine {
+
+    namespace {
+
+        // saves arrive as a burst of events (write, rename, touch), wait for this much quiet
+        // before compiling so one save is one reload
+        const int RELOAD_SETTLE_MS = 30;
+        const int RELOAD_POLL_MS = 100;
+
+        // runs once per state with the script root and the C loader, returns runScript and reload
+        const char* RELOAD_SCRIPT = R"lua(
+local root, loadScript = ...
+local loaded = package.loaded
+local getupvalue, upvaluejoin = debug.getupvalue, debug.upvaluejoin
+
+-- by path: { name, path, chunk, value, order, functions, dependents = { [path] = true } }
+local modules = {}
+local pathsByName = {}
+local loading = {}          -- paths of the chunks running right now, innermost last
+local loadOrder = 0
+local registered            -- engine.system functions of the chunk running right now
+
+local rawSystem = engine.system
+function engine.system(name, components, fn)
+    if registered then
+        registered[#registered + 1] = fn
+    end
+    return rawSystem(name, components, fn)
+end
+
+-- runs a module's chunk, also returns the functions it handed out other than through its
+-- table: engine.system callbacks and global functions it defined or replaced
+local function execute(module)
+    local outer = registered
+    registered = {}
+    local before = {}
+    for k, v in pairs(_G) do
+        if type(v) == "function" then
+            before[k] = v
+        end
+    end
+    loading[#loading + 1] = module.path
+    local ok, value = pcall(module.chunk, module.name)
+    loading[#loading] = nil
+    local functions = registered
+    registered = outer
+    for k, v in pairs(_G) do
+        if type(v) == "function" and before[k] ~= v then
+            functions[#functions + 1] = v
+        end
+    end
+    return ok, value, functions
+end
+
+local function first(module)
+    modules[module.path] = module
+    local ok, value, functions = execute(module)
+    -- ordered by when loading finished, so dependencies always sort before their dependents
+    loadOrder = loadOrder + 1
+    module.order = loadOrder
+    module.functions = functions
+    if not ok then
+        error(value, 0)
+    end
+    module.value = value
+    return value
+end
+
+local rawRequire = require
+function require(name)
+    local value = rawRequire(name)
+    local parent = loading[#loading]
+    local path = pathsByName[name]
+    if parent and path then
+        modules[path].dependents[parent] = true
+    end
+    return value
+end
+
+table.insert(package.loaders, 2, function(name)
+    local path = root .. "/" .. name:gsub("%.", "/") .. ".lua"
+    local file = io.open(path, "rb")
+    if not file then
+        return "\n\tno engine script '" .. path .. "'"
+    end
+    file:close()
+    local chunk = loadScript(path)
+    return function()
+        pathsByName[name] = path
+        return first({ name = name, path = path, chunk = chunk, dependents = {} })
+    end
+end)
+
+local function runScript(path, chunk)
+    return first({ path = path, chunk = chunk, dependents = {} })
+end
+
+-- non function upvalues reachable from the old code, by name
+local function collectUpvalues(value, found, seen)
+    if type(value) == "function" then
+        for i = 1, 255 do
+            local name, upvalue = getupvalue(value, i)
+            if not name then
+                break
+            end
+            if found[name] == nil and type(upvalue) ~= "function" then
+                found[name] = { value, i }
+            end
+        end
+    elseif type(value) == "table" and not seen[value] then
+        seen[value] = true
+        for _, v in pairs(value) do
+            collectUpvalues(v, found, seen)
+        end
+    end
+end
+
+-- functions keep the new code of local helpers but share the old locals holding data
+local function joinUpvalues(fn, found)
+    for i = 1, 255 do
+        local name, upvalue = getupvalue(fn, i)
+        if not name then
+            break
+        end
+        local old = found[name]
+        if old and type(upvalue) ~= "function" then
+            upvaluejoin(fn, i, old[1], old[2])
+        end
+    end
+end
+
+local function patch(old, new, found, seen)
+    seen[new] = true
+    for k, v in pairs(new) do
+        local current = rawget(old, k)
+        if type(v) == "function" then
+            joinUpvalues(v, found)
+            rawset(old, k, v)
+        elseif type(v) == "table" and type(current) == "table" then
+            if not seen[v] then
+                patch(current, v, found, seen)
+            end
+        elseif current == nil then
+            rawset(old, k, v)
+        end
+    end
+end
+
+local function rerun(module)
+    local found = {}
+    collectUpvalues(module.value, found, {})
+    collectUpvalues(module.functions, found, {})
+    local ok, value, functions = execute(module)
+    if not ok then
+        print("lua reload " .. module.path .. ": " .. tostring(value))
+        return false
+    end
+    for _, fn in ipairs(functions) do
+        joinUpvalues(fn, found)
+    end
+    module.functions = functions
+    if type(module.value) == "table" and type(value) == "table" then
+        patch(module.value, value, found, {})
+    else
+        module.value = value
+        if module.name then
+            loaded[module.name] = value
+        end
+    end
+    return true
+end
+
+-- returns how many modules ran and whether all of them succeeded, nil for unknown paths
+local function reload(path, chunk)
+    local changed = modules[path]
+    if not changed then
+        return nil
+    end
+    changed.chunk = chunk
+
+    local affected, seen = { changed }, { [changed] = true }
+    local i = 1
+    while affected[i] do
+        for dependent in pairs(affected[i].dependents) do
+            local module = modules[dependent]
+            if module and not seen[module] then
+                seen[module] = true
+                affected[#affected + 1] = module
+            end
+        end
+        i = i + 1
+    end
+    table.sort(affected, function(a, b) return a.order < b.order end)
+
+    for k, module in ipairs(affected) do
+        -- a module that fails leaves its dependents on the code that still works with it
+        if not rerun(module) then
+            return k, false
+        end
+    end
+    return #affected, true
+end
+
+return runScript, reload
+)lua";
+
+        int luaLoadScript(lua_State* L) {
+            LuaJIT* lua = static_cast<LuaJIT*>(lua_touserdata(L, lua_upvalueindex(1)));
+            const char* path = luaL_checkstring(L, 1);
+            if (!lua->loadFile(path)) {
+                return luaL_error(L, "cannot load %s", path);
+            }
+            return 1;
+        }
+
+        int bytecodeWriter(lua_State*, const void* data, size_t size, void* target) {
+            static_cast<std::string*>(target)->append(static_cast<const char*>(data), size);
+            return 0;
+        }
+
+        // "a/./b/../c/" and "a/c" are the same script directory, paths are compared as strings
+        std::string normalPath(const std::string& path) {
+            std::string normal = std::filesystem::path(path).lexically_normal().string();
+            if (normal.size() > 1 && normal.back() == '/') {
+                normal.pop_back();
+            }
+            return normal;
+        }
+
+    } // namespace
+
+    LuaHotReload::LuaHotReload()
+        : lua(nullptr), running(false), pending(false), frameStats{}, lastStats{} {}
+
+    LuaHotReload::~LuaHotReload() {
+        shutdown();
+    }
+
+    bool LuaHotReload::init(LuaJIT& lua, const std::string& scriptRoot) {
+        this->lua = &lua;
+        root = normalPath(scriptRoot);
+        return install(lua);
+    }
+
+    bool LuaHotReload::addState(LuaJIT& lua) {
+        if (targets.empty()) {
+            return false;
+        }
+        return install(lua);
+    }
+
+    bool LuaHotReload::install(LuaJIT& lua) {
+        lua_State* L = lua.state();
+        if (luaL_loadbuffer(L, RELOAD_SCRIPT, strlen(RELOAD_SCRIPT), "=engine reload") != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return false;
+        }
+        lua_pushstring(L, root.c_str());
+        lua_pushlightuserdata(L, &lua);
+        lua_pushcclosure(L, luaLoadScript, 1);
+        if (!lua.call(2, 2)) {
+            return false;
+        }
+        Target target;
+        target.lua = &lua;
+        target.reloadFunction = luaL_ref(L, LUA_REGISTRYINDEX);
+        target.runScriptFunction = luaL_ref(L, LUA_REGISTRYINDEX);
+        targets.push_back(target);
+        return true;
+    }
+
+    LuaHotReload::Target* LuaHotReload::find(LuaJIT& lua) {
+        for (Target& target : targets) {
+            if (target.lua == &lua) {
+                return &target;
+            }
+        }
+        return nullptr;
+    }
+
+    void LuaHotReload::shutdown() {
+        running.store(false);
+        if (thread.joinable()) {
+            thread.join();
+        }
+        watcher.close();
+        for (Target& target : targets) {
+            luaL_unref(target.lua->state(), LUA_REGISTRYINDEX, target.runScriptFunction);
+            luaL_unref(target.lua->state(), LUA_REGISTRYINDEX, target.reloadFunction);
+        }
+        targets.clear();
+        compiled.clear();
+        ready.clear();
+        pending.store(false);
+    }
+
+    bool LuaHotReload::runScript(const char* path) {
+        return runScript(*lua, path);
+    }
+
+    bool LuaHotReload::runScript(LuaJIT& lua, const char* path) {
+        Target* target = find(lua);
+        if (!target) {
+            return lua.runFile(path);
+        }
+        std::string normal = normalPath(path);
+        std::string directory = std::filesystem::path(normal).parent_path().string();
+        if (std::find(scriptDirectories.begin(), scriptDirectories.end(), directory) == scriptDirectories.end()) {
+            scriptDirectories.push_back(directory);
+        }
+        lua_State* L = lua.state();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, target->runScriptFunction);
+        lua_pushstring(L, normal.c_str());
+        if (!lua.loadFile(normal.c_str())) {
+            lua_pop(L, 2);
+            return false;
+        }
+        return lua.call(2, 0);
+    }
+
+    bool LuaHotReload::watch() {
+        if (targets.empty() || running.load()) {
+            return false;
+        }
+        if (!watcher.open()) {
+            return false;
+        }
+        // the watcher is only touched by its thread once that starts
+        if (!watcher.watchTree(root)) {
+            fprintf(stderr, "lua reload: cannot watch %s\n", root.c_str());
+        }
+        for (const std::string& directory : scriptDirectories) {
+            watcher.watchTree(directory.empty() ? "." : directory);
+        }
+        running.store(true);
+        thread = std::thread(&LuaHotReload::watchThread, this);
+        return true;
+    }
+
+    void LuaHotReload::watchThread() {
+        PROFILE_THREAD_NAME("lua reload");
+        // private state, parsing here keeps the compile off the frame and a save with a syntax
+        // error never gets near the running scripts
+        lua_State* compiler = luaL_newstate();
+        std::vector<std::string> changed;
+        while (running.load()) {
+            changed.clear();
+            if (watcher.wait(RELOAD_POLL_MS, changed) == 0) {
+                continue;
+            }
+            while (watcher.wait(RELOAD_SETTLE_MS, changed) > 0) {
+            }
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+            for (const std::string& path : changed) {
+                if (path.size() < 4 || path.compare(path.size() - 4, 4, ".lua") != 0) {
+                    continue;
+                }
+                Compiled result{normalPath(path), {}};
+                Core::MappedFile source;
+                if (!source.open(path.c_str())) {
+                    continue;
+                }
+                std::string chunkName = "@" + result.path;
+                if (luaL_loadbuffer(compiler, source.data(), source.size(), chunkName.c_str()) != 0) {
+                    fprintf(stderr, "lua reload: %s\n", lua_tostring(compiler, -1));
+                } else {
+                    lua_dump(compiler, bytecodeWriter, &result.bytecode);
+                }
+                lua_settop(compiler, 0);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                compiled.push_back(std::move(result));
+                pending.store(true, std::memory_order_release);
+            }
+            // drop the prototypes of everything compiled so far
+            lua_gc(compiler, LUA_GCCOLLECT, 0);
+        }
+        lua_close(compiler);
+    }
+
+    void LuaHotReload::applyOne(const Compiled& compiled) {
+        frameStats.files++;
+        if (compiled.bytecode.empty()) {
+            frameStats.failures++;
+            return;
+        }
+        // bytecode doesn't belong to a state, every state that loaded the file loads it again
+        uint32_t modules = 0;
+        uint32_t states = 0;
+        for (Target& target : targets) {
+            states += applyTo(target, compiled, modules) ? 1 : 0;
+        }
+        if (states > 0) {
+            frameStats.modules += modules;
+            printf("lua: reloaded %s, %u module%s in %u state%s\n", compiled.path.c_str(), modules,
+                modules == 1 ? "" : "s", states, states == 1 ? "" : "s");
+        }
+    }
+
+    // false for files the state never loaded, those aren't scripts of this state
+    bool LuaHotReload::applyTo(Target& target, const Compiled& compiled, uint32_t& modules) {
+        lua_State* L = target.lua->state();
+        std::string chunkName = "@" + compiled.path;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, target.reloadFunction);
+        lua_pushstring(L, compiled.path.c_str());
+        if (luaL_loadbufferx(L, compiled.bytecode.data(), compiled.bytecode.size(), chunkName.c_str(), "b") != 0) {
+            fprintf(stderr, "lua reload: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 3);
+            frameStats.failures++;
+            return false;
+        }
+        if (!target.lua->call(2, 2)) {
+            frameStats.failures++;
+            return false;
+        }
+        bool known = !lua_isnil(L, -2);
+        if (known) {
+            modules += (uint32_t)lua_tointeger(L, -2);
+            frameStats.failures += lua_toboolean(L, -1) ? 0 : 1;
+        }
+        lua_pop(L, 2);
+        return known;
+    }
+
+    void LuaHotReload::apply(uint64_t budgetNanoseconds) {
+        if (targets.empty()) {
+            return;
+        }
+        if (pending.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Compiled& entry : compiled) {
+                ready.push_back(std::move(entry));
+            }
+            compiled.clear();
+            pending.store(false, std::memory_order_relaxed);
+        }
+        if (ready.empty()) {
+            return;
+        }
+        PROFILE_SCOPE("lua reload");
+        uint64_t start = Core::nowNanoseconds();
+        size_t applied = 0;
+        while (applied < ready.size()) {
+            applyOne(ready[applied++]);
+            if (Core::nowNanoseconds() - start >= budgetNanoseconds) {
+                break;
+            }
+        }
+        ready.erase(ready.begin(), ready.begin() + applied);
+        frameStats.milliseconds += Core::nanosecondsToMilliseconds(Core::nowNanoseconds() - start);
+    }
+
+    void LuaHotReload::endFrame() {
+        PROFILE_COUNTER("lua reloads", frameStats.files);
+        PROFILE_COUNTER("lua reload ms", frameStats.milliseconds);
+        lastStats = frameStats;
+        frameStats = LuaReloadStats{};
+    }
+
+} // namespace Engine
@@ -0,0 +1,216 @@
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/memory/memory_tracker.hpp"
+
+#include "lua.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace Engine {
+
+    namespace {
+
+        const uint32_t MATH_BENCH_FRAMES = 100;
+
+        // the same transform update three ways: vec/quat/matrix math on plain Lua tables the way
+        // scripts usually start out, the vmath operators on FFI structs and the in place vmath
+        // methods. each transform integrates its position, spins its rotation and rebuilds its
+        // model matrix every frame
+        const char* MATH_BENCH_SCRIPT = R"lua(
+local root = ...
+package.path = root .. "/?.lua;" .. package.path
+local ffi = require("ffi")
+local vmath = require("vmath")
+local vec3, quat = vmath.vec3, vmath.quat
+local sqrt, sin, cos = math.sqrt, math.sin, math.cos
+
+ffi.cdef([[
+typedef struct {
+    vec3 position;
+    vec3 velocity;
+    vec3 scale;
+    quat rotation;
+    quat spin;
+    mat4 world;
+} BenchTransform;
+]])
+
+local function add(a, b) return { x = a.x + b.x, y = a.y + b.y, z = a.z + b.z } end
+local function scale(a, s) return { x = a.x * s, y = a.y * s, z = a.z * s } end
+local function qmul(a, b)
+    return {
+        x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        y = a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+        z = a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+        w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    }
+end
+local function qnormalize(q)
+    local length = sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w)
+    return { x = q.x / length, y = q.y / length, z = q.z / length, w = q.w / length }
+end
+local function compose(t, r, s)
+    local x, y, z, w = r.x, r.y, r.z, r.w
+    return {
+        (1 - 2 * (y * y + z * z)) * s.x, 2 * (x * y + w * z) * s.x, 2 * (x * z - w * y) * s.x, 0,
+        2 * (x * y - w * z) * s.y, (1 - 2 * (x * x + z * z)) * s.y, 2 * (y * z + w * x) * s.y, 0,
+        2 * (x * z + w * y) * s.z, 2 * (y * z - w * x) * s.z, (1 - 2 * (x * x + y * y)) * s.z, 0,
+        t.x, t.y, t.z, 1,
+    }
+end
+
+local count
+local tables
+local structs
+
+function setup(n)
+    count = n
+    tables = {}
+    structs = ffi.new("BenchTransform[?]", n)
+    for i = 1, n do
+        local angle = i * 0.001
+        local t = structs[i - 1]
+        t.position = vec3(i % 100, i % 37, i % 11)
+        t.velocity = vec3(sin(i), cos(i), 1)
+        t.scale = vec3(1, 1, 1)
+        t.rotation = quat()
+        t.spin = quat(cos(angle), 0, sin(angle), 0)
+        tables[i] = {
+            position = { x = t.position.x, y = t.position.y, z = t.position.z },
+            velocity = { x = t.velocity.x, y = t.velocity.y, z = t.velocity.z },
+            scale = { x = 1, y = 1, z = 1 },
+            rotation = { x = 0, y = 0, z = 0, w = 1 },
+            spin = { x = 0, y = sin(angle), z = 0, w = cos(angle) },
+        }
+    end
+end
+
+function benchTables(frames, dt)
+    for _ = 1, frames do
+        for i = 1, count do
+            local t = tables[i]
+            t.position = add(t.position, scale(t.velocity, dt))
+            t.rotation = qnormalize(qmul(t.rotation, t.spin))
+            t.world = compose(t.position, t.rotation, t.scale)
+        end
+    end
+    local sum = 0
+    for i = 1, count do
+        sum = sum + tables[i].world[13] + tables[i].world[1]
+    end
+    return sum
+end
+
+function benchOperators(frames, dt)
+    for _ = 1, frames do
+        for i = 0, count - 1 do
+            local t = structs[i]
+            t.position = t.position + t.velocity * dt
+            t.rotation = t.rotation * t.spin
+            t.rotation:normalize()
+            t.world:compose(t.position, t.rotation, t.scale)
+        end
+    end
+    local sum = 0
+    for i = 0, count - 1 do
+        sum = sum + structs[i].world.m[12] + structs[i].world.m[0]
+    end
+    return sum
+end
+
+function benchInPlace(frames, dt)
+    for _ = 1, frames do
+        for i = 0, count - 1 do
+            local t = structs[i]
+            t.position:addScaled(t.velocity, dt)
+            t.rotation:mul(t.spin):normalize()
+            t.world:compose(t.position, t.rotation, t.scale)
+        end
+    end
+    local sum = 0
+    for i = 0, count - 1 do
+        sum = sum + structs[i].world.m[12] + structs[i].world.m[0]
+    end
+    return sum
+end
+)lua";
+
+        struct MathResult {
+            double nanosecondsPerUpdate;
+            double allocationsPerFrame;
+            double checksum;
+        };
+
+        // runs the setup and one variant from scratch, a warmup gets the loops compiled before
+        // anything is counted. allocations are counted by the engine allocator the state runs on
+        bool mathMeasure(LuaJIT& lua, const char* function, uint32_t transforms, MathResult& result) {
+            lua_State* L = lua.state();
+            lua_getglobal(L, "setup");
+            lua_pushinteger(L, transforms);
+            if (!lua.call(1, 0)) {
+                return false;
+            }
+            lua_gc(L, LUA_GCCOLLECT, 0);
+            for (int pass = 0; pass < 2; pass++) {
+                uint32_t frames = pass == 0 ? 10 : MATH_BENCH_FRAMES;
+                uint64_t allocations = Memory::memoryTagStats(Memory::MemoryTag::Lua).totalAllocations;
+                uint64_t start = Core::nowNanoseconds();
+                lua_getglobal(L, function);
+                lua_pushinteger(L, frames);
+                lua_pushnumber(L, 1.0 / 60.0);
+                if (!lua.call(2, 1)) {
+                    return false;
+                }
+                uint64_t elapsed = Core::nowNanoseconds() - start;
+                allocations = Memory::memoryTagStats(Memory::MemoryTag::Lua).totalAllocations - allocations;
+                result.nanosecondsPerUpdate = (double)elapsed / ((double)frames * transforms);
+                result.allocationsPerFrame = (double)allocations / frames;
+                result.checksum = lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            }
+            return true;
+        }
+
+    } // namespace
+
+    void runLuaMathBenchmark(uint32_t transforms, const std::string& scriptRoot) {
+        ECS::World world;
+        LuaJIT lua;
+        if (!lua.init(world)) {
+            return;
+        }
+        lua_State* L = lua.state();
+        if (luaL_loadbuffer(L, MATH_BENCH_SCRIPT, strlen(MATH_BENCH_SCRIPT), "=lua math benchmark") != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return;
+        }
+        lua_pushstring(L, scriptRoot.c_str());
+        if (!lua.call(1, 0)) {
+            return;
+        }
+
+        struct Row {
+            const char* name;
+            const char* function;
+        };
+        const Row rows[] = {
+            {"lua tables", "benchTables"},
+            {"vmath operators", "benchOperators"},
+            {"vmath in place", "benchInPlace"},
+        };
+        printf("lua vector math benchmark, %u transforms x %u frames\n", transforms, MATH_BENCH_FRAMES);
+        printf("  %-20s %12s %14s %14s\n", "", "ns/update", "allocs/frame", "checksum");
+        for (const Row& row : rows) {
+            MathResult result{};
+            if (!mathMeasure(lua, row.function, transforms, result)) {
+                return;
+            }
+            printf("  %-20s %12.2f %14.1f %14.2f\n", row.name, result.nanosecondsPerUpdate, result.allocationsPerFrame,
+                   result.checksum);
+        }
+    }
+
+} // namespace Engine
@@ -0,0 +1,183 @@
+#include "engine/lua_embed/lua_state_pool.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/jobs/job_system.hpp"
+#include "engine/scene/components.hpp"
+
+#include "lua.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <unordered_map>
+
+namespace Engine {
+
+    namespace {
+
+        const float POOL_BENCH_DT = 1.0f / 60.0f;
+        const uint32_t POOL_BENCH_ITERATIONS = 100;
+
+        // enough math per entity that the script work dominates the per update overhead, plus one
+        // message per state per update around a ring so the inboxes are part of the measurement
+        const char* POOL_BENCH_SCRIPT = R"lua(
+local sqrt = math.sqrt
+local received = 0
+
+engine.system("pool bench", { "Position", "Velocity" }, function(batch, dt)
+    for c = 0, batch.count - 1 do
+        local chunk = batch.chunks[c]
+        local positions = batch:column(chunk, 0)
+        local velocities = batch:column(chunk, 1)
+        for i = 0, chunk.count - 1 do
+            local p, v = positions[i], velocities[i]
+            for _ = 1, 8 do
+                local length = sqrt(p.x * p.x + p.y * p.y + p.z * p.z) + 1
+                v.x = v.x - p.x / length * dt
+                v.y = v.y - p.y / length * dt
+                v.z = v.z - p.z / length * dt
+                p.x = p.x + v.x * dt
+                p.y = p.y + v.y * dt
+                p.z = p.z + v.z * dt
+            end
+        end
+    end
+    engine.send((engine.state + 1) % engine.stateCount, { state = engine.state, received = received })
+end)
+
+function engine.onMessage(from, message)
+    received = received + 1
+end
+)lua";
+
+        const uint32_t PARTITION_CHECK_ENTITIES = 3000;    // per archetype, several chunks each
+
+        // two systems over different components, the second one also tries to make a query no
+        // state has yet in the middle of the update, which has to be refused
+        const char* PARTITION_CHECK_SCRIPT = R"lua(
+engine.system("partition positions", { "Position" }, function(batch, dt) end)
+engine.system("partition movers", { "Position", "Velocity" }, function(batch, dt)
+    refused = not pcall(engine.query, "Velocity")
+end)
+)lua";
+
+        // every chunk of every archetype a query matches has to land in exactly one state, for
+        // each query on its own and across queries over different components
+        bool checkPartitions(uint32_t states) {
+            ECS::World world;
+            for (uint32_t i = 0; i < PARTITION_CHECK_ENTITIES; i++) {
+                Scene::Position position{glm::vec3((float)i, 0.0f, 0.0f)};
+                Scene::Velocity velocity{glm::vec3(0.0f, 1.0f, 0.0f)};
+                world.create(position);
+                world.create(position, velocity);
+                world.create(position, velocity, Scene::PreviousPosition{position.value});
+            }
+            Jobs::JobSystem jobs(std::max(1u, states - 1));
+            LuaStatePool pool;
+            if (!pool.init(world, states) ||
+                !pool.registerComponent<Scene::Position>("Position", "float x, y, z;") ||
+                !pool.registerComponent<Scene::Velocity>("Velocity", "float x, y, z;") ||
+                !pool.runString(PARTITION_CHECK_SCRIPT, "=lua pool partition check")) {
+                return false;
+            }
+            pool.update(jobs, POOL_BENCH_DT);
+
+            struct CheckedQuery {
+                const char* names[2];
+                int32_t count;
+                uint64_t entities;
+            };
+            const CheckedQuery checked[] = {
+                {{"Position", nullptr}, 1, 3ull * PARTITION_CHECK_ENTITIES},
+                {{"Position", "Velocity"}, 2, 2ull * PARTITION_CHECK_ENTITIES},
+            };
+            std::unordered_map<const ECS::Entity*, uint32_t> owners;
+            for (const CheckedQuery& query : checked) {
+                uint64_t entities = 0;
+                for (uint32_t state = 0; state < states; state++) {
+                    LuaJIT& lua = pool.state(state);
+                    LuaChunk* chunks = nullptr;
+                    uint32_t count = lua.fetchChunks(lua.createQuery(query.names, query.count), &chunks);
+                    for (uint32_t k = 0; k < count; k++) {
+                        auto owner = owners.emplace(chunks[k].entities, state);
+                        if (owner.first->second != state) {
+                            fprintf(stderr, "lua pool partition check: states %u and %u share a chunk\n",
+                                owner.first->second, state);
+                            return false;
+                        }
+                        entities += chunks[k].count;
+                    }
+                }
+                if (entities != query.entities) {
+                    fprintf(stderr, "lua pool partition check: (%s%s%s) covered %llu of %llu entities\n", query.names[0],
+                        query.count > 1 ? ", " : "", query.count > 1 ? query.names[1] : "",
+                        (unsigned long long)entities, (unsigned long long)query.entities);
+                    return false;
+                }
+            }
+            for (uint32_t state = 0; state < states; state++) {
+                lua_State* L = pool.state(state).state();
+                lua_getglobal(L, "refused");
+                bool refused = lua_toboolean(L, -1) != 0;
+                lua_pop(L, 1);
+                if (!refused) {
+                    fprintf(stderr, "lua pool partition check: state %u made a query during the update\n", state);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace
+
+    void runLuaPoolBenchmark(uint32_t entities, uint32_t maxStates) {
+        if (maxStates == 0) {
+            maxStates = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (!checkPartitions(std::max(2u, maxStates))) {
+            return;
+        }
+
+        ECS::World world;
+        for (uint32_t i = 0; i < entities; i++) {
+            world.create(
+                Scene::Position{glm::vec3((float)(i % 100), (float)(i / 100 % 100), 1.0f)},
+                Scene::Velocity{glm::vec3(0.0f, 1.0f, 0.0f)});
+        }
+
+        printf("lua state pool benchmark, %u entities x %u updates\n", entities, POOL_BENCH_ITERATIONS);
+        double singleMs = 0.0;
+        for (uint32_t states = 1; states <= maxStates; states++) {
+            // one job per state, the main thread helps while it waits
+            Jobs::JobSystem jobs(std::max(1u, states - 1));
+            LuaStatePool pool;
+            if (!pool.init(world, states) ||
+                !pool.registerComponent<Scene::Position>("Position", "float x, y, z;") ||
+                !pool.registerComponent<Scene::Velocity>("Velocity", "float x, y, z;") ||
+                !pool.runString(POOL_BENCH_SCRIPT, "=lua pool benchmark")) {
+                return;
+            }
+
+            for (uint32_t i = 0; i < 10; i++) {
+                pool.update(jobs, POOL_BENCH_DT);
+                pool.endFrame();
+            }
+            double busiestMs = 0.0;
+            uint32_t delivered = 0;
+            uint64_t start = Core::nowNanoseconds();
+            for (uint32_t i = 0; i < POOL_BENCH_ITERATIONS; i++) {
+                pool.update(jobs, POOL_BENCH_DT);
+                pool.endFrame();
+                busiestMs += pool.lastFrame().busiestStateMs;
+                delivered += pool.lastFrame().delivered;
+            }
+            double updateMs = (double)(Core::nowNanoseconds() - start) / 1e6 / POOL_BENCH_ITERATIONS;
+            if (states == 1) {
+                singleMs = updateMs;
+            }
+            printf("  %2u states  %8.3f ms/update  %5.2fx  busiest state %8.3f ms  %u messages\n",
+                states, updateMs, singleMs / updateMs, busiestMs / POOL_BENCH_ITERATIONS, delivered);
+        }
+    }
+
+} // namespace Engine
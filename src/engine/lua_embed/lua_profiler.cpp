@@ -0,0 +1,298 @@
+#include "engine/lua_embed/lua_profiler.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+#include "luajit.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Engine {
+
+    namespace {
+
+        // interned names are kept forever, a script generating functions past this shares one
+        const size_t MAX_PROFILE_NAMES = 4096;
+        const char* OTHER_NAME = "lua (other)";
+
+        // outermost frame first so the timeline reads like a call path
+        const char* STACK_FORMAT = "F;";
+        const char* LEAF_FORMAT = "F";
+
+        LuaProfiler* active = nullptr;
+
+        // attaches to the "trace" VM event like jit.v does and hands (kind, location, reason)
+        // to C++, returns the handler so stop() can detach it again
+        const char* TRACE_SCRIPT = R"lua(
+local report = ...
+local util = require("jit.util")
+local funcinfo, traceinfo = util.funcinfo, util.traceinfo
+-- the readable abort reasons, jit.vmdef is found when package.path reaches LuaJIT's share dir
+local ok, vmdef = pcall(require, "jit.vmdef")
+if not ok then
+    vmdef = nil
+end
+
+local function location(func, pc)
+    local info = funcinfo(func, pc)
+    if info.loc then
+        return info.loc
+    elseif info.ffid and vmdef then
+        return vmdef.ffnames[info.ffid]
+    end
+    return "(?)"
+end
+
+local function reason(err, info)
+    if type(err) ~= "number" then
+        return tostring(err)
+    end
+    local fmt = vmdef and vmdef.traceerr[err]
+    if not fmt then
+        return "error " .. err
+    end
+    if type(info) == "function" then
+        info = location(info)
+    elseif fmt == "NYI: bytecode %s" then
+        info = vmdef.bcnames:sub(6 * info + 1, 6 * info + 6):gsub(" +$", "")
+    end
+    local formatted, text = pcall(string.format, fmt, info)
+    return formatted and text or fmt
+end
+
+local starts = {}
+local function onTrace(what, tr, func, pc, otr, oex)
+    if what == "start" then
+        starts[tr] = location(func, pc)
+    elseif what == "abort" then
+        starts[tr] = nil
+        report("abort", location(func, pc), reason(otr, oex))
+    elseif what == "stop" then
+        report("trace", starts[tr] or "(?)", "")
+        if traceinfo(tr).linktype == "interpreter" then
+            report("fallback", starts[tr] or "(?)", "trace falls back to the interpreter")
+        end
+        starts[tr] = nil
+    end
+end
+
+jit.attach(onTrace, "trace")
+return onTrace
+)lua";
+
+        int luaTraceEvent(lua_State* L) {
+            LuaProfiler* profiler = static_cast<LuaProfiler*>(lua_touserdata(L, lua_upvalueindex(1)));
+            profiler->traceEvent(luaL_checkstring(L, 1), luaL_checkstring(L, 2), luaL_checkstring(L, 3));
+            return 0;
+        }
+
+        // runs on the thread executing the sampled state, with L the coroutine that was running
+        void profileCallback(void* data, lua_State* L, int samples, int vmstate) {
+            static_cast<LuaProfiler*>(data)->sample(L, samples, vmstate);
+        }
+
+        const char* vmStateName(int vmstate) {
+            switch (vmstate) {
+            case 'N': return "compiled";
+            case 'I': return "interpreted";
+            case 'C': return "C function";
+            case 'G': return "gc";
+            case 'J': return "jit compiler";
+            default: return "?";
+            }
+        }
+
+    } // namespace
+
+    LuaProfiler::LuaProfiler()
+        : L(nullptr), attachRef(LUA_NOREF), spanName(nullptr), spanStart(0), spanLast(0), totalSamples(0),
+          totalInterpreted(0), frameStats{}, lastStats{} {}
+
+    LuaProfiler::~LuaProfiler() {
+        stop();
+    }
+
+    bool LuaProfiler::start(LuaJIT& lua, const LuaProfilerSettings& settings) {
+        if (active) {
+            fprintf(stderr, "lua profiler: already sampling a state, LuaJIT has one profiler per process\n");
+            return false;
+        }
+        this->settings = settings;
+        this->settings.intervalMs = std::max(settings.intervalMs, 1);
+        this->settings.depth = std::max(settings.depth, 1);
+        L = lua.state();
+
+        if (luaL_loadbuffer(L, TRACE_SCRIPT, strlen(TRACE_SCRIPT), "=engine lua profiler") != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            L = nullptr;
+            return false;
+        }
+        lua_pushlightuserdata(L, this);
+        lua_pushcclosure(L, luaTraceEvent, 1);
+        if (!lua.call(1, 1)) {
+            L = nullptr;
+            return false;
+        }
+        attachRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        // 'f' samples at function granularity, names stay stable while a function runs
+        char mode[16];
+        snprintf(mode, sizeof(mode), "fi%d", this->settings.intervalMs);
+        luaJIT_profile_start(L, mode, profileCallback, this);
+        active = this;
+        return true;
+    }
+
+    void LuaProfiler::stop() {
+        if (!L) {
+            return;
+        }
+        luaJIT_profile_stop(L);
+        active = nullptr;
+        // jit.attach(handler) without an event name detaches it
+        lua_getglobal(L, "jit");
+        lua_getfield(L, -1, "attach");
+        lua_rawgeti(L, LUA_REGISTRYINDEX, attachRef);
+        if (lua_pcall(L, 1, 0, 0) != 0) {
+            fprintf(stderr, "lua: %s\n", lua_tostring(L, -1));
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+        luaL_unref(L, LUA_REGISTRYINDEX, attachRef);
+        attachRef = LUA_NOREF;
+        flushSpan();
+        L = nullptr;
+    }
+
+    const char* LuaProfiler::intern(const std::string& text) {
+        auto found = names.find(text);
+        if (found != names.end()) {
+            return found->c_str();
+        }
+        if (names.size() >= MAX_PROFILE_NAMES) {
+            return OTHER_NAME;
+        }
+        return names.insert(text).first->c_str();
+    }
+
+    void LuaProfiler::sample(lua_State* L, int samples, int vmstate) {
+        // the VM only checks for pending samples at safe points, inside a compiled loop that can
+        // be many timer ticks later. they all get the stack seen now, like jit.p does
+        frameStats.samples += (uint32_t)samples;
+        switch (vmstate) {
+        case 'N': frameStats.compiled += (uint32_t)samples; break;
+        case 'I': frameStats.interpreted += (uint32_t)samples; break;
+        case 'C': frameStats.native += (uint32_t)samples; break;
+        case 'G': frameStats.gc += (uint32_t)samples; break;
+        case 'J': frameStats.compiler += (uint32_t)samples; break;
+        default: break;
+        }
+
+        size_t length = 0;
+        const char* leafText = luaJIT_profile_dumpstack(L, LEAF_FORMAT, 1, &length);
+        const char* leaf = intern(std::string(leafText, length));
+        // the dump buffer is reused by the next call, leafText is gone after this
+        const char* stackText = luaJIT_profile_dumpstack(L, STACK_FORMAT, -settings.depth, &length);
+        std::string stack(stackText, length);
+        if (!stack.empty() && stack.back() == ';') {
+            stack.pop_back();
+        }
+        stack += " [";
+        stack += vmStateName(vmstate);
+        stack += "]";
+        const char* name = intern(stack);
+
+        Hotspot& hotspot = hotspots[leaf];
+        hotspot.samples += (uint32_t)samples;
+        totalSamples += (uint64_t)samples;
+        if (vmstate == 'I') {
+            hotspot.interpreted += (uint32_t)samples;
+            totalInterpreted += (uint64_t)samples;
+        }
+
+        // the samples stand for the intervals before now, back to back samples of the same stack
+        // grow one span instead of stacking up thousands of tiny ones
+        uint64_t now = Core::nowNanoseconds();
+        uint64_t interval = (uint64_t)settings.intervalMs * 1000000;
+        if (name == spanName && now - spanLast <= 2 * interval * (uint64_t)samples) {
+            spanLast = now;
+            return;
+        }
+        flushSpan();
+        spanName = name;
+        spanStart = std::max(now - interval * (uint64_t)samples, spanLast);
+        spanLast = now;
+    }
+
+    void LuaProfiler::flushSpan() {
+        if (spanName) {
+            PROFILE_SPAN("lua samples", spanName, spanStart, spanLast);
+        }
+        spanName = nullptr;
+    }
+
+    void LuaProfiler::traceEvent(const char* kind, const char* location, const char* reason) {
+        if (strcmp(kind, "trace") == 0) {
+            frameStats.traces++;
+            return;
+        }
+        if (strcmp(kind, "abort") == 0) {
+            frameStats.aborts++;
+        } else {
+            frameStats.fallbacks++;
+        }
+        // the same loop aborts again on every attempt until LuaJIT blacklists it, print it once
+        std::string key = std::string(kind) + " " + location + ": " + reason;
+        auto found = problems.find(key);
+        if (found != problems.end()) {
+            found->second.count++;
+            return;
+        }
+        problems.emplace(key, TraceProblem{kind, location, reason, 1});
+        printf("lua jit: trace %s at %s: %s\n", kind, location, reason);
+        PROFILE_SPAN("lua jit", intern(key), Core::nowNanoseconds(), Core::nowNanoseconds());
+    }
+
+    void LuaProfiler::endFrame() {
+        flushSpan();
+        PROFILE_COUNTER("lua samples", frameStats.samples);
+        PROFILE_COUNTER("lua interpreted %", frameStats.samples ? 100.0 * frameStats.interpreted / frameStats.samples : 0.0);
+        PROFILE_COUNTER("lua trace aborts", frameStats.aborts);
+        lastStats = frameStats;
+        frameStats = LuaProfilerStats{};
+    }
+
+    void LuaProfiler::printReport(FILE* file, size_t top) const {
+        std::vector<std::pair<const char*, Hotspot>> sorted(hotspots.begin(), hotspots.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            return a.second.samples > b.second.samples;
+        });
+        fprintf(file, "lua profile, %llu samples, %.1f%% interpreted\n", (unsigned long long)totalSamples,
+                totalSamples ? 100.0 * totalInterpreted / totalSamples : 0.0);
+        for (size_t i = 0; i < sorted.size() && i < top; i++) {
+            const Hotspot& hotspot = sorted[i].second;
+            fprintf(file, "  %6.2f%%  %5.1f%% interpreted  %s\n", 100.0 * hotspot.samples / totalSamples,
+                    100.0 * hotspot.interpreted / hotspot.samples, sorted[i].first);
+        }
+
+        std::vector<const TraceProblem*> byCount;
+        for (const auto& entry : problems) {
+            byCount.push_back(&entry.second);
+        }
+        std::sort(byCount.begin(), byCount.end(), [](const TraceProblem* a, const TraceProblem* b) {
+            return a->count > b->count;
+        });
+        if (!byCount.empty()) {
+            fprintf(file, "lua jit trace aborts and interpreter fallbacks\n");
+        }
+        for (const TraceProblem* problem : byCount) {
+            fprintf(file, "  %5ux  %-8s %s: %s\n", problem->count, problem->kind.c_str(), problem->location.c_str(),
+                    problem->reason.c_str());
+        }
+    }
+
+} // namespace Engine
@@ -0,0 +1,54 @@
+#include "engine/lua_embed/lua_renderer_bindings.hpp"
+#include "engine/lua_embed/lua_binding.hpp"
+#include "engine/renderer/camera.hpp"
+#include "engine/renderer/shader.hpp"
+
+namespace Engine {
+
+    bool bindRendererTypes(lua_State* L) {
+        bool ok = LuaBind::ClassBinding<Camera>("Camera")
+            .field<&Camera::Position>("Position")
+            .field<&Camera::Front>("Front")
+            .field<&Camera::Up>("Up")
+            .field<&Camera::Right>("Right")
+            .field<&Camera::Yaw>("Yaw")
+            .field<&Camera::Pitch>("Pitch")
+            .field<&Camera::MovementSpeed>("MovementSpeed")
+            .field<&Camera::MouseSensitivity>("MouseSensitivity")
+            .field<&Camera::Zoom>("Zoom")
+            .method<&Camera::GetViewMatrix>("GetViewMatrix")
+            .method<&Camera::ProcessKeyboard>("ProcessKeyboard")
+            .method<&Camera::ProcessMouseMovement>("ProcessMouseMovement")
+            .method<&Camera::ProcessMouseScroll>("ProcessMouseScroll")
+            .method<&Camera::SetPose>("SetPose")
+            .bind(L);
+        ok = ok && LuaBind::ClassBinding<Renderer::ShaderProgram>("ShaderProgram")
+            .field<&Renderer::ShaderProgram::ID>("ID")
+            .method<&Renderer::ShaderProgram::Use>("Use")
+            .method<&Renderer::ShaderProgram::setBool>("setBool")
+            .method<&Renderer::ShaderProgram::setInt>("setInt")
+            .method<&Renderer::ShaderProgram::setFloat>("setFloat")
+            .method<&Renderer::ShaderProgram::setMat4>("setMat4")
+            .bind(L);
+        if (!ok) {
+            return false;
+        }
+
+        lua_getglobal(L, "engine");
+        lua_newtable(L);
+        const struct { const char* name; Camera_Movement value; } movements[] = {
+            {"FORWARD", FORWARD},
+            {"BACKWARD", BACKWARD},
+            {"LEFT", LEFT},
+            {"RIGHT", RIGHT},
+        };
+        for (const auto& movement : movements) {
+            lua_pushinteger(L, movement.value);
+            lua_setfield(L, -2, movement.name);
+        }
+        lua_setfield(L, -2, "CameraMovement");
+        lua_pop(L, 1);
+        return true;
+    }
+
+} // namespace Engine
@@ -0,0 +1,282 @@
+#include "engine/lua_embed/lua_scheduler.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace Engine {
+
+    namespace {
+
+        // first value a coroutine yields, anything else (or nothing) waits for the next update
+        const int WAIT_SLEEP = 1;
+        const int WAIT_EVENT = 2;
+
+        const char* SCHEDULER_SCRIPT = R"lua(
+local yield = coroutine.yield
+
+function engine.sleep(seconds)
+    return yield(1, seconds)
+end
+
+function engine.waitEvent(name)
+    return yield(2, name)
+end
+
+function engine.waitAsset(path)
+    return yield(2, "asset:" .. path)
+end
+
+function engine.waitFrame()
+    return yield()
+end
+)lua";
+
+        LuaScheduler* schedulerUpvalue(lua_State* L) {
+            return static_cast<LuaScheduler*>(lua_touserdata(L, lua_upvalueindex(1)));
+        }
+
+        int luaSpawn(lua_State* L) {
+            luaL_checktype(L, 1, LUA_TFUNCTION);
+            lua_State* thread = lua_newthread(L);
+            lua_pushvalue(L, 1);
+            lua_xmove(L, thread, 1);
+            int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+            schedulerUpvalue(L)->spawn(thread, ref);
+            return 0;
+        }
+
+        int luaSignal(lua_State* L) {
+            const char* event = luaL_checkstring(L, 1);
+            lua_settop(L, 2);
+            int payloadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+            schedulerUpvalue(L)->queueSignal(event, payloadRef);
+            return 0;
+        }
+
+    } // namespace
+
+    LuaScheduler::LuaScheduler() : L(nullptr), currentTick(0), pendingTicks(0.0), frameStats{}, lastStats{} {}
+
+    LuaScheduler::~LuaScheduler() {
+        shutdown();
+    }
+
+    bool LuaScheduler::init(LuaJIT& lua) {
+        L = lua.state();
+        lua_getglobal(L, "engine");
+        lua_pushlightuserdata(L, this);
+        lua_pushcclosure(L, luaSpawn, 1);
+        lua_setfield(L, -2, "spawn");
+        lua_pushlightuserdata(L, this);
+        lua_pushcclosure(L, luaSignal, 1);
+        lua_setfield(L, -2, "signal");
+        lua_pop(L, 1);
+        if (!lua.runString(SCHEDULER_SCRIPT, "=engine scheduler")) {
+            L = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void LuaScheduler::shutdown() {
+        if (!L) {
+            return;
+        }
+        for (uint32_t i = 0; i < coroutines.size(); i++) {
+            if (coroutines[i].ref != LUA_NOREF) {
+                release(i);
+            }
+        }
+        for (const Signal& signal : signals) {
+            luaL_unref(L, LUA_REGISTRYINDEX, signal.payloadRef);
+        }
+        coroutines.clear();
+        freeCoroutines.clear();
+        for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+            for (uint32_t slot = 0; slot < WHEEL_SLOTS; slot++) {
+                wheel[level][slot].clear();
+            }
+        }
+        for (std::vector<uint32_t>& list : waitLists) {
+            list.clear();
+        }
+        signals.clear();
+        ready.clear();
+        frameStats = LuaSchedulerStats{};
+        L = nullptr;
+    }
+
+    void LuaScheduler::spawn(lua_State* thread, int threadRef) {
+        uint32_t id;
+        if (!freeCoroutines.empty()) {
+            id = freeCoroutines.back();
+            freeCoroutines.pop_back();
+        } else {
+            id = (uint32_t)coroutines.size();
+            coroutines.push_back(Coroutine{});
+        }
+        coroutines[id] = Coroutine{thread, threadRef, 0};
+        frameStats.alive++;
+        ready.push_back(Wake{id, LUA_NOREF});
+    }
+
+    void LuaScheduler::queueSignal(const char* event, int payloadRef) {
+        signals.push_back(Signal{eventId(event), payloadRef});
+    }
+
+    void LuaScheduler::signal(const char* event) {
+        queueSignal(event, LUA_REFNIL);
+    }
+
+    void LuaScheduler::assetLoaded(const char* path) {
+        std::string event = std::string("asset:") + path;
+        signal(event.c_str());
+    }
+
+    uint32_t LuaScheduler::eventId(const char* event) {
+        auto found = eventIds.find(event);
+        if (found != eventIds.end()) {
+            return found->second;
+        }
+        uint32_t id = (uint32_t)waitLists.size();
+        eventIds.emplace(event, id);
+        waitLists.emplace_back();
+        return id;
+    }
+
+    void LuaScheduler::scheduleSleep(uint32_t coroutine, uint64_t deadline) {
+        coroutines[coroutine].deadline = deadline;
+        uint64_t delta = deadline - currentTick;
+        for (uint32_t level = 0; level < WHEEL_LEVELS; level++) {
+            if (delta < (1ull << (WHEEL_BITS * (level + 1)))) {
+                uint32_t slot = (uint32_t)(deadline >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+                wheel[level][slot].push_back(coroutine);
+                return;
+            }
+        }
+        // further out than the wheel reaches (~4.6 hours), park it in the top level slot that
+        // comes around last and let the cascade put it back in with its real deadline
+        uint32_t top = WHEEL_LEVELS - 1;
+        uint32_t slot = (uint32_t)((currentTick >> (WHEEL_BITS * top)) - 1) & (WHEEL_SLOTS - 1);
+        wheel[top][slot].push_back(coroutine);
+    }
+
+    void LuaScheduler::cascade(uint32_t level) {
+        uint32_t slot = (uint32_t)(currentTick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+        cascading.swap(wheel[level][slot]);
+        for (uint32_t coroutine : cascading) {
+            scheduleSleep(coroutine, coroutines[coroutine].deadline);
+        }
+        cascading.clear();
+    }
+
+    void LuaScheduler::advanceTick() {
+        currentTick++;
+        // the lower levels wrapped, pull the next slot of each wrapped level down, highest first
+        uint32_t wrapped = 1;
+        while (wrapped < WHEEL_LEVELS && ((currentTick >> (WHEEL_BITS * (wrapped - 1))) & (WHEEL_SLOTS - 1)) == 0) {
+            wrapped++;
+        }
+        for (uint32_t level = wrapped - 1; level >= 1; level--) {
+            cascade(level);
+        }
+
+        std::vector<uint32_t>& expired = wheel[0][currentTick & (WHEEL_SLOTS - 1)];
+        for (uint32_t coroutine : expired) {
+            ready.push_back(Wake{coroutine, LUA_NOREF});
+        }
+        frameStats.sleeping -= (uint32_t)expired.size();
+        expired.clear();
+    }
+
+    void LuaScheduler::update(float deltaTime) {
+        if (!L) {
+            return;
+        }
+        PROFILE_SCOPE("lua coroutines");
+        pendingTicks += (double)deltaTime * TICKS_PER_SECOND;
+        uint64_t ticks = (uint64_t)pendingTicks;
+        pendingTicks -= (double)ticks;
+        if (frameStats.sleeping == 0) {
+            // an empty wheel has nothing to cascade, jumping keeps long idle stretches free
+            currentTick += ticks;
+        } else {
+            for (uint64_t i = 0; i < ticks; i++) {
+                advanceTick();
+            }
+        }
+
+        // signals raised while resuming land in `signals` again and wake their waiters next update
+        dispatching.swap(signals);
+        for (const Signal& signal : dispatching) {
+            std::vector<uint32_t>& waiters = waitLists[signal.event];
+            for (uint32_t coroutine : waiters) {
+                ready.push_back(Wake{coroutine, signal.payloadRef});
+            }
+            frameStats.waiting -= (uint32_t)waiters.size();
+            waiters.clear();
+        }
+
+        resuming.swap(ready);
+        for (const Wake& wake : resuming) {
+            resume(wake.coroutine, wake.payloadRef);
+        }
+        resuming.clear();
+
+        // payloads are shared by every waiter of the event, so they go only after all resumes
+        for (const Signal& signal : dispatching) {
+            luaL_unref(L, LUA_REGISTRYINDEX, signal.payloadRef);
+        }
+        dispatching.clear();
+    }
+
+    void LuaScheduler::resume(uint32_t coroutine, int payloadRef) {
+        lua_State* thread = coroutines[coroutine].thread;
+        int nargs = 0;
+        if (payloadRef != LUA_NOREF) {
+            lua_rawgeti(thread, LUA_REGISTRYINDEX, payloadRef);
+            nargs = 1;
+        }
+        frameStats.resumed++;
+        int status = lua_resume(thread, nargs);
+        if (status == LUA_YIELD) {
+            int wait = lua_gettop(thread) >= 1 ? (int)lua_tointeger(thread, 1) : 0;
+            if (wait == WAIT_SLEEP) {
+                double ticks = std::ceil(lua_tonumber(thread, 2) * TICKS_PER_SECOND);
+                scheduleSleep(coroutine, currentTick + (ticks < 1.0 ? 1 : (uint64_t)ticks));
+                frameStats.sleeping++;
+            } else if (wait == WAIT_EVENT && lua_type(thread, 2) == LUA_TSTRING) {
+                waitLists[eventId(lua_tostring(thread, 2))].push_back(coroutine);
+                frameStats.waiting++;
+            } else {
+                ready.push_back(Wake{coroutine, LUA_NOREF});
+            }
+            lua_settop(thread, 0);
+            return;
+        }
+        if (status != 0) {
+            fprintf(stderr, "lua coroutine: %s\n", lua_tostring(thread, -1));
+        }
+        release(coroutine);
+    }
+
+    void LuaScheduler::release(uint32_t coroutine) {
+        luaL_unref(L, LUA_REGISTRYINDEX, coroutines[coroutine].ref);
+        coroutines[coroutine] = Coroutine{nullptr, LUA_NOREF, 0};
+        freeCoroutines.push_back(coroutine);
+        frameStats.alive--;
+    }
+
+    void LuaScheduler::endFrame() {
+        PROFILE_COUNTER("lua coroutines resumed", frameStats.resumed);
+        PROFILE_COUNTER("lua coroutines sleeping", frameStats.sleeping);
+        PROFILE_COUNTER("lua coroutines waiting", frameStats.waiting);
+        lastStats = frameStats;
+        frameStats.resumed = 0;
+    }
+
+} // namespace Engine
@@ -0,0 +1,119 @@
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/lua_embed/lua_bytecode.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/core/clock.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace Engine {
+
+    namespace {
+
+        // gameplay module sized script, a few functions with loops, branches and tables so the
+        // parser has something realistic to chew on
+        std::string startupScript(uint32_t index) {
+            std::string id = std::to_string(index);
+            std::string code = "local M = { name = \"script_" + id + "\", weights = { 1, 2, 3, 5, 8, 13, 21 } }\n";
+            for (int function = 0; function < 8; function++) {
+                std::string name = "step" + std::to_string(function);
+                code +=
+                    "function M." + name + "(state, dt)\n"
+                    "    local total = 0\n"
+                    "    for i = 1, #M.weights do\n"
+                    "        local w = M.weights[i] * " + id + "\n"
+                    "        if w % 2 == 0 then\n"
+                    "            total = total + math.sin(w * dt) * state.scale\n"
+                    "        elseif w > 10 then\n"
+                    "            total = total - math.sqrt(w) / (state.scale + 1)\n"
+                    "        else\n"
+                    "            state.log[#state.log + 1] = string.format(\"%d %f\", i, total)\n"
+                    "        end\n"
+                    "    end\n"
+                    "    return { value = total, next = M." + name + ", label = M.name .. \"." + name + "\" }\n"
+                    "end\n";
+            }
+            code += "return M\n";
+            return code;
+        }
+
+        // loads and runs every script in a fresh state, returns milliseconds
+        double startupMeasure(const std::vector<std::string>& paths, const std::string& sourceRoot,
+                              const std::string& cookedRoot, uint32_t& bytecodeLoads) {
+            ECS::World world;
+            LuaJIT lua;
+            if (!lua.init(world)) {
+                return 0.0;
+            }
+            if (!cookedRoot.empty()) {
+                lua.setBytecodeCache(sourceRoot, cookedRoot);
+            }
+            uint64_t start = Core::nowNanoseconds();
+            for (const std::string& path : paths) {
+                lua.runFile(path.c_str());
+            }
+            uint64_t elapsed = Core::nowNanoseconds() - start;
+            bytecodeLoads = lua.bytecodeLoads();
+            return Core::nanosecondsToMilliseconds(elapsed);
+        }
+
+    } // namespace
+
+    void runLuaStartupBenchmark(uint32_t scripts) {
+        namespace fs = std::filesystem;
+        std::error_code error;
+        fs::path root = fs::temp_directory_path(error) / "engine_lua_startup";
+        std::string sourceRoot = (root / "scripts").string();
+        std::string cookedRoot = (root / "cooked").string();
+        fs::remove_all(root, error);
+        fs::create_directories(sourceRoot, error);
+        if (error) {
+            fprintf(stderr, "lua startup benchmark: %s: %s\n", sourceRoot.c_str(), error.message().c_str());
+            return;
+        }
+
+        std::vector<std::string> paths;
+        for (uint32_t i = 0; i < scripts; i++) {
+            std::string path = sourceRoot + "/script_" + std::to_string(i) + ".lua";
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file) {
+                fprintf(stderr, "lua startup benchmark: failed to write %s\n", path.c_str());
+                return;
+            }
+            std::string code = startupScript(i);
+            fwrite(code.data(), 1, code.size(), file);
+            fclose(file);
+            paths.push_back(path);
+        }
+
+        ECS::World world;
+        LuaJIT cooker;
+        if (!cooker.init(world)) {
+            return;
+        }
+        uint64_t cookStart = Core::nowNanoseconds();
+        LuaCookStats cooked = cookLuaDirectory(cooker.state(), sourceRoot, cookedRoot, false);
+        double cookMs = Core::nanosecondsToMilliseconds(Core::nowNanoseconds() - cookStart);
+        uint64_t recookStart = Core::nowNanoseconds();
+        LuaCookStats recooked = cookLuaDirectory(cooker.state(), sourceRoot, cookedRoot, false);
+        double recookMs = Core::nanosecondsToMilliseconds(Core::nowNanoseconds() - recookStart);
+
+        // both runs start from a warm page cache, source first so it isn't the one paying for cold files
+        uint32_t sourceBytecodeLoads = 0;
+        uint32_t bytecodeLoads = 0;
+        double sourceMs = startupMeasure(paths, sourceRoot, "", sourceBytecodeLoads);
+        double bytecodeMs = startupMeasure(paths, sourceRoot, cookedRoot, bytecodeLoads);
+
+        printf("lua startup benchmark, %u scripts\n", scripts);
+        printf("  cook            %8.2f ms (%u cooked, %u failed)\n", cookMs, cooked.cooked, cooked.failed);
+        printf("  recook          %8.2f ms (%u up to date)\n", recookMs, recooked.upToDate);
+        printf("  load source     %8.2f ms (%.1f us/script)\n", sourceMs, sourceMs * 1000.0 / scripts);
+        printf("  load bytecode   %8.2f ms (%.1f us/script, %u from bytecode, %.1fx faster)\n",
+            bytecodeMs, bytecodeMs * 1000.0 / scripts, bytecodeLoads, sourceMs / bytecodeMs);
+
+        fs::remove_all(root, error);
+    }
+
+} // namespace Engine
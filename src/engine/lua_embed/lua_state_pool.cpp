@@ -0,0 +1,472 @@
+#include "engine/lua_embed/lua_state_pool.hpp"
+#include "engine/jobs/job_system.hpp"
+#include "engine/memory/memory_tracker.hpp"
+#include "engine/memory/pool_allocator.hpp"
+#include "engine/profiler/profiler.hpp"
+
+#include "lua.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+namespace Engine {
+
+    namespace {
+
+        // one tag byte per value, tables are their key/value pairs between TABLE and TABLE_END
+        enum : uint8_t {
+            TAG_NIL,
+            TAG_FALSE,
+            TAG_TRUE,
+            TAG_NUMBER,
+            TAG_STRING,
+            TAG_TABLE,
+            TAG_TABLE_END,
+            TAG_BLOB,
+        };
+
+        const int MAX_TABLE_DEPTH = 16;
+        const char* BLOB_METATABLE = "engine.blob";
+
+        // messages are mostly a few dozen bytes, made on the sender's worker and freed on the
+        // receiver's, which is the cross thread pattern the small object pools are built for
+        Memory::Allocator& messageAllocator() {
+            static Memory::TaggedAllocator allocator(Memory::smallObjectAllocator(), Memory::MemoryTag::Lua);
+            return allocator;
+        }
+
+        LuaSharedBlob* newBlob(const char* data, size_t size) {
+            void* memory = Memory::taggedMalloc(Memory::MemoryTag::Lua, sizeof(LuaSharedBlob) + size);
+            LuaSharedBlob* blob = new (memory) LuaSharedBlob;
+            blob->references.store(1, std::memory_order_relaxed);
+            blob->size = (uint32_t)size;
+            memcpy(blob->data, data, size);
+            blob->data[size] = 0;
+            return blob;
+        }
+
+        void retainBlob(LuaSharedBlob* blob) {
+            blob->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void releaseBlob(LuaSharedBlob* blob) {
+            if (blob->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                blob->~LuaSharedBlob();
+                Memory::taggedFree(Memory::MemoryTag::Lua, blob);
+            }
+        }
+
+        LuaSharedBlob* toBlob(lua_State* L, int index) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(luaL_testudata(L, index, BLOB_METATABLE));
+            return slot ? *slot : nullptr;
+        }
+
+        // takes over one reference
+        void pushBlob(lua_State* L, LuaSharedBlob* blob) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(lua_newuserdata(L, sizeof(LuaSharedBlob*)));
+            *slot = blob;
+            luaL_getmetatable(L, BLOB_METATABLE);
+            lua_setmetatable(L, -2);
+        }
+
+        void writeBytes(std::vector<char>& out, const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            out.insert(out.end(), bytes, bytes + size);
+        }
+
+        // appends the value at index, blobs get a reference for the message. returns false for
+        // functions, userdata, threads and tables nested deeper than MAX_TABLE_DEPTH
+        bool serialize(lua_State* L, int index, std::vector<char>& out, int depth) {
+            switch (lua_type(L, index)) {
+            case LUA_TNIL:
+                out.push_back((char)TAG_NIL);
+                return true;
+            case LUA_TBOOLEAN:
+                out.push_back((char)(lua_toboolean(L, index) ? TAG_TRUE : TAG_FALSE));
+                return true;
+            case LUA_TNUMBER: {
+                double number = lua_tonumber(L, index);
+                out.push_back((char)TAG_NUMBER);
+                writeBytes(out, &number, sizeof(number));
+                return true;
+            }
+            case LUA_TSTRING: {
+                size_t length;
+                const char* string = lua_tolstring(L, index, &length);
+                uint32_t size = (uint32_t)length;
+                out.push_back((char)TAG_STRING);
+                writeBytes(out, &size, sizeof(size));
+                writeBytes(out, string, length);
+                return true;
+            }
+            case LUA_TTABLE: {
+                if (depth >= MAX_TABLE_DEPTH || !lua_checkstack(L, 3)) {
+                    return false;
+                }
+                out.push_back((char)TAG_TABLE);
+                lua_pushnil(L);
+                while (lua_next(L, index)) {
+                    int top = lua_gettop(L);
+                    if (!serialize(L, top - 1, out, depth + 1) || !serialize(L, top, out, depth + 1)) {
+                        lua_pop(L, 2);
+                        return false;
+                    }
+                    lua_pop(L, 1);
+                }
+                out.push_back((char)TAG_TABLE_END);
+                return true;
+            }
+            case LUA_TUSERDATA: {
+                LuaSharedBlob* blob = toBlob(L, index);
+                if (!blob) {
+                    return false;
+                }
+                retainBlob(blob);
+                out.push_back((char)TAG_BLOB);
+                writeBytes(out, &blob, sizeof(blob));
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        // walks a payload and drops the blob references it holds, for messages that are never decoded
+        void releasePayload(const char* bytes, uint32_t size) {
+            const char* p = bytes;
+            const char* end = bytes + size;
+            while (p < end) {
+                switch ((uint8_t)*p++) {
+                case TAG_NUMBER:
+                    p += sizeof(double);
+                    break;
+                case TAG_STRING: {
+                    uint32_t length;
+                    memcpy(&length, p, sizeof(length));
+                    p += sizeof(length) + length;
+                    break;
+                }
+                case TAG_BLOB: {
+                    LuaSharedBlob* blob;
+                    memcpy(&blob, p, sizeof(blob));
+                    p += sizeof(blob);
+                    releaseBlob(blob);
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+
+        // pushes the value at p, blob references move to the pushed userdata
+        void deserialize(lua_State* L, const char*& p) {
+            switch ((uint8_t)*p++) {
+            case TAG_FALSE:
+                lua_pushboolean(L, 0);
+                break;
+            case TAG_TRUE:
+                lua_pushboolean(L, 1);
+                break;
+            case TAG_NUMBER: {
+                double number;
+                memcpy(&number, p, sizeof(number));
+                p += sizeof(number);
+                lua_pushnumber(L, number);
+                break;
+            }
+            case TAG_STRING: {
+                uint32_t length;
+                memcpy(&length, p, sizeof(length));
+                p += sizeof(length);
+                lua_pushlstring(L, p, length);
+                p += length;
+                break;
+            }
+            case TAG_TABLE:
+                luaL_checkstack(L, 3, "engine message");
+                lua_newtable(L);
+                while ((uint8_t)*p != TAG_TABLE_END) {
+                    deserialize(L, p);
+                    deserialize(L, p);
+                    lua_rawset(L, -3);
+                }
+                p++;
+                break;
+            case TAG_BLOB: {
+                LuaSharedBlob* blob;
+                memcpy(&blob, p, sizeof(blob));
+                p += sizeof(blob);
+                pushBlob(L, blob);
+                break;
+            }
+            default:
+                lua_pushnil(L);
+                break;
+            }
+        }
+
+        // engine.send(state, value), upvalues are the pool and the sending state's index
+        int luaSend(lua_State* L) {
+            LuaStatePool* pool = static_cast<LuaStatePool*>(lua_touserdata(L, lua_upvalueindex(1)));
+            uint32_t from = (uint32_t)lua_tointeger(L, lua_upvalueindex(2));
+            lua_Integer target = luaL_checkinteger(L, 1);
+            luaL_checkany(L, 2);
+            if (target < 0 || target >= (lua_Integer)pool->stateCount()) {
+                return luaL_error(L, "engine.send: no state %d", (int)target);
+            }
+
+            // each state runs on one thread at a time, so a per thread buffer is never shared
+            static thread_local std::vector<char> buffer;
+            buffer.clear();
+            if (!serialize(L, 2, buffer, 0)) {
+                releasePayload(buffer.data(), (uint32_t)buffer.size());
+                return luaL_error(L, "engine.send: value holds a function, userdata or a too deeply nested table");
+            }
+            uint32_t size = (uint32_t)buffer.size();
+            char* bytes = static_cast<char*>(messageAllocator().allocate(size));
+            memcpy(bytes, buffer.data(), size);
+            lua_pushboolean(L, pool->post((uint32_t)target, from, bytes, size));
+            return 1;
+        }
+
+        int luaShare(lua_State* L) {
+            size_t length;
+            const char* string = luaL_checklstring(L, 1, &length);
+            pushBlob(L, newBlob(string, length));
+            return 1;
+        }
+
+        int luaBlobGc(lua_State* L) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(luaL_checkudata(L, 1, BLOB_METATABLE));
+            if (*slot) {
+                releaseBlob(*slot);
+                *slot = nullptr;
+            }
+            return 0;
+        }
+
+        int luaBlobSize(lua_State* L) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(luaL_checkudata(L, 1, BLOB_METATABLE));
+            lua_pushinteger(L, (*slot)->size);
+            return 1;
+        }
+
+        // the bytes stay valid while the blob userdata is alive, cast with ffi.cast for reads
+        int luaBlobPointer(lua_State* L) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(luaL_checkudata(L, 1, BLOB_METATABLE));
+            lua_pushlightuserdata(L, (*slot)->data);
+            return 1;
+        }
+
+        int luaBlobString(lua_State* L) {
+            LuaSharedBlob** slot = static_cast<LuaSharedBlob**>(luaL_checkudata(L, 1, BLOB_METATABLE));
+            lua_pushlstring(L, (*slot)->data, (*slot)->size);
+            return 1;
+        }
+
+        void installPoolApi(lua_State* L, LuaStatePool* pool, uint32_t index, uint32_t count) {
+            luaL_newmetatable(L, BLOB_METATABLE);
+            lua_pushcfunction(L, luaBlobGc);
+            lua_setfield(L, -2, "__gc");
+            lua_pushcfunction(L, luaBlobSize);
+            lua_setfield(L, -2, "__len");
+            lua_newtable(L);
+            lua_pushcfunction(L, luaBlobPointer);
+            lua_setfield(L, -2, "pointer");
+            lua_pushcfunction(L, luaBlobSize);
+            lua_setfield(L, -2, "size");
+            lua_pushcfunction(L, luaBlobString);
+            lua_setfield(L, -2, "string");
+            lua_setfield(L, -2, "__index");
+            lua_pop(L, 1);
+
+            lua_getglobal(L, "engine");
+            lua_pushinteger(L, index);
+            lua_setfield(L, -2, "state");
+            lua_pushinteger(L, count);
+            lua_setfield(L, -2, "stateCount");
+            lua_pushlightuserdata(L, pool);
+            lua_pushinteger(L, index);
+            lua_pushcclosure(L, luaSend, 2);
+            lua_setfield(L, -2, "send");
+            lua_pushcfunction(L, luaShare);
+            lua_setfield(L, -2, "share");
+            lua_pop(L, 1);
+        }
+
+        void freeMessage(const LuaMessage& message) {
+            releasePayload(message.bytes, message.size);
+            messageAllocator().deallocate(message.bytes, message.size);
+        }
+
+    } // namespace
+
+    LuaStatePool::LuaStatePool() : sent(0), dropped(0), lastStats{} {}
+
+    LuaStatePool::~LuaStatePool() {
+        shutdown();
+    }
+
+    bool LuaStatePool::init(ECS::World& world, uint32_t stateCount) {
+        if (stateCount == 0) {
+            stateCount = 1;
+        }
+        for (uint32_t i = 0; i < stateCount; i++) {
+            std::unique_ptr<State> state(new State());
+            state->lua.reset(new LuaJIT());
+            if (!state->lua->init(world)) {
+                shutdown();
+                return false;
+            }
+            state->lua->setPartition(i, stateCount);
+            installPoolApi(state->lua->state(), this, i, stateCount);
+            state->sendSequence.assign(stateCount, 0);
+            state->delivered = 0;
+            state->updateNanoseconds = 0;
+            states.push_back(std::move(state));
+        }
+        return true;
+    }
+
+    void LuaStatePool::shutdown() {
+        for (std::unique_ptr<State>& state : states) {
+            LuaMessage message;
+            while (state->inbox.pop(message)) {
+                freeMessage(message);
+            }
+            for (const LuaMessage& pending : state->delivering) {
+                freeMessage(pending);
+            }
+            state->delivering.clear();
+        }
+        // closing the states collects the blob userdata, which drops the last blob references
+        states.clear();
+    }
+
+    bool LuaStatePool::runFile(const char* path) {
+        for (std::unique_ptr<State>& state : states) {
+            if (!state->lua->runFile(path)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool LuaStatePool::runString(const char* code, const char* chunkName) {
+        for (std::unique_ptr<State>& state : states) {
+            if (!state->lua->runString(code, chunkName)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool LuaStatePool::post(uint32_t target, uint32_t from, char* bytes, uint32_t size) {
+        State& sender = *states[from];
+        LuaMessage message{from, sender.sendSequence[target], size, bytes};
+        if (!states[target]->inbox.push(message)) {
+            freeMessage(message);
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        sender.sendSequence[target]++;
+        sent.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void LuaStatePool::deliver(State& state) {
+        LuaMessage message;
+        while (state.inbox.pop(message)) {
+            state.delivering.push_back(message);
+        }
+        // queue order depends on thread timing, sender then sequence doesn't
+        std::sort(state.delivering.begin(), state.delivering.end(), [](const LuaMessage& a, const LuaMessage& b) {
+            return a.from != b.from ? a.from < b.from : a.sequence < b.sequence;
+        });
+    }
+
+    void LuaStatePool::runState(uint32_t index, float deltaTime) {
+        PROFILE_SCOPE("lua state");
+        auto start = std::chrono::steady_clock::now();
+        State& state = *states[index];
+        lua_State* L = state.lua->state();
+
+        if (!state.delivering.empty()) {
+            lua_getglobal(L, "engine");
+            lua_getfield(L, -1, "onMessage");
+            bool handled = lua_isfunction(L, -1);
+            for (const LuaMessage& message : state.delivering) {
+                if (handled) {
+                    const char* p = message.bytes;
+                    lua_pushvalue(L, -1);
+                    lua_pushinteger(L, message.from);
+                    deserialize(L, p);
+                    state.lua->call(2, 0);
+                    messageAllocator().deallocate(message.bytes, message.size);
+                } else {
+                    freeMessage(message);
+                }
+            }
+            lua_pop(L, 2);
+            state.delivered += (uint32_t)state.delivering.size();
+            state.delivering.clear();
+        }
+
+        state.lua->runSystems(deltaTime);
+        state.updateNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    void LuaStatePool::update(Jobs::JobSystem& jobs, float deltaTime) {
+        PROFILE_SCOPE("lua state pool");
+        // every sender is idle here, so the inboxes hold exactly last update's messages
+        for (std::unique_ptr<State>& state : states) {
+            deliver(*state);
+            state->lua->setQueriesFrozen(true);
+        }
+        jobs.parallelFor(stateCount(), 1, [this, deltaTime](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                runState(i, deltaTime);
+            }
+        });
+        for (std::unique_ptr<State>& state : states) {
+            state->lua->setQueriesFrozen(false);
+        }
+    }
+
+    void LuaStatePool::endFrame() {
+        LuaPoolStats stats{};
+        uint64_t busiest = 0;
+        uint64_t entities = 0;
+        uint64_t nanoseconds = 0;
+        for (std::unique_ptr<State>& state : states) {
+            state->lua->endFrame(false);
+            const LuaFrameStats& frame = state->lua->lastFrame();
+            stats.calls += frame.calls;
+            entities += frame.entities;
+            nanoseconds += frame.nanoseconds;
+            stats.delivered += state->delivered;
+            busiest = std::max(busiest, state->updateNanoseconds);
+            state->delivered = 0;
+            state->updateNanoseconds = 0;
+        }
+        stats.sent = sent.exchange(0, std::memory_order_relaxed);
+        stats.dropped = dropped.exchange(0, std::memory_order_relaxed);
+        stats.busiestStateMs = (double)busiest / 1e6;
+
+        PROFILE_COUNTER("lua pool calls", stats.calls);
+        PROFILE_COUNTER("lua pool entities", entities);
+        if (entities > 0) {
+            PROFILE_COUNTER("lua pool ns/entity", (double)nanoseconds / entities);
+        }
+        PROFILE_COUNTER("lua messages sent", stats.sent);
+        PROFILE_COUNTER("lua messages dropped", stats.dropped);
+        PROFILE_COUNTER("lua busiest state ms", stats.busiestStateMs);
+        lastStats = stats;
+    }
+
+} // namespace Engine
@@ -0,0 +1,244 @@
+#include "engine/memory/allocator.hpp"
+#include "engine/memory/frame_arena.hpp"
+#include "engine/memory/pool_allocator.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace Engine {
+namespace Memory {
+
+    void* HeapAllocator::allocate(size_t size, size_t alignment) {
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+
+    void HeapAllocator::deallocate(void* pointer, size_t, size_t alignment) {
+        ::operator delete(pointer, std::align_val_t(alignment));
+    }
+
+    Allocator& heapAllocator() {
+        static HeapAllocator allocator;
+        return allocator;
+    }
+
+    // linear arena
+
+    LinearArena::LinearArena(size_t capacity) : capacity(capacity), offset(0), peak(0), spillsSinceReset(0) {
+        memory = static_cast<unsigned char*>(::operator new(capacity, std::align_val_t(64)));
+    }
+
+    LinearArena::~LinearArena() {
+        reset();
+        ::operator delete(memory, std::align_val_t(64));
+    }
+
+    void* LinearArena::allocate(size_t size, size_t alignment) {
+        // reserve enough for worst case padding so a single fetch_add stays lock free
+        size_t reserved = size + alignment - 1;
+        size_t start = offset.fetch_add(reserved, std::memory_order_relaxed);
+        if (start + reserved > capacity) {
+            return spill(size, alignment);
+        }
+        return memory + alignUp(start, alignment);
+    }
+
+    // the slow path of a frame that outgrew the arena, locking is fine here
+    void* LinearArena::spill(size_t size, size_t alignment) {
+        alignment = alignment > DEFAULT_ALIGNMENT ? alignment : DEFAULT_ALIGNMENT;
+        void* pointer = ::operator new(size ? size : 1, std::align_val_t(alignment));
+        std::lock_guard<std::mutex> lock(spillMutex);
+        spills.push_back(Spill{pointer, alignment});
+        spillsSinceReset++;
+        return pointer;
+    }
+
+    void LinearArena::reset() {
+        size_t used = offset.load(std::memory_order_relaxed);
+        if (used > peak) {
+            peak = used;
+        }
+        offset.store(0, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(spillMutex);
+        for (const Spill& spilled : spills) {
+            ::operator delete(spilled.pointer, std::align_val_t(spilled.alignment));
+        }
+        spills.clear();
+        spillsSinceReset = 0;
+    }
+
+    FrameArena::FrameArena(size_t capacityPerFrame)
+        : arenas{LinearArena(capacityPerFrame), LinearArena(capacityPerFrame)}, index(0) {
+    }
+
+    void FrameArena::beginFrame() {
+        index ^= 1;
+        arenas[index].reset();
+    }
+
+    // pools
+
+    PoolAllocator::PoolAllocator(size_t blockSize, size_t blocksPerPage)
+        : blockSize(alignUp(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, DEFAULT_ALIGNMENT)),
+          blocksPerPage(blocksPerPage), freeList(nullptr), pageList(nullptr), pages(0) {
+    }
+
+    PoolAllocator::~PoolAllocator() {
+        while (pageList) {
+            Page* next = pageList->next;
+            ::operator delete(pageList);
+            pageList = next;
+        }
+    }
+
+    void PoolAllocator::grow() {
+        size_t header = alignUp(sizeof(Page), DEFAULT_ALIGNMENT);
+        unsigned char* memory = static_cast<unsigned char*>(::operator new(header + blockSize * blocksPerPage));
+        Page* page = reinterpret_cast<Page*>(memory);
+        page->next = pageList;
+        pageList = page;
+        pages++;
+
+        for (size_t i = blocksPerPage; i > 0; i--) {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(memory + header + (i - 1) * blockSize);
+            block->next = freeList;
+            freeList = block;
+        }
+    }
+
+    void* PoolAllocator::allocate() {
+        if (!freeList) {
+            grow();
+        }
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        return block;
+    }
+
+    void PoolAllocator::deallocate(void* pointer) {
+        if (!pointer) {
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = freeList;
+        freeList = block;
+    }
+
+    static const size_t SIZE_CLASSES[] = {16, 32, 64, 128, 256};
+    static const size_t SIZE_CLASS_COUNT = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+
+    struct ThreadPools {
+        PoolAllocator pools[SIZE_CLASS_COUNT] = {
+            PoolAllocator(16, 256), PoolAllocator(32, 256), PoolAllocator(64, 128),
+            PoolAllocator(128, 64), PoolAllocator(256, 32)
+        };
+    };
+
+    static ThreadPools& threadPools() {
+        // intentionally never freed, see SmallObjectAllocator
+        static thread_local ThreadPools* pools = new ThreadPools();
+        return *pools;
+    }
+
+    static size_t sizeClass(size_t size) {
+        size_t index = 0;
+        while (SIZE_CLASSES[index] < size) {
+            index++;
+        }
+        return index;
+    }
+
+    // blocks move between threads' pools, so live counts are kept process wide
+    static std::atomic<int64_t> smallObjectsLive{0};
+
+    void* SmallObjectAllocator::allocate(size_t size, size_t alignment) {
+        if (size > SMALL_OBJECT_MAX_SIZE || alignment > DEFAULT_ALIGNMENT) {
+            return heapAllocator().allocate(size, alignment);
+        }
+        smallObjectsLive.fetch_add(1, std::memory_order_relaxed);
+        return threadPools().pools[sizeClass(size)].allocate();
+    }
+
+    void SmallObjectAllocator::deallocate(void* pointer, size_t size, size_t alignment) {
+        if (size > SMALL_OBJECT_MAX_SIZE || alignment > DEFAULT_ALIGNMENT) {
+            heapAllocator().deallocate(pointer, size, alignment);
+            return;
+        }
+        if (pointer) {
+            smallObjectsLive.fetch_sub(1, std::memory_order_relaxed);
+        }
+        threadPools().pools[sizeClass(size)].deallocate(pointer);
+    }
+
+    int64_t SmallObjectAllocator::liveCount() {
+        return smallObjectsLive.load(std::memory_order_relaxed);
+    }
+
+    Allocator& smallObjectAllocator() {
+        static SmallObjectAllocator allocator;
+        return allocator;
+    }
+
+    // heap allocation counting
+
+    static std::atomic<uint64_t> heapAllocations{0};
+
+    uint64_t heapAllocationCount() {
+        return heapAllocations.load(std::memory_order_relaxed);
+    }
+
+    void countHeapAllocation() {
+#ifdef ENGINE_TRACK_ALLOCATIONS
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    bool heapAllocationTrackingEnabled() {
+#ifdef ENGINE_TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+} // namespace Memory
+} // namespace Engine
+
+#ifdef ENGINE_TRACK_ALLOCATIONS
+
+// replacing the global allocation functions catches every operator new in the program, the
+// nothrow, array and aligned variants all funnel into these two by default
+void* operator new(size_t size) {
+    Engine::Memory::heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    Engine::Memory::heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (void* pointer = std::aligned_alloc(align, Engine::Memory::alignUp(size ? size : 1, align))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "engine/memory/memory_tracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <stdio.h>
+
+namespace Engine {
+namespace Memory {
+
+    static const char* TAG_NAMES[] = {
+        "ecs", "profiler", "ui", "glfw", "lua", "gpu buffers", "gpu textures"
+    };
+    static_assert(sizeof(TAG_NAMES) / sizeof(TAG_NAMES[0]) == (size_t)MemoryTag::Count, "every tag needs a name");
+
+    struct TagCounters {
+        std::atomic<uint64_t> current{0};
+        std::atomic<uint64_t> peak{0};
+        std::atomic<uint64_t> allocations{0};
+        uint64_t allocationsAtFrameStart = 0;
+        uint64_t frameAllocations = 0;
+    };
+
+    static TagCounters counters[(size_t)MemoryTag::Count];
+
+    // keeps the returned block max aligned, the size lives in the first word
+    static const size_t HEADER_SIZE = DEFAULT_ALIGNMENT;
+
+    const char* memoryTagName(MemoryTag tag) {
+        return tag < MemoryTag::Count ? TAG_NAMES[(size_t)tag] : "unknown";
+    }
+
+    void trackAllocation(MemoryTag tag, size_t size) {
+        TagCounters& tagCounters = counters[(size_t)tag];
+        tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+        uint64_t current = tagCounters.current.fetch_add(size, std::memory_order_relaxed) + size;
+        uint64_t peak = tagCounters.peak.load(std::memory_order_relaxed);
+        while (current > peak && !tagCounters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void trackFree(MemoryTag tag, size_t size) {
+        counters[(size_t)tag].current.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void memoryTrackerEndFrame() {
+        for (TagCounters& tagCounters : counters) {
+            uint64_t allocations = tagCounters.allocations.load(std::memory_order_relaxed);
+            tagCounters.frameAllocations = allocations - tagCounters.allocationsAtFrameStart;
+            tagCounters.allocationsAtFrameStart = allocations;
+        }
+    }
+
+    MemoryTagStats memoryTagStats(MemoryTag tag) {
+        const TagCounters& tagCounters = counters[(size_t)tag];
+        MemoryTagStats stats;
+        stats.currentBytes = tagCounters.current.load(std::memory_order_relaxed);
+        stats.peakBytes = tagCounters.peak.load(std::memory_order_relaxed);
+        stats.totalAllocations = tagCounters.allocations.load(std::memory_order_relaxed);
+        stats.frameAllocations = tagCounters.frameAllocations;
+        return stats;
+    }
+
+    bool dumpMemoryStats(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            fprintf(stderr, "memory: failed to open %s for writing\n", path);
+            return false;
+        }
+        fprintf(file, "tag,current_bytes,peak_bytes,total_allocations,frame_allocations\n");
+        for (size_t i = 0; i < (size_t)MemoryTag::Count; i++) {
+            MemoryTagStats stats = memoryTagStats((MemoryTag)i);
+            fprintf(file, "%s,%llu,%llu,%llu,%llu\n", TAG_NAMES[i], (unsigned long long)stats.currentBytes,
+                (unsigned long long)stats.peakBytes, (unsigned long long)stats.totalAllocations,
+                (unsigned long long)stats.frameAllocations);
+        }
+        fclose(file);
+        printf("memory: stats written to %s\n", path);
+        return true;
+    }
+
+    void* taggedMalloc(MemoryTag tag, size_t size) {
+        countHeapAllocation();
+        unsigned char* block = static_cast<unsigned char*>(std::malloc(HEADER_SIZE + size));
+        if (!block) {
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(block) = size;
+        trackAllocation(tag, size);
+        return block + HEADER_SIZE;
+    }
+
+    void* taggedRealloc(MemoryTag tag, void* pointer, size_t size) {
+        if (!pointer) {
+            return taggedMalloc(tag, size);
+        }
+        unsigned char* block = static_cast<unsigned char*>(pointer) - HEADER_SIZE;
+        size_t oldSize = *reinterpret_cast<size_t*>(block);
+        countHeapAllocation();
+        unsigned char* resized = static_cast<unsigned char*>(std::realloc(block, HEADER_SIZE + size));
+        if (!resized) {
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(resized) = size;
+        trackFree(tag, oldSize);
+        trackAllocation(tag, size);
+        return resized + HEADER_SIZE;
+    }
+
+    void taggedFree(MemoryTag tag, void* pointer) {
+        if (!pointer) {
+            return;
+        }
+        unsigned char* block = static_cast<unsigned char*>(pointer) - HEADER_SIZE;
+        trackFree(tag, *reinterpret_cast<size_t*>(block));
+        std::free(block);
+    }
+
+    void* luaAllocate(void*, void* pointer, size_t oldSize, size_t newSize) {
+        // LuaJIT passes oldSize 0 for a new block, Lua 5.4 would pass a type tag there instead.
+        // either way a null pointer means nothing was allocated yet
+        if (!pointer) {
+            oldSize = 0;
+        }
+        if (newSize == 0) {
+            if (pointer) {
+                trackFree(MemoryTag::Lua, oldSize);
+                std::free(pointer);
+            }
+            return nullptr;
+        }
+        countHeapAllocation();
+        void* resized = std::realloc(pointer, newSize);
+        if (!resized) {
+            return nullptr;
+        }
+        if (pointer) {
+            trackFree(MemoryTag::Lua, oldSize);
+        }
+        trackAllocation(MemoryTag::Lua, newSize);
+        return resized;
+    }
+
+} // namespace Memory
+} // namespace Engine
@@ -0,0 +1,61 @@
+#include "engine/profiler/flight_recorder.hpp"
+#include "engine/profiler/profiler.hpp"
+#include "engine/core/clock.hpp"
+
+#include <stdio.h>
+
+namespace Engine {
+namespace Profiler {
+
+    FlightRecorder::FlightRecorder(const FlightRecorderSettings& recorderSettings)
+        : settings(recorderSettings), frame(0), spikeFrame(0), spikeMs(0.0), pending(false), lastDumpTicks(0), dumps(0) {
+        if (settings.framesBefore + settings.framesAfter + 1 >= FRAME_HISTORY) {
+            settings.framesBefore = FRAME_HISTORY / 2;
+            settings.framesAfter = FRAME_HISTORY / 4;
+        }
+        for (uint64_t& end : frameEnds) {
+            end = 0;
+        }
+    }
+
+    void FlightRecorder::endFrame(bool countable) {
+        if (!settings.enabled) {
+            return;
+        }
+        uint64_t now = ticks();
+        frameEnds[frame % FRAME_HISTORY] = now;
+
+        if (frame > 0 && countable && !pending && dumps < settings.maxDumps) {
+            uint64_t previous = frameEnds[(frame - 1) % FRAME_HISTORY];
+            double ms = Core::nanosecondsToMilliseconds(ticksToNanoseconds(now) - ticksToNanoseconds(previous));
+            bool rateLimited = lastDumpTicks != 0 &&
+                Core::nanosecondsToSeconds(ticksToNanoseconds(now) - ticksToNanoseconds(lastDumpTicks)) < settings.minSecondsBetweenDumps;
+            if (ms > settings.thresholdMs && !rateLimited) {
+                pending = true;
+                spikeFrame = frame;
+                spikeMs = ms;
+            }
+        }
+        if (pending && frame - spikeFrame >= settings.framesAfter) {
+            pending = false;
+            startDump(now);
+        }
+        frame++;
+    }
+
+    void FlightRecorder::startDump(uint64_t endTicks) {
+        // the window opens at the end of the frame before the first one included
+        uint64_t first = spikeFrame > settings.framesBefore ? spikeFrame - settings.framesBefore - 1 : 0;
+        uint64_t startTicks = frameEnds[first % FRAME_HISTORY];
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s_%llu.json", settings.prefix.c_str(), (unsigned long long)spikeFrame);
+        printf("flight recorder: frame %llu took %.1fms, writing %s\n", (unsigned long long)spikeFrame, spikeMs, path);
+
+        queueExport(path, startTicks, endTicks);
+        lastDumpTicks = endTicks;
+        dumps++;
+    }
+
+} // namespace Profiler
+} // namespace Engine
@@ -0,0 +1,332 @@
+#include "engine/profiler/profiler.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/memory/memory_tracker.hpp"
+
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+namespace Engine {
+namespace Profiler {
+
+    namespace {
+
+        struct Calibration {
+            uint64_t baseTicks;
+            uint64_t baseNanoseconds;
+            double nanosecondsPerTick;
+        };
+
+        // pairs the tick counter with the engine clock over a short busy wait, good to well
+        // under a microsecond per second on an invariant TSC
+        const Calibration& calibration() {
+            static const Calibration value = [] {
+                Calibration result;
+                uint64_t startNs = Core::nowNanoseconds();
+                uint64_t startTicks = ticks();
+                uint64_t endNs = startNs;
+                while (endNs - startNs < 20000000ull) {
+                    endNs = Core::nowNanoseconds();
+                }
+                uint64_t endTicks = ticks();
+                result.baseTicks = endTicks;
+                result.baseNanoseconds = endNs;
+                result.nanosecondsPerTick = endTicks > startTicks ? (double)(endNs - startNs) / (double)(endTicks - startTicks) : 1.0;
+                return result;
+            }();
+            return value;
+        }
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadBuffer*> buffers;
+            uint32_t nextThreadId = 1;
+        };
+
+        Registry& registry() {
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+
+        // unnamed buffers are called "thread <id>" until setThreadName
+        ThreadBuffer* createBuffer(const char* name) {
+            // calibrating blocks for a moment, better at registration than in the middle of a frame
+            calibration();
+            ThreadBuffer* buffer = new ThreadBuffer();
+            Memory::trackAllocation(Memory::MemoryTag::Profiler, sizeof(ThreadBuffer));
+            buffer->head.store(0, std::memory_order_relaxed);
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            buffer->threadId = reg.nextThreadId++;
+            if (name) {
+                snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+            } else {
+                snprintf(buffer->name, sizeof(buffer->name), "thread %u", buffer->threadId);
+            }
+            reg.buffers.push_back(buffer);
+            return buffer;
+        }
+
+        // on demand capture, only touched by the thread calling frameMark
+        struct Capture {
+            std::string path;
+            uint32_t framesLeft = 0;
+            uint64_t startTicks = 0;
+            bool requested = false;
+            bool started = false;
+        };
+
+        Capture capture;
+        std::atomic<uint64_t> frames(0);
+
+        // finished captures are written by one long lived thread, started with the first one.
+        // it never records events itself, so it doesn't cost a ring
+        struct CaptureWriter {
+            struct Job {
+                std::string path;
+                uint64_t startTicks;
+                uint64_t endTicks;
+            };
+
+            std::mutex mutex;
+            std::condition_variable queued;
+            std::condition_variable drained;
+            std::deque<Job> jobs;
+            bool writing = false;
+            bool started = false;
+        };
+
+        CaptureWriter& captureWriter() {
+            static CaptureWriter* instance = new CaptureWriter();
+            return *instance;
+        }
+
+        void writeCaptures() {
+            CaptureWriter& writer = captureWriter();
+            std::unique_lock<std::mutex> lock(writer.mutex);
+            while (true) {
+                writer.queued.wait(lock, [&writer] { return !writer.jobs.empty(); });
+                CaptureWriter::Job job = std::move(writer.jobs.front());
+                writer.jobs.pop_front();
+                writer.writing = true;
+                lock.unlock();
+                if (exportTrace(job.path, job.startTicks, job.endTicks)) {
+                    printf("profiler: wrote trace %s\n", job.path.c_str());
+                }
+                lock.lock();
+                writer.writing = false;
+                if (writer.jobs.empty()) {
+                    writer.drained.notify_all();
+                }
+            }
+        }
+
+        void writeEscaped(FILE* file, const char* text) {
+            for (const char* c = text; *c; c++) {
+                if (*c == '"' || *c == '\\') {
+                    fputc('\\', file);
+                }
+                if ((unsigned char)*c >= 0x20) {
+                    fputc(*c, file);
+                }
+            }
+        }
+
+    } // namespace
+
+    ThreadBuffer* registerThread() {
+        localBuffer = createBuffer(nullptr);
+        return localBuffer;
+    }
+
+    void setThreadName(const char* name) {
+        // a new buffer is named before it's registered, nothing can see it half written
+        if (!localBuffer) {
+            localBuffer = createBuffer(name);
+            return;
+        }
+        // exportTrace copies the names under the same lock
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        snprintf(localBuffer->name, sizeof(localBuffer->name), "%s", name);
+    }
+
+    uint64_t ticksToNanoseconds(uint64_t value) {
+        const Calibration& cal = calibration();
+        double delta = ((double)value - (double)cal.baseTicks) * cal.nanosecondsPerTick;
+        return (uint64_t)((double)cal.baseNanoseconds + delta);
+    }
+
+    uint64_t nanosecondsToTicks(uint64_t nanoseconds) {
+        const Calibration& cal = calibration();
+        double delta = ((double)nanoseconds - (double)cal.baseNanoseconds) / cal.nanosecondsPerTick;
+        return (uint64_t)((double)cal.baseTicks + delta);
+    }
+
+    void recordSpan(const char* track, const char* name, uint64_t startNanoseconds, uint64_t endNanoseconds) {
+        // a handful of tracks at most, a linear search by name is plenty
+        static std::vector<ThreadBuffer*> tracks;
+        ThreadBuffer* buffer = nullptr;
+        for (ThreadBuffer* candidate : tracks) {
+            if (strcmp(candidate->name, track) == 0) {
+                buffer = candidate;
+                break;
+            }
+        }
+        if (!buffer) {
+            buffer = createBuffer(track);
+            tracks.push_back(buffer);
+        }
+        uint64_t start = nanosecondsToTicks(startNanoseconds);
+        uint64_t end = nanosecondsToTicks(endNanoseconds);
+        buffer->pushAt(start, EventType::Complete, name, end > start ? end - start : 0);
+    }
+
+    void frameMark() {
+        emit(EventType::FrameMark, "frame");
+        frames.fetch_add(1, std::memory_order_relaxed);
+
+        if (!capture.requested) {
+            return;
+        }
+        uint64_t now = ticks();
+        if (!capture.started) {
+            capture.started = true;
+            capture.startTicks = now;
+            return;
+        }
+        if (--capture.framesLeft == 0) {
+            queueExport(capture.path, capture.startTicks, now);
+            capture.requested = false;
+            capture.started = false;
+        }
+    }
+
+    uint64_t frameNumber() {
+        return frames.load(std::memory_order_relaxed);
+    }
+
+    void requestCapture(uint32_t frameCount, const std::string& path) {
+        if (capture.requested || frameCount == 0) {
+            return;
+        }
+        capture.path = path;
+        capture.framesLeft = frameCount;
+        capture.requested = true;
+        capture.started = false;
+    }
+
+    bool isCapturing() {
+        return capture.requested;
+    }
+
+    void queueExport(const std::string& path, uint64_t startTicks, uint64_t endTicks) {
+        CaptureWriter& writer = captureWriter();
+        {
+            std::lock_guard<std::mutex> lock(writer.mutex);
+            writer.jobs.push_back(CaptureWriter::Job{path, startTicks, endTicks});
+            if (!writer.started) {
+                writer.started = true;
+                std::thread(writeCaptures).detach();
+            }
+        }
+        writer.queued.notify_one();
+    }
+
+    void finishCaptures() {
+        CaptureWriter& writer = captureWriter();
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        writer.drained.wait(lock, [&writer] { return writer.jobs.empty() && !writer.writing; });
+    }
+
+    bool exportTrace(const std::string& path, uint64_t startTicks, uint64_t endTicks) {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "profiler: failed to write %s\n", path.c_str());
+            return false;
+        }
+
+        struct Track {
+            ThreadBuffer* buffer;
+            std::string name;
+        };
+        std::vector<Track> tracks;
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            for (ThreadBuffer* buffer : reg.buffers) {
+                tracks.push_back(Track{buffer, buffer->name});
+            }
+        }
+
+        uint64_t originNs = ticksToNanoseconds(startTicks);
+        std::vector<Event> events;
+        bool first = true;
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for (const Track& track : tracks) {
+            ThreadBuffer* buffer = track.buffer;
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                first ? "" : ",\n", buffer->threadId);
+            writeEscaped(file, track.name.c_str());
+            fprintf(file, "\"}}");
+            first = false;
+
+            // copy first so the owning thread can't lap us while we format, slots it overwrote
+            // or is writing right now fail to read and are left out
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = head > ThreadBuffer::CAPACITY ? head - ThreadBuffer::CAPACITY : 0;
+            events.clear();
+            for (uint64_t i = begin; i < head; i++) {
+                Event event;
+                if (buffer->read(i, event)) {
+                    events.push_back(event);
+                }
+            }
+
+            for (const Event& event : events) {
+                if (event.ticks < startTicks || event.ticks > endTicks) {
+                    continue;
+                }
+                double ts = (double)(ticksToNanoseconds(event.ticks) - originNs) / 1000.0;
+                fprintf(file, ",\n{\"name\":\"");
+                writeEscaped(file, event.name);
+                switch (event.type) {
+                    case EventType::Begin:
+                        fprintf(file, "\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", ts, buffer->threadId);
+                        break;
+                    case EventType::End:
+                        fprintf(file, "\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", ts, buffer->threadId);
+                        break;
+                    case EventType::Complete: {
+                        double duration = (double)event.data * calibration().nanosecondsPerTick / 1000.0;
+                        fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", ts, duration, buffer->threadId);
+                        break;
+                    }
+                    case EventType::Counter: {
+                        double value;
+                        memcpy(&value, &event.data, sizeof(value));
+                        // JSON has no nan or inf, %g would write them anyway and break the file
+                        if (std::isfinite(value)) {
+                            fprintf(file, "\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%g}}", ts, value);
+                        } else {
+                            fprintf(file, "\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":null}}", ts);
+                        }
+                        break;
+                    }
+                    case EventType::FrameMark:
+                        fprintf(file, "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", ts, buffer->threadId);
+                        break;
+                }
+            }
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+        return true;
+    }
+
+} // namespace Profiler
+} // namespace Engine
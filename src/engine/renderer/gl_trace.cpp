@@ -0,0 +1,684 @@
+// the real GL entry points are called from here, so this file includes the tracer header and
+// never engine/renderer/gl.hpp
+#include "engine/renderer/gl_trace.hpp"
+#include "engine/core/clock.hpp"
+
+#include <cstring>
+#include <initializer_list>
+#include <stdio.h>
+#include <string>
+
+namespace Engine {
+namespace Renderer {
+
+    namespace {
+
+        struct Mapping {
+            GLenum target;
+            void* pointer;
+            GLsizeiptr length;
+        };
+
+        struct TraceState {
+            GLFrameStats current;
+            GLFrameStats last;
+            bool inFrame = false;
+            bool warned[GL_FUNCTION_COUNT] = {};
+
+            FILE* file = nullptr;
+            std::string path;
+            uint32_t framesLeft = 0;
+            uint64_t bytesWritten = 0;
+            Mapping mappings[4] = {};
+        };
+
+        TraceState& state() {
+            static TraceState traceState;
+            return traceState;
+        }
+
+        uint64_t signedArg(int64_t value) {
+            return (uint64_t)value;
+        }
+
+        uint64_t floatArg(float value) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        uint64_t pointerArg(const void* pointer) {
+            return (uint64_t)(uintptr_t)pointer;
+        }
+
+        void countCall(GLFunction function, uint64_t start) {
+            uint64_t elapsed = Core::nowNanoseconds() - start;
+            TraceState& trace = state();
+            GLCallCounters& counters = trace.current.functions[(uint32_t)function];
+            counters.calls++;
+            counters.nanoseconds += elapsed;
+            trace.current.totalCalls++;
+            trace.current.totalNanoseconds += elapsed;
+            if (trace.inFrame && glFunctionIsSyncPoint(function)) {
+                trace.current.syncCalls++;
+                if (!trace.warned[(uint32_t)function]) {
+                    trace.warned[(uint32_t)function] = true;
+                    fprintf(stderr, "gl trace: %s called inside the frame loop, it can stall on the driver\n", glFunctionName(function));
+                }
+            }
+        }
+
+        // everything while the file is open, calls between frames (scripts setting uniforms from
+        // the simulation, the GPU profiler's readback) change state the next frame draws with
+        bool recording() {
+            return state().file != nullptr;
+        }
+
+        void record(GLFunction function, std::initializer_list<uint64_t> args, const void* payload = nullptr, size_t payloadBytes = 0) {
+            TraceState& trace = state();
+            GLTraceRecord header;
+            header.function = (uint16_t)function;
+            header.argCount = (uint16_t)args.size();
+            header.payloadBytes = (uint32_t)payloadBytes;
+            fwrite(&header, sizeof(header), 1, trace.file);
+            if (args.size()) {
+                fwrite(args.begin(), sizeof(uint64_t), args.size(), trace.file);
+            }
+            size_t padding = glTracePaddedSize(payloadBytes) - payloadBytes;
+            if (payloadBytes) {
+                static const unsigned char zeros[8] = {};
+                fwrite(payload, 1, payloadBytes, trace.file);
+                fwrite(zeros, 1, padding, trace.file);
+            }
+            trace.bytesWritten += sizeof(header) + args.size() * sizeof(uint64_t) + payloadBytes + padding;
+        }
+
+        // bytes glTexImage2D reads, assumes the default unpack alignment of 4
+        size_t imageBytes(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+            size_t channels = 4;
+            switch (format) {
+                case GL_RED: case GL_DEPTH_COMPONENT: channels = 1; break;
+                case GL_RG: channels = 2; break;
+                case GL_RGB: case GL_BGR: channels = 3; break;
+                default: break;
+            }
+            size_t channelBytes = 1;
+            switch (type) {
+                case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: channelBytes = 2; break;
+                case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: channelBytes = 4; break;
+                default: break;
+            }
+            size_t row = ((size_t)width * channels * channelBytes + 3) & ~(size_t)3;
+            return row * (size_t)height;
+        }
+
+        void recordNames(GLFunction function, GLsizei n, const GLuint* names) {
+            record(function, {signedArg(n)}, names, (size_t)n * sizeof(GLuint));
+        }
+
+    } // namespace
+
+    void glTraceBeginFrame() {
+        TraceState& trace = state();
+        trace.inFrame = true;
+        if (trace.file) {
+            record(GLFunction::FrameBegin, {});
+        }
+    }
+
+    void glTraceEndFrame() {
+        TraceState& trace = state();
+        trace.inFrame = false;
+        trace.last = trace.current;
+        memset(&trace.current, 0, sizeof(trace.current));
+        if (trace.file) {
+            record(GLFunction::FrameEnd, {});
+            if (--trace.framesLeft == 0) {
+                fclose(trace.file);
+                trace.file = nullptr;
+                printf("gl trace: wrote %s (%.1f MB)\n", trace.path.c_str(), (double)trace.bytesWritten / (1024.0 * 1024.0));
+            }
+        }
+    }
+
+    const GLFrameStats& glTraceLastFrame() {
+        return state().last;
+    }
+
+    void glTracePrintStats() {
+        const GLFrameStats& frame = state().last;
+        printf("gl calls last frame: %u calls, %.3fms in the driver, %u sync points\n",
+            frame.totalCalls, Core::nanosecondsToMilliseconds(frame.totalNanoseconds), frame.syncCalls);
+        for (uint32_t i = 0; i < GL_FUNCTION_COUNT; i++) {
+            const GLCallCounters& counters = frame.functions[i];
+            if (counters.calls) {
+                printf("  %-26s %6u calls %8.3fms%s\n", glFunctionName((GLFunction)i), counters.calls,
+                    Core::nanosecondsToMilliseconds(counters.nanoseconds), glFunctionIsSyncPoint((GLFunction)i) ? "  sync" : "");
+            }
+        }
+    }
+
+    bool glTraceStartCapture(const char* path, uint32_t frames) {
+        TraceState& trace = state();
+        if (trace.file || frames == 0) {
+            return false;
+        }
+        trace.file = fopen(path, "wb");
+        if (!trace.file) {
+            fprintf(stderr, "gl trace: failed to open %s for writing\n", path);
+            return false;
+        }
+        // records are small and many, a big buffer keeps fwrite out of the per call cost
+        setvbuf(trace.file, nullptr, _IOFBF, 1 << 20);
+        GLTraceHeader header;
+        memcpy(header.magic, GL_TRACE_MAGIC, sizeof(header.magic));
+        header.version = GL_TRACE_VERSION;
+        header.functionCount = GL_FUNCTION_COUNT;
+        header.reserved = 0;
+        fwrite(&header, sizeof(header), 1, trace.file);
+        trace.path = path;
+        trace.framesLeft = frames;
+        trace.bytesWritten = sizeof(header);
+        return true;
+    }
+
+    bool glTraceIsCapturing() {
+        return state().file != nullptr;
+    }
+
+    // wrappers, each times the real call and records it while capturing
+
+    void glTrace_ActiveTexture(GLenum texture) {
+        uint64_t start = Core::nowNanoseconds();
+        glActiveTexture(texture);
+        countCall(GLFunction::ActiveTexture, start);
+        if (recording()) record(GLFunction::ActiveTexture, {texture});
+    }
+
+    void glTrace_AttachShader(GLuint program, GLuint shader) {
+        uint64_t start = Core::nowNanoseconds();
+        glAttachShader(program, shader);
+        countCall(GLFunction::AttachShader, start);
+        if (recording()) record(GLFunction::AttachShader, {program, shader});
+    }
+
+    void glTrace_BeginQuery(GLenum target, GLuint id) {
+        uint64_t start = Core::nowNanoseconds();
+        glBeginQuery(target, id);
+        countCall(GLFunction::BeginQuery, start);
+        if (recording()) record(GLFunction::BeginQuery, {target, id});
+    }
+
+    void glTrace_BindBuffer(GLenum target, GLuint buffer) {
+        uint64_t start = Core::nowNanoseconds();
+        glBindBuffer(target, buffer);
+        countCall(GLFunction::BindBuffer, start);
+        if (recording()) record(GLFunction::BindBuffer, {target, buffer});
+    }
+
+    void glTrace_BindFramebuffer(GLenum target, GLuint framebuffer) {
+        uint64_t start = Core::nowNanoseconds();
+        glBindFramebuffer(target, framebuffer);
+        countCall(GLFunction::BindFramebuffer, start);
+        if (recording()) record(GLFunction::BindFramebuffer, {target, framebuffer});
+    }
+
+    void glTrace_BindRenderbuffer(GLenum target, GLuint renderbuffer) {
+        uint64_t start = Core::nowNanoseconds();
+        glBindRenderbuffer(target, renderbuffer);
+        countCall(GLFunction::BindRenderbuffer, start);
+        if (recording()) record(GLFunction::BindRenderbuffer, {target, renderbuffer});
+    }
+
+    void glTrace_BindTexture(GLenum target, GLuint texture) {
+        uint64_t start = Core::nowNanoseconds();
+        glBindTexture(target, texture);
+        countCall(GLFunction::BindTexture, start);
+        if (recording()) record(GLFunction::BindTexture, {target, texture});
+    }
+
+    void glTrace_BindVertexArray(GLuint array) {
+        uint64_t start = Core::nowNanoseconds();
+        glBindVertexArray(array);
+        countCall(GLFunction::BindVertexArray, start);
+        if (recording()) record(GLFunction::BindVertexArray, {array});
+    }
+
+    void glTrace_BlendEquation(GLenum mode) {
+        uint64_t start = Core::nowNanoseconds();
+        glBlendEquation(mode);
+        countCall(GLFunction::BlendEquation, start);
+        if (recording()) record(GLFunction::BlendEquation, {mode});
+    }
+
+    void glTrace_BlendFunc(GLenum sfactor, GLenum dfactor) {
+        uint64_t start = Core::nowNanoseconds();
+        glBlendFunc(sfactor, dfactor);
+        countCall(GLFunction::BlendFunc, start);
+        if (recording()) record(GLFunction::BlendFunc, {sfactor, dfactor});
+    }
+
+    void glTrace_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+        uint64_t start = Core::nowNanoseconds();
+        glBufferData(target, size, data, usage);
+        countCall(GLFunction::BufferData, start);
+        if (recording()) record(GLFunction::BufferData, {target, signedArg(size), usage, data != nullptr}, data, data ? (size_t)size : 0);
+    }
+
+    GLenum glTrace_CheckFramebufferStatus(GLenum target) {
+        uint64_t start = Core::nowNanoseconds();
+        GLenum status = glCheckFramebufferStatus(target);
+        countCall(GLFunction::CheckFramebufferStatus, start);
+        if (recording()) record(GLFunction::CheckFramebufferStatus, {target});
+        return status;
+    }
+
+    void glTrace_Clear(GLbitfield mask) {
+        uint64_t start = Core::nowNanoseconds();
+        glClear(mask);
+        countCall(GLFunction::Clear, start);
+        if (recording()) record(GLFunction::Clear, {mask});
+    }
+
+    void glTrace_CompileShader(GLuint shader) {
+        uint64_t start = Core::nowNanoseconds();
+        glCompileShader(shader);
+        countCall(GLFunction::CompileShader, start);
+        if (recording()) record(GLFunction::CompileShader, {shader});
+    }
+
+    GLuint glTrace_CreateProgram() {
+        uint64_t start = Core::nowNanoseconds();
+        GLuint program = glCreateProgram();
+        countCall(GLFunction::CreateProgram, start);
+        if (recording()) record(GLFunction::CreateProgram, {program});
+        return program;
+    }
+
+    GLuint glTrace_CreateShader(GLenum type) {
+        uint64_t start = Core::nowNanoseconds();
+        GLuint shader = glCreateShader(type);
+        countCall(GLFunction::CreateShader, start);
+        if (recording()) record(GLFunction::CreateShader, {type, shader});
+        return shader;
+    }
+
+    void glTrace_DeleteBuffers(GLsizei n, const GLuint* buffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteBuffers(n, buffers);
+        countCall(GLFunction::DeleteBuffers, start);
+        if (recording()) recordNames(GLFunction::DeleteBuffers, n, buffers);
+    }
+
+    void glTrace_DeleteFramebuffers(GLsizei n, const GLuint* framebuffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteFramebuffers(n, framebuffers);
+        countCall(GLFunction::DeleteFramebuffers, start);
+        if (recording()) recordNames(GLFunction::DeleteFramebuffers, n, framebuffers);
+    }
+
+    void glTrace_DeleteQueries(GLsizei n, const GLuint* ids) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteQueries(n, ids);
+        countCall(GLFunction::DeleteQueries, start);
+        if (recording()) recordNames(GLFunction::DeleteQueries, n, ids);
+    }
+
+    void glTrace_DeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteRenderbuffers(n, renderbuffers);
+        countCall(GLFunction::DeleteRenderbuffers, start);
+        if (recording()) recordNames(GLFunction::DeleteRenderbuffers, n, renderbuffers);
+    }
+
+    void glTrace_DeleteShader(GLuint shader) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteShader(shader);
+        countCall(GLFunction::DeleteShader, start);
+        if (recording()) record(GLFunction::DeleteShader, {shader});
+    }
+
+    void glTrace_DeleteTextures(GLsizei n, const GLuint* textures) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteTextures(n, textures);
+        countCall(GLFunction::DeleteTextures, start);
+        if (recording()) recordNames(GLFunction::DeleteTextures, n, textures);
+    }
+
+    void glTrace_DeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+        uint64_t start = Core::nowNanoseconds();
+        glDeleteVertexArrays(n, arrays);
+        countCall(GLFunction::DeleteVertexArrays, start);
+        if (recording()) recordNames(GLFunction::DeleteVertexArrays, n, arrays);
+    }
+
+    void glTrace_Disable(GLenum cap) {
+        uint64_t start = Core::nowNanoseconds();
+        glDisable(cap);
+        countCall(GLFunction::Disable, start);
+        if (recording()) record(GLFunction::Disable, {cap});
+    }
+
+    void glTrace_DrawArrays(GLenum mode, GLint first, GLsizei count) {
+        uint64_t start = Core::nowNanoseconds();
+        glDrawArrays(mode, first, count);
+        countCall(GLFunction::DrawArrays, start);
+        if (recording()) record(GLFunction::DrawArrays, {mode, signedArg(first), signedArg(count)});
+    }
+
+    void glTrace_DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+        uint64_t start = Core::nowNanoseconds();
+        glDrawElements(mode, count, type, indices);
+        countCall(GLFunction::DrawElements, start);
+        // indices is an offset into the bound element buffer, the engine never draws from client memory
+        if (recording()) record(GLFunction::DrawElements, {mode, signedArg(count), type, pointerArg(indices)});
+    }
+
+    void glTrace_Enable(GLenum cap) {
+        uint64_t start = Core::nowNanoseconds();
+        glEnable(cap);
+        countCall(GLFunction::Enable, start);
+        if (recording()) record(GLFunction::Enable, {cap});
+    }
+
+    void glTrace_EnableVertexAttribArray(GLuint index) {
+        uint64_t start = Core::nowNanoseconds();
+        glEnableVertexAttribArray(index);
+        countCall(GLFunction::EnableVertexAttribArray, start);
+        if (recording()) record(GLFunction::EnableVertexAttribArray, {index});
+    }
+
+    void glTrace_EndQuery(GLenum target) {
+        uint64_t start = Core::nowNanoseconds();
+        glEndQuery(target);
+        countCall(GLFunction::EndQuery, start);
+        if (recording()) record(GLFunction::EndQuery, {target});
+    }
+
+    void glTrace_Finish() {
+        uint64_t start = Core::nowNanoseconds();
+        glFinish();
+        countCall(GLFunction::Finish, start);
+        if (recording()) record(GLFunction::Finish, {});
+    }
+
+    void glTrace_FramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+        uint64_t start = Core::nowNanoseconds();
+        glFramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+        countCall(GLFunction::FramebufferRenderbuffer, start);
+        if (recording()) record(GLFunction::FramebufferRenderbuffer, {target, attachment, renderbuffertarget, renderbuffer});
+    }
+
+    void glTrace_GenBuffers(GLsizei n, GLuint* buffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenBuffers(n, buffers);
+        countCall(GLFunction::GenBuffers, start);
+        if (recording()) recordNames(GLFunction::GenBuffers, n, buffers);
+    }
+
+    void glTrace_GenFramebuffers(GLsizei n, GLuint* framebuffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenFramebuffers(n, framebuffers);
+        countCall(GLFunction::GenFramebuffers, start);
+        if (recording()) recordNames(GLFunction::GenFramebuffers, n, framebuffers);
+    }
+
+    void glTrace_GenQueries(GLsizei n, GLuint* ids) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenQueries(n, ids);
+        countCall(GLFunction::GenQueries, start);
+        if (recording()) recordNames(GLFunction::GenQueries, n, ids);
+    }
+
+    void glTrace_GenRenderbuffers(GLsizei n, GLuint* renderbuffers) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenRenderbuffers(n, renderbuffers);
+        countCall(GLFunction::GenRenderbuffers, start);
+        if (recording()) recordNames(GLFunction::GenRenderbuffers, n, renderbuffers);
+    }
+
+    void glTrace_GenTextures(GLsizei n, GLuint* textures) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenTextures(n, textures);
+        countCall(GLFunction::GenTextures, start);
+        if (recording()) recordNames(GLFunction::GenTextures, n, textures);
+    }
+
+    void glTrace_GenVertexArrays(GLsizei n, GLuint* arrays) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenVertexArrays(n, arrays);
+        countCall(GLFunction::GenVertexArrays, start);
+        if (recording()) recordNames(GLFunction::GenVertexArrays, n, arrays);
+    }
+
+    void glTrace_GenerateMipmap(GLenum target) {
+        uint64_t start = Core::nowNanoseconds();
+        glGenerateMipmap(target);
+        countCall(GLFunction::GenerateMipmap, start);
+        if (recording()) record(GLFunction::GenerateMipmap, {target});
+    }
+
+    void glTrace_GetFloatv(GLenum pname, GLfloat* data) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetFloatv(pname, data);
+        countCall(GLFunction::GetFloatv, start);
+        if (recording()) record(GLFunction::GetFloatv, {pname});
+    }
+
+    void glTrace_GetInteger64v(GLenum pname, GLint64* data) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetInteger64v(pname, data);
+        countCall(GLFunction::GetInteger64v, start);
+        if (recording()) record(GLFunction::GetInteger64v, {pname});
+    }
+
+    void glTrace_GetIntegerv(GLenum pname, GLint* data) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetIntegerv(pname, data);
+        countCall(GLFunction::GetIntegerv, start);
+        if (recording()) record(GLFunction::GetIntegerv, {pname});
+    }
+
+    void glTrace_GetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetProgramInfoLog(program, bufSize, length, infoLog);
+        countCall(GLFunction::GetProgramInfoLog, start);
+        if (recording()) record(GLFunction::GetProgramInfoLog, {program, signedArg(bufSize)});
+    }
+
+    void glTrace_GetProgramiv(GLuint program, GLenum pname, GLint* params) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetProgramiv(program, pname, params);
+        countCall(GLFunction::GetProgramiv, start);
+        if (recording()) record(GLFunction::GetProgramiv, {program, pname});
+    }
+
+    void glTrace_GetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetQueryObjectui64v(id, pname, params);
+        countCall(GLFunction::GetQueryObjectui64v, start);
+        if (recording()) record(GLFunction::GetQueryObjectui64v, {id, pname});
+    }
+
+    void glTrace_GetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetShaderInfoLog(shader, bufSize, length, infoLog);
+        countCall(GLFunction::GetShaderInfoLog, start);
+        if (recording()) record(GLFunction::GetShaderInfoLog, {shader, signedArg(bufSize)});
+    }
+
+    void glTrace_GetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+        uint64_t start = Core::nowNanoseconds();
+        glGetShaderiv(shader, pname, params);
+        countCall(GLFunction::GetShaderiv, start);
+        if (recording()) record(GLFunction::GetShaderiv, {shader, pname});
+    }
+
+    const GLubyte* glTrace_GetString(GLenum name) {
+        uint64_t start = Core::nowNanoseconds();
+        const GLubyte* string = glGetString(name);
+        countCall(GLFunction::GetString, start);
+        if (recording()) record(GLFunction::GetString, {name});
+        return string;
+    }
+
+    GLint glTrace_GetUniformLocation(GLuint program, const GLchar* name) {
+        uint64_t start = Core::nowNanoseconds();
+        GLint location = glGetUniformLocation(program, name);
+        countCall(GLFunction::GetUniformLocation, start);
+        if (recording()) record(GLFunction::GetUniformLocation, {program, signedArg(location)}, name, strlen(name) + 1);
+        return location;
+    }
+
+    void glTrace_LinkProgram(GLuint program) {
+        uint64_t start = Core::nowNanoseconds();
+        glLinkProgram(program);
+        countCall(GLFunction::LinkProgram, start);
+        if (recording()) record(GLFunction::LinkProgram, {program});
+    }
+
+    void* glTrace_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+        uint64_t start = Core::nowNanoseconds();
+        void* pointer = glMapBufferRange(target, offset, length, access);
+        countCall(GLFunction::MapBufferRange, start);
+        // remembered so the unmap can record what was written through the pointer
+        for (Mapping& mapping : state().mappings) {
+            if (!mapping.pointer || mapping.target == target) {
+                mapping = Mapping{target, pointer, pointer ? length : 0};
+                break;
+            }
+        }
+        if (recording()) record(GLFunction::MapBufferRange, {target, signedArg(offset), signedArg(length), access});
+        return pointer;
+    }
+
+    void glTrace_QueryCounter(GLuint id, GLenum target) {
+        uint64_t start = Core::nowNanoseconds();
+        glQueryCounter(id, target);
+        countCall(GLFunction::QueryCounter, start);
+        if (recording()) record(GLFunction::QueryCounter, {id, target});
+    }
+
+    void glTrace_ReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels) {
+        uint64_t start = Core::nowNanoseconds();
+        glReadPixels(x, y, width, height, format, type, pixels);
+        countCall(GLFunction::ReadPixels, start);
+        if (recording()) record(GLFunction::ReadPixels, {signedArg(x), signedArg(y), signedArg(width), signedArg(height), format, type});
+    }
+
+    void glTrace_RenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height) {
+        uint64_t start = Core::nowNanoseconds();
+        glRenderbufferStorage(target, internalformat, width, height);
+        countCall(GLFunction::RenderbufferStorage, start);
+        if (recording()) record(GLFunction::RenderbufferStorage, {target, internalformat, signedArg(width), signedArg(height)});
+    }
+
+    void glTrace_Scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        uint64_t start = Core::nowNanoseconds();
+        glScissor(x, y, width, height);
+        countCall(GLFunction::Scissor, start);
+        if (recording()) record(GLFunction::Scissor, {signedArg(x), signedArg(y), signedArg(width), signedArg(height)});
+    }
+
+    void glTrace_ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+        uint64_t start = Core::nowNanoseconds();
+        glShaderSource(shader, count, string, length);
+        countCall(GLFunction::ShaderSource, start);
+        if (recording()) {
+            // stored as one string, the replay hands it back with a single glShaderSource
+            std::string source;
+            for (GLsizei i = 0; i < count; i++) {
+                if (length && length[i] >= 0) {
+                    source.append(string[i], (size_t)length[i]);
+                } else {
+                    source.append(string[i]);
+                }
+            }
+            record(GLFunction::ShaderSource, {shader}, source.data(), source.size());
+        }
+    }
+
+    void glTrace_TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+        uint64_t start = Core::nowNanoseconds();
+        glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+        countCall(GLFunction::TexImage2D, start);
+        if (recording()) {
+            record(GLFunction::TexImage2D, {target, signedArg(level), signedArg(internalformat), signedArg(width), signedArg(height),
+                signedArg(border), format, type, pixels != nullptr}, pixels, pixels ? imageBytes(width, height, format, type) : 0);
+        }
+    }
+
+    void glTrace_TexParameteri(GLenum target, GLenum pname, GLint param) {
+        uint64_t start = Core::nowNanoseconds();
+        glTexParameteri(target, pname, param);
+        countCall(GLFunction::TexParameteri, start);
+        if (recording()) record(GLFunction::TexParameteri, {target, pname, signedArg(param)});
+    }
+
+    void glTrace_Uniform1f(GLint location, GLfloat v0) {
+        uint64_t start = Core::nowNanoseconds();
+        glUniform1f(location, v0);
+        countCall(GLFunction::Uniform1f, start);
+        if (recording()) record(GLFunction::Uniform1f, {signedArg(location), floatArg(v0)});
+    }
+
+    void glTrace_Uniform1i(GLint location, GLint v0) {
+        uint64_t start = Core::nowNanoseconds();
+        glUniform1i(location, v0);
+        countCall(GLFunction::Uniform1i, start);
+        if (recording()) record(GLFunction::Uniform1i, {signedArg(location), signedArg(v0)});
+    }
+
+    void glTrace_UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+        uint64_t start = Core::nowNanoseconds();
+        glUniformMatrix4fv(location, count, transpose, value);
+        countCall(GLFunction::UniformMatrix4fv, start);
+        if (recording()) {
+            record(GLFunction::UniformMatrix4fv, {signedArg(location), signedArg(count), transpose}, value, (size_t)count * 16 * sizeof(GLfloat));
+        }
+    }
+
+    GLboolean glTrace_UnmapBuffer(GLenum target) {
+        // the mapped bytes have to be captured before the pointer goes away
+        Mapping* mapped = nullptr;
+        for (Mapping& mapping : state().mappings) {
+            if (mapping.pointer && mapping.target == target) {
+                mapped = &mapping;
+                break;
+            }
+        }
+        if (recording()) {
+            record(GLFunction::UnmapBuffer, {target}, mapped ? mapped->pointer : nullptr, mapped ? (size_t)mapped->length : 0);
+        }
+        if (mapped) {
+            *mapped = Mapping{0, nullptr, 0};
+        }
+        uint64_t start = Core::nowNanoseconds();
+        GLboolean result = glUnmapBuffer(target);
+        countCall(GLFunction::UnmapBuffer, start);
+        return result;
+    }
+
+    void glTrace_UseProgram(GLuint program) {
+        uint64_t start = Core::nowNanoseconds();
+        glUseProgram(program);
+        countCall(GLFunction::UseProgram, start);
+        if (recording()) record(GLFunction::UseProgram, {program});
+    }
+
+    void glTrace_VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+        uint64_t start = Core::nowNanoseconds();
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+        countCall(GLFunction::VertexAttribPointer, start);
+        if (recording()) record(GLFunction::VertexAttribPointer, {index, signedArg(size), type, normalized, signedArg(stride), pointerArg(pointer)});
+    }
+
+    void glTrace_Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        uint64_t start = Core::nowNanoseconds();
+        glViewport(x, y, width, height);
+        countCall(GLFunction::Viewport, start);
+        if (recording()) record(GLFunction::Viewport, {signedArg(x), signedArg(y), signedArg(width), signedArg(height)});
+    }
+
+} // namespace Renderer
+} // namespace Engine
@@ -0,0 +1,211 @@
+#include "engine/renderer/gpu_profiler.hpp"
+#include "engine/core/clock.hpp"
+
+#include "engine/renderer/gl.hpp"
+
+#include <cstring>
+#include <stdio.h>
+
+namespace Engine {
+namespace Renderer {
+
+    static const uint64_t CALIBRATION_INTERVAL = 256;
+
+    GpuProfiler::GpuProfiler()
+        : frameNumber(0), depth(0), recording(false), initialized(false), enabled(true), resolvedFrame(0), droppedFrames(0),
+          clockOffset(0) {
+        for (Frame& frame : frames) {
+            frame.number = 0;
+            frame.scopeCount = 0;
+            frame.pending = false;
+        }
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        shutdown();
+    }
+
+    void GpuProfiler::init() {
+        queries.resize(FRAME_LATENCY * MAX_SCOPES_PER_FRAME * 2);
+        glGenQueries((GLsizei)queries.size(), queries.data());
+        resolvedEvents.reserve(MAX_SCOPES_PER_FRAME);
+        stats.reserve(MAX_SCOPES_PER_FRAME);
+        histories.reserve(MAX_SCOPES_PER_FRAME);
+        initialized = true;
+        calibrate();
+    }
+
+    void GpuProfiler::shutdown() {
+        if (!initialized) {
+            return;
+        }
+        glDeleteQueries((GLsizei)queries.size(), queries.data());
+        queries.clear();
+        initialized = false;
+    }
+
+    unsigned int GpuProfiler::query(uint32_t slot, uint32_t scope, bool end) const {
+        return queries[(slot * MAX_SCOPES_PER_FRAME + scope) * 2 + (end ? 1 : 0)];
+    }
+
+    void GpuProfiler::calibrate() {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        clockOffset = (int64_t)Core::nowNanoseconds() - (int64_t)gpuNow;
+    }
+
+    void GpuProfiler::setEnabled(bool value) {
+        if (enabled && !value) {
+            for (Frame& frame : frames) {
+                frame.pending = false;
+            }
+            recording = false;
+        }
+        enabled = value;
+    }
+
+    void GpuProfiler::collect() {
+        if (!initialized || !enabled) {
+            return;
+        }
+        uint64_t next = frameNumber + 1;
+        uint32_t slot = (uint32_t)(next % FRAME_LATENCY);
+        Frame& frame = frames[slot];
+        if (frame.pending) {
+            if (resultsAvailable(frame, slot)) {
+                resolve(frame, slot);
+            } else {
+                frame.pending = false;
+                droppedFrames++;
+            }
+        }
+        if (next % CALIBRATION_INTERVAL == 0) {
+            calibrate();
+        }
+    }
+
+    void GpuProfiler::beginFrame() {
+        if (!initialized || !enabled) {
+            return;
+        }
+        frameNumber++;
+        uint32_t slot = (uint32_t)(frameNumber % FRAME_LATENCY);
+        Frame& frame = frames[slot];
+        // not collected, its queries are about to be reused
+        if (frame.pending) {
+            droppedFrames++;
+        }
+        frame.number = frameNumber;
+        frame.scopeCount = 0;
+        frame.pending = true;
+        depth = 0;
+        recording = true;
+    }
+
+    void GpuProfiler::endFrame() {
+        recording = false;
+    }
+
+    uint32_t GpuProfiler::beginScope(const char* name) {
+        if (!recording) {
+            return UINT32_MAX;
+        }
+        uint32_t slot = (uint32_t)(frameNumber % FRAME_LATENCY);
+        Frame& frame = frames[slot];
+        if (frame.scopeCount >= MAX_SCOPES_PER_FRAME) {
+            return UINT32_MAX;
+        }
+        uint32_t scope = frame.scopeCount++;
+        frame.scopes[scope] = Scope{name, depth, false};
+        depth++;
+        glQueryCounter(query(slot, scope, false), GL_TIMESTAMP);
+        return scope;
+    }
+
+    void GpuProfiler::endScope(uint32_t scope) {
+        if (!recording || scope == UINT32_MAX) {
+            return;
+        }
+        uint32_t slot = (uint32_t)(frameNumber % FRAME_LATENCY);
+        frames[slot].scopes[scope].closed = true;
+        depth--;
+        glQueryCounter(query(slot, scope, true), GL_TIMESTAMP);
+    }
+
+    bool GpuProfiler::resultsAvailable(const Frame& frame, uint32_t slot) const {
+        for (uint32_t scope = 0; scope < frame.scopeCount; scope++) {
+            if (!frame.scopes[scope].closed) {
+                continue;
+            }
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(query(slot, scope, false), GL_QUERY_RESULT_AVAILABLE, &begin);
+            glGetQueryObjectui64v(query(slot, scope, true), GL_QUERY_RESULT_AVAILABLE, &end);
+            if (!begin || !end) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void GpuProfiler::resolve(Frame& frame, uint32_t slot) {
+        frame.pending = false;
+        resolvedEvents.clear();
+        resolvedFrame = frame.number;
+
+        for (uint32_t scope = 0; scope < frame.scopeCount; scope++) {
+            const Scope& info = frame.scopes[scope];
+            if (!info.closed) {
+                continue;
+            }
+            // resultsAvailable() checked every query, this doesn't wait
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(query(slot, scope, false), GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(query(slot, scope, true), GL_QUERY_RESULT, &end);
+            if (end < begin) {
+                end = begin;
+            }
+            resolvedEvents.push_back(GpuScopeEvent{info.name, info.depth,
+                (uint64_t)((int64_t)begin + clockOffset), (uint64_t)((int64_t)end + clockOffset)});
+
+            double ms = Core::nanosecondsToMilliseconds(end - begin);
+            size_t index = statsIndex(info.name, info.depth);
+            History& history = histories[index];
+            if (history.count == AVERAGE_WINDOW) {
+                history.sum -= history.samples[history.next];
+            } else {
+                history.count++;
+            }
+            history.samples[history.next] = ms;
+            history.next = (history.next + 1) % AVERAGE_WINDOW;
+            history.sum += ms;
+            stats[index].lastMs = ms;
+            stats[index].averageMs = history.sum / (double)history.count;
+        }
+    }
+
+    size_t GpuProfiler::statsIndex(const char* name, uint32_t depth) {
+        for (size_t i = 0; i < stats.size(); i++) {
+            if (stats[i].depth == depth && (stats[i].name == name || strcmp(stats[i].name, name) == 0)) {
+                return i;
+            }
+        }
+        stats.push_back(GpuScopeStats{name, depth, 0.0, 0.0});
+        History history;
+        history.count = 0;
+        history.next = 0;
+        history.sum = 0.0;
+        histories.push_back(history);
+        return stats.size() - 1;
+    }
+
+    void GpuProfiler::printStats() const {
+        printf("gpu scopes (frame %llu, %llu frames dropped):\n", (unsigned long long)resolvedFrame,
+            (unsigned long long)droppedFrames);
+        for (const GpuScopeStats& scope : stats) {
+            printf("  %*s%-*s last %.3fms, avg %.3fms\n", (int)scope.depth * 2, "", 24 - (int)scope.depth * 2,
+                scope.name, scope.lastMs, scope.averageMs);
+        }
+    }
+
+} // namespace Renderer
+} // namespace Engine
@@ -0,0 +1,132 @@
+#include "engine/renderer/headless_context.hpp"
+
+// plain EGL here on purpose, eglew only loads its entry points once a display already exists
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <stdio.h>
+
+namespace Engine {
+namespace Renderer {
+
+    static bool hasExtension(const char* extensions, const char* name) {
+        if (!extensions) {
+            return false;
+        }
+        size_t length = strlen(name);
+        for (const char* found = strstr(extensions, name); found; found = strstr(found + 1, name)) {
+            if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    HeadlessContext::HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), surface(EGL_NO_SURFACE), mode("") {
+    }
+
+    HeadlessContext::~HeadlessContext() {
+        destroy();
+    }
+
+    bool HeadlessContext::create(int majorVersion, int minorVersion) {
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+        bool surfaceless = false;
+
+        if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay) {
+                eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            }
+        }
+        if (eglDisplay == EGL_NO_DISPLAY) {
+            eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+
+        EGLint major, minor;
+        if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+            fprintf(stderr, "headless: failed to initialize an EGL display (0x%x)\n", eglGetError());
+            return false;
+        }
+        display = eglDisplay;
+        surfaceless = hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            fprintf(stderr, "headless: EGL display has no desktop OpenGL support\n");
+            destroy();
+            return false;
+        }
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            fprintf(stderr, "headless: no matching EGL config (0x%x)\n", eglGetError());
+            destroy();
+            return false;
+        }
+
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+            EGL_CONTEXT_MINOR_VERSION, minorVersion,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT) {
+            fprintf(stderr, "headless: failed to create an OpenGL %d.%d core context (0x%x)\n", majorVersion, minorVersion, eglGetError());
+            destroy();
+            return false;
+        }
+
+        if (!surfaceless) {
+            const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            surface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+            if (surface == EGL_NO_SURFACE) {
+                fprintf(stderr, "headless: failed to create a pbuffer surface (0x%x)\n", eglGetError());
+                destroy();
+                return false;
+            }
+        }
+        mode = surfaceless ? "surfaceless" : "pbuffer";
+        return makeCurrent();
+    }
+
+    bool HeadlessContext::makeCurrent() {
+        if (!eglMakeCurrent((EGLDisplay)display, (EGLSurface)surface, (EGLSurface)surface, (EGLContext)context)) {
+            fprintf(stderr, "headless: eglMakeCurrent failed (0x%x)\n", eglGetError());
+            return false;
+        }
+        return true;
+    }
+
+    void HeadlessContext::destroy() {
+        if (display == EGL_NO_DISPLAY) {
+            return;
+        }
+        eglMakeCurrent((EGLDisplay)display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE) {
+            eglDestroySurface((EGLDisplay)display, (EGLSurface)surface);
+        }
+        if (context != EGL_NO_CONTEXT) {
+            eglDestroyContext((EGLDisplay)display, (EGLContext)context);
+        }
+        eglTerminate((EGLDisplay)display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+        surface = EGL_NO_SURFACE;
+        mode = "";
+    }
+
+} // namespace Renderer
+} // namespace Engine
@@ -4,7 +4,7 @@
 #   include "engine/renderer/shader.hpp"
 #endif
 
-#include "GL/glew.h"
+#include "engine/renderer/gl.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
 #include <stdio.h>
@@ -59,23 +59,35 @@ namespace Renderer {
         glUseProgram(ID);
     }
 
-    void ShaderProgram::setBool(const std::string &name, bool value) const {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    void ShaderProgram::setBool(const char* name, bool value) const {         
+        glUniform1i(glGetUniformLocation(ID, name), (int)value); 
     }
 
-    void ShaderProgram::setInt(const std::string &name, int value) const { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    void ShaderProgram::setInt(const char* name, int value) const { 
+        glUniform1i(glGetUniformLocation(ID, name), value); 
     }
 
-    void ShaderProgram::setFloat(const std::string &name, float value) const { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    void ShaderProgram::setFloat(const char* name, float value) const { 
+        glUniform1f(glGetUniformLocation(ID, name), value); 
     }
 
-    void ShaderProgram::setMat4(const std::string &name, glm::mat4 value) const {
-        int mat4Loc = glGetUniformLocation(ID, name.c_str());
+    void ShaderProgram::setMat4(const char* name, glm::mat4 value) const {
+        int mat4Loc = glGetUniformLocation(ID, name);
         glUniformMatrix4fv(mat4Loc, 1, GL_FALSE, glm::value_ptr(value));
     }
 
+    int ShaderProgram::uniformLocation(const char* name) const {
+        return glGetUniformLocation(ID, name);
+    }
+
+    void ShaderProgram::setIntAt(int location, int value) const {
+        glUniform1i(location, value);
+    }
+
+    void ShaderProgram::setMat4At(int location, const glm::mat4& value) const {
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
     char* ShaderProgram::readShaderFile(const char* fileName) {
         FILE* file = fopen(fileName, "rb");
         if (!file) {
@@ -0,0 +1,155 @@
+#include "engine/renderer/window.hpp"
+#include "engine/memory/memory_tracker.hpp"
+
+#include "engine/renderer/gl.hpp"
+#include "GLFW/glfw3.h"
+
+#include <stdio.h>
+
+namespace Engine {
+namespace Renderer {
+
+    static void* glfwAllocate(size_t size, void*) {
+        return Memory::taggedMalloc(Memory::MemoryTag::Glfw, size);
+    }
+
+    static void* glfwReallocate(void* block, size_t size, void*) {
+        return Memory::taggedRealloc(Memory::MemoryTag::Glfw, block, size);
+    }
+
+    static void glfwDeallocate(void* block, void*) {
+        Memory::taggedFree(Memory::MemoryTag::Glfw, block);
+    }
+
+    // RGBA8 color plus DEPTH24_STENCIL8, four bytes a pixel each
+    static size_t framebufferBytes(int width, int height) {
+        return (size_t)width * (size_t)height * 8;
+    }
+
+    Window::Window()
+        : window(nullptr), framebuffer(0), colorBuffer(0), depthBuffer(0), closeRequested(false), glfwInitialized(false) {
+    }
+
+    Window::~Window() {
+        destroy();
+    }
+
+    bool Window::create(const WindowSettings& windowSettings) {
+        settings = windowSettings;
+
+        // the null platform keeps glfw timers and event polling working without touching a
+        // display server, the context itself comes from EGL directly
+        if (settings.headless) {
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        }
+        // glfw copies the allocator, it only has to be set before init
+        GLFWallocator allocator = {glfwAllocate, glfwReallocate, glfwDeallocate, NULL};
+        glfwInitAllocator(&allocator);
+        if (!glfwInit()) {
+            return false;
+        }
+        glfwInitialized = true;
+
+        if (settings.headless) {
+            if (!headlessContext.create(3, 3)) {
+                destroy();
+                return false;
+            }
+        } else {
+            glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+            window = glfwCreateWindow(settings.width, settings.height, settings.title, NULL, NULL);
+            if (!window) {
+                destroy();
+                return false;
+            }
+            glfwMakeContextCurrent(window);
+        }
+
+        GLenum err = glewInit();
+        if (GLEW_OK != err) {
+            fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+        }
+
+        if (settings.headless) {
+            if (!createFramebuffer()) {
+                destroy();
+                return false;
+            }
+            printf("headless: %dx%d offscreen framebuffer, %s EGL context\n", settings.width, settings.height, headlessContext.getMode());
+        }
+        return true;
+    }
+
+    bool Window::createFramebuffer() {
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, settings.width, settings.height);
+
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, settings.width, settings.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        Memory::trackAllocation(Memory::MemoryTag::GpuTextures, framebufferBytes(settings.width, settings.height));
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "headless: framebuffer incomplete (0x%x)\n", status);
+            return false;
+        }
+        // stays bound for the whole run, the renderer never binds framebuffer 0 itself
+        glViewport(0, 0, settings.width, settings.height);
+        return true;
+    }
+
+    void Window::destroy() {
+        if (framebuffer) {
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteRenderbuffers(1, &colorBuffer);
+            glDeleteRenderbuffers(1, &depthBuffer);
+            Memory::trackFree(Memory::MemoryTag::GpuTextures, framebufferBytes(settings.width, settings.height));
+            framebuffer = 0;
+            colorBuffer = 0;
+            depthBuffer = 0;
+        }
+        headlessContext.destroy();
+        if (window) {
+            glfwDestroyWindow(window);
+            window = nullptr;
+        }
+        if (glfwInitialized) {
+            glfwTerminate();
+            glfwInitialized = false;
+        }
+    }
+
+    bool Window::shouldClose() const {
+        return closeRequested || (window && glfwWindowShouldClose(window));
+    }
+
+    void Window::requestClose() {
+        closeRequested = true;
+        if (window) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+        }
+    }
+
+    void Window::swapBuffers() {
+        if (window) {
+            glfwSwapBuffers(window);
+        } else {
+            glFinish();
+        }
+    }
+
+} // namespace Renderer
+} // namespace Engine
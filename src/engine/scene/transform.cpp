@@ -0,0 +1,359 @@
+#include "engine/scene/transform.hpp"
+
+#include <algorithm>
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <xmmintrin.h>
+#   define ENGINE_TRANSFORM_SSE 1
+#endif
+
+namespace Engine {
+namespace Scene {
+
+    glm::mat4 Mat3x4::toMat4() const {
+        glm::mat4 result(1.0f);
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++) {
+                result[column][row] = m[row * 4 + column];
+            }
+        }
+        return result;
+    }
+
+    static void multiply(const Mat3x4& a, const Mat3x4& b, Mat3x4& out) {
+#ifdef ENGINE_TRANSFORM_SSE
+        __m128 b0 = _mm_load_ps(b.m);
+        __m128 b1 = _mm_load_ps(b.m + 4);
+        __m128 b2 = _mm_load_ps(b.m + 8);
+        const __m128 w = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+        for (int row = 0; row < 3; row++) {
+            const float* r = a.m + row * 4;
+            __m128 result = _mm_mul_ps(_mm_set1_ps(r[0]), b0);
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(r[1]), b1));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(r[2]), b2));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(r[3]), w));
+            _mm_store_ps(out.m + row * 4, result);
+        }
+#else
+        for (int row = 0; row < 3; row++) {
+            const float* r = a.m + row * 4;
+            for (int column = 0; column < 4; column++) {
+                out.m[row * 4 + column] = r[0] * b.m[column] + r[1] * b.m[4 + column] + r[2] * b.m[8 + column];
+            }
+            out.m[row * 4 + 3] += r[3];
+        }
+#endif
+    }
+
+    TransformHierarchy::TransformHierarchy() {
+    }
+
+    TransformHandle TransformHierarchy::create(TransformHandle parentHandle) {
+        TransformHandle handle;
+        if (!freeHandles.empty()) {
+            handle.id = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            handle.id = (uint32_t)slotOf.size();
+            slotOf.push_back(UINT32_MAX);
+        }
+
+        uint32_t slot = (uint32_t)parent.size();
+        positionX.push_back(0.0f); positionY.push_back(0.0f); positionZ.push_back(0.0f);
+        rotationX.push_back(0.0f); rotationY.push_back(0.0f); rotationZ.push_back(0.0f); rotationW.push_back(1.0f);
+        scaleX.push_back(1.0f); scaleY.push_back(1.0f); scaleZ.push_back(1.0f);
+        parent.push_back(UINT32_MAX);
+        subtreeSize.push_back(1);
+        handleOf.push_back(handle.id);
+        dirty.push_back(0);
+        local.push_back(Mat3x4());
+        world.push_back(Mat3x4());
+        slotOf[handle.id] = slot;
+
+        // children go at the end of their parent's subtree to keep depth-first order
+        if (isValid(parentHandle)) {
+            uint32_t parentSlot = slotOf[parentHandle.id];
+            uint32_t insertAt = parentSlot + subtreeSize[parentSlot];
+            parent[slot] = parentSlot;
+            if (insertAt != slot) {
+                order.clear();
+                for (uint32_t i = 0; i < insertAt; i++) {
+                    order.push_back(i);
+                }
+                order.push_back(slot);
+                for (uint32_t i = insertAt; i < slot; i++) {
+                    order.push_back(i);
+                }
+                applyOrder(order);
+            }
+            for (uint32_t p = parent[slotOf[handle.id]]; p != UINT32_MAX; p = parent[p]) {
+                subtreeSize[p]++;
+            }
+        }
+
+        markDirty(slotOf[handle.id]);
+        return handle;
+    }
+
+    void TransformHierarchy::destroy(TransformHandle handle) {
+        if (!isValid(handle)) {
+            return;
+        }
+        uint32_t slot = slotOf[handle.id];
+        uint32_t count = subtreeSize[slot];
+        for (uint32_t p = parent[slot]; p != UINT32_MAX; p = parent[p]) {
+            subtreeSize[p] -= count;
+        }
+        for (uint32_t i = slot; i < slot + count; i++) {
+            slotOf[handleOf[i]] = UINT32_MAX;
+            freeHandles.push_back(handleOf[i]);
+        }
+
+        order.clear();
+        for (uint32_t i = 0; i < parent.size(); i++) {
+            if (i < slot || i >= slot + count) {
+                order.push_back(i);
+            }
+        }
+        applyOrder(order);
+    }
+
+    void TransformHierarchy::setParent(TransformHandle handle, TransformHandle parentHandle) {
+        if (!isValid(handle)) {
+            return;
+        }
+        uint32_t slot = slotOf[handle.id];
+        uint32_t count = subtreeSize[slot];
+        uint32_t total = (uint32_t)parent.size();
+        uint32_t newParent = isValid(parentHandle) ? slotOf[parentHandle.id] : UINT32_MAX;
+
+        if (newParent != UINT32_MAX && newParent >= slot && newParent < slot + count) {
+            fprintf(stderr, "TransformHierarchy: can't parent a node to its own descendant\n");
+            return;
+        }
+        if (newParent == parent[slot]) {
+            return;
+        }
+
+        // move the subtree block to the end of the new parent's subtree (or the very end for roots)
+        uint32_t end = newParent == UINT32_MAX ? total : newParent + subtreeSize[newParent];
+        order.clear();
+        for (uint32_t i = 0; i < total; i++) {
+            if (i == end) {
+                for (uint32_t b = slot; b < slot + count; b++) {
+                    order.push_back(b);
+                }
+            }
+            if (i >= slot && i < slot + count) {
+                continue;
+            }
+            order.push_back(i);
+        }
+        if (end == total) {
+            for (uint32_t b = slot; b < slot + count; b++) {
+                order.push_back(b);
+            }
+        }
+
+        for (uint32_t p = parent[slot]; p != UINT32_MAX; p = parent[p]) {
+            subtreeSize[p] -= count;
+        }
+        parent[slot] = newParent;
+        applyOrder(order);
+        for (uint32_t p = parent[slotOf[handle.id]]; p != UINT32_MAX; p = parent[p]) {
+            subtreeSize[p] += count;
+        }
+        markDirty(slotOf[handle.id]);
+    }
+
+    TransformHandle TransformHierarchy::getParent(TransformHandle handle) const {
+        TransformHandle result;
+        if (isValid(handle) && parent[slotOf[handle.id]] != UINT32_MAX) {
+            result.id = handleOf[parent[slotOf[handle.id]]];
+        }
+        return result;
+    }
+
+    template<typename T>
+    static void reorder(std::vector<T>& values, const std::vector<uint32_t>& order) {
+        std::vector<T> reordered(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            reordered[i] = values[order[i]];
+        }
+        values.swap(reordered);
+    }
+
+    void TransformHierarchy::applyOrder(const std::vector<uint32_t>& newOrder) {
+        std::vector<uint32_t> newSlot(parent.size(), UINT32_MAX);
+        for (uint32_t i = 0; i < newOrder.size(); i++) {
+            newSlot[newOrder[i]] = i;
+        }
+
+        reorder(positionX, newOrder); reorder(positionY, newOrder); reorder(positionZ, newOrder);
+        reorder(rotationX, newOrder); reorder(rotationY, newOrder); reorder(rotationZ, newOrder); reorder(rotationW, newOrder);
+        reorder(scaleX, newOrder); reorder(scaleY, newOrder); reorder(scaleZ, newOrder);
+        reorder(parent, newOrder);
+        reorder(subtreeSize, newOrder);
+        reorder(handleOf, newOrder);
+        reorder(dirty, newOrder);
+        reorder(local, newOrder);
+        reorder(world, newOrder);
+
+        for (uint32_t i = 0; i < parent.size(); i++) {
+            if (parent[i] != UINT32_MAX) {
+                parent[i] = newSlot[parent[i]];
+            }
+            slotOf[handleOf[i]] = i;
+        }
+    }
+
+    void TransformHierarchy::markDirty(uint32_t slot) {
+        if (!dirty[slot]) {
+            dirty[slot] = 1;
+            dirtyHandles.push_back(handleOf[slot]);
+        }
+    }
+
+    void TransformHierarchy::setPosition(TransformHandle handle, const glm::vec3& position) {
+        uint32_t slot = slotOf[handle.id];
+        positionX[slot] = position.x; positionY[slot] = position.y; positionZ[slot] = position.z;
+        markDirty(slot);
+    }
+
+    void TransformHierarchy::setRotation(TransformHandle handle, const glm::quat& rotation) {
+        uint32_t slot = slotOf[handle.id];
+        rotationX[slot] = rotation.x; rotationY[slot] = rotation.y; rotationZ[slot] = rotation.z; rotationW[slot] = rotation.w;
+        markDirty(slot);
+    }
+
+    void TransformHierarchy::setScale(TransformHandle handle, const glm::vec3& scale) {
+        uint32_t slot = slotOf[handle.id];
+        scaleX[slot] = scale.x; scaleY[slot] = scale.y; scaleZ[slot] = scale.z;
+        markDirty(slot);
+    }
+
+    void TransformHierarchy::setLocal(TransformHandle handle, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+        setPosition(handle, position);
+        setRotation(handle, rotation);
+        setScale(handle, scale);
+    }
+
+    glm::vec3 TransformHierarchy::getPosition(TransformHandle handle) const {
+        uint32_t slot = slotOf[handle.id];
+        return glm::vec3(positionX[slot], positionY[slot], positionZ[slot]);
+    }
+
+    glm::quat TransformHierarchy::getRotation(TransformHandle handle) const {
+        uint32_t slot = slotOf[handle.id];
+        return glm::quat(rotationW[slot], rotationX[slot], rotationY[slot], rotationZ[slot]);
+    }
+
+    glm::vec3 TransformHierarchy::getScale(TransformHandle handle) const {
+        uint32_t slot = slotOf[handle.id];
+        return glm::vec3(scaleX[slot], scaleY[slot], scaleZ[slot]);
+    }
+
+    // builds local matrices from the SoA TRS arrays, four nodes per iteration with SSE
+    void TransformHierarchy::computeLocal(uint32_t begin, uint32_t end) {
+        uint32_t i = begin;
+#ifdef ENGINE_TRANSFORM_SSE
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        for (; i + 4 <= end; i += 4) {
+            __m128 qx = _mm_loadu_ps(&rotationX[i]);
+            __m128 qy = _mm_loadu_ps(&rotationY[i]);
+            __m128 qz = _mm_loadu_ps(&rotationZ[i]);
+            __m128 qw = _mm_loadu_ps(&rotationW[i]);
+            __m128 sx = _mm_loadu_ps(&scaleX[i]);
+            __m128 sy = _mm_loadu_ps(&scaleY[i]);
+            __m128 sz = _mm_loadu_ps(&scaleZ[i]);
+
+            __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+            __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+            __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+            __m128 row0[4], row1[4], row2[4];
+            row0[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+            row0[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+            row0[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+            row0[3] = _mm_loadu_ps(&positionX[i]);
+            row1[0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+            row1[1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+            row1[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+            row1[3] = _mm_loadu_ps(&positionY[i]);
+            row2[0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+            row2[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+            row2[2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+            row2[3] = _mm_loadu_ps(&positionZ[i]);
+
+            // lanes hold one node each, transpose so every register holds one node's row
+            _MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+            _MM_TRANSPOSE4_PS(row1[0], row1[1], row1[2], row1[3]);
+            _MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+            for (int n = 0; n < 4; n++) {
+                _mm_store_ps(local[i + n].m, row0[n]);
+                _mm_store_ps(local[i + n].m + 4, row1[n]);
+                _mm_store_ps(local[i + n].m + 8, row2[n]);
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            float x = rotationX[i], y = rotationY[i], z = rotationZ[i], w = rotationW[i];
+            float* m = local[i].m;
+            m[0] = (1.0f - 2.0f * (y * y + z * z)) * scaleX[i];
+            m[1] = 2.0f * (x * y - w * z) * scaleY[i];
+            m[2] = 2.0f * (x * z + w * y) * scaleZ[i];
+            m[3] = positionX[i];
+            m[4] = 2.0f * (x * y + w * z) * scaleX[i];
+            m[5] = (1.0f - 2.0f * (x * x + z * z)) * scaleY[i];
+            m[6] = 2.0f * (y * z - w * x) * scaleZ[i];
+            m[7] = positionY[i];
+            m[8] = 2.0f * (x * z - w * y) * scaleX[i];
+            m[9] = 2.0f * (y * z + w * x) * scaleY[i];
+            m[10] = (1.0f - 2.0f * (x * x + y * y)) * scaleZ[i];
+            m[11] = positionZ[i];
+        }
+    }
+
+    uint32_t TransformHierarchy::update() {
+        if (dirtyHandles.empty()) {
+            return 0;
+        }
+
+        dirtyRanges.clear();
+        for (uint32_t id : dirtyHandles) {
+            if (id < slotOf.size() && slotOf[id] != UINT32_MAX && dirty[slotOf[id]]) {
+                dirty[slotOf[id]] = 0;
+                dirtyRanges.push_back(slotOf[id]);
+            }
+        }
+        dirtyHandles.clear();
+        std::sort(dirtyRanges.begin(), dirtyRanges.end());
+
+        // parents always come before children, so walking the sorted dirty roots and skipping
+        // ones already covered by an earlier subtree updates each node exactly once
+        uint32_t updated = 0;
+        uint32_t coveredEnd = 0;
+        for (uint32_t begin : dirtyRanges) {
+            if (begin < coveredEnd) {
+                continue;
+            }
+            uint32_t end = begin + subtreeSize[begin];
+            coveredEnd = end;
+
+            computeLocal(begin, end);
+            for (uint32_t i = begin; i < end; i++) {
+                if (parent[i] == UINT32_MAX) {
+                    world[i] = local[i];
+                } else {
+                    multiply(world[parent[i]], local[i], world[i]);
+                }
+            }
+            updated += end - begin;
+        }
+        return updated;
+    }
+
+} // namespace Scene
+} // namespace Engine
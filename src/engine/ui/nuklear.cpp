@@ -0,0 +1,16 @@
+// single translation unit holding the vendored nuklear implementation
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wsign-compare"
+#pragma GCC diagnostic ignored "-Wimplicit-fallthrough"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+
+#define NK_IMPLEMENTATION
+#include "engine/ui/nuklear.hpp"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
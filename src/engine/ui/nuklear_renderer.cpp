@@ -0,0 +1,263 @@
+#include "engine/ui/nuklear_renderer.hpp"
+#include "engine/input/input.hpp"
+#include "engine/memory/memory_tracker.hpp"
+
+#include "engine/renderer/gl.hpp"
+#include "GLFW/glfw3.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdio.h>
+
+namespace Engine {
+namespace UI {
+
+    struct UIVertex {
+        float position[2];
+        float uv[2];
+        nk_byte color[4];
+    };
+
+    // nuklear copies on growth itself, the old pointer is only a hint and must not be realloc'd
+    static void* nuklearAllocate(nk_handle, void*, nk_size size) {
+        return Memory::taggedMalloc(Memory::MemoryTag::UI, size);
+    }
+
+    static void nuklearFree(nk_handle, void* pointer) {
+        Memory::taggedFree(Memory::MemoryTag::UI, pointer);
+    }
+
+    NuklearRenderer::NuklearRenderer()
+        : projectionLocation(-1), atlasLocation(-1), vao(0), vbo(0), ebo(0), fontTexture(0), fontTextureBytes(0), drawCalls(0), initialized(false),
+          convertFailed(false), mapFailed(false) {
+        allocator.userdata = nk_handle_ptr(nullptr);
+        allocator.alloc = nuklearAllocate;
+        allocator.free = nuklearFree;
+    }
+
+    NuklearRenderer::~NuklearRenderer() {
+        shutdown();
+    }
+
+    bool NuklearRenderer::init() {
+        shader.reset(new Renderer::ShaderProgram("../assets/shaders/overlay.vert", "../assets/shaders/overlay.frag"));
+        projectionLocation = shader->uniformLocation("projection");
+        atlasLocation = shader->uniformLocation("atlas");
+        nk_buffer_init(&commands, &allocator, 4 * 1024);
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ARRAY_BUFFER, MAX_VERTEX_BYTES, NULL, GL_STREAM_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_ELEMENT_BYTES, NULL, GL_STREAM_DRAW);
+        Memory::trackAllocation(Memory::MemoryTag::GpuBuffers, MAX_VERTEX_BYTES + MAX_ELEMENT_BYTES);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)offsetof(UIVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)offsetof(UIVertex, uv));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(UIVertex), (void*)offsetof(UIVertex, color));
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+
+        nk_font_atlas_init(&atlas, &allocator);
+        nk_font_atlas_begin(&atlas);
+        struct nk_font* font = nk_font_atlas_add_default(&atlas, 13.0f, NULL);
+        int width, height;
+        const void* pixels = nk_font_atlas_bake(&atlas, &width, &height, NK_FONT_ATLAS_RGBA32);
+        glGenTextures(1, &fontTexture);
+        glBindTexture(GL_TEXTURE_2D, fontTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        fontTextureBytes = (size_t)width * (size_t)height * 4;
+        Memory::trackAllocation(Memory::MemoryTag::GpuTextures, fontTextureBytes);
+        nk_font_atlas_end(&atlas, nk_handle_id((int)fontTexture), &nullTexture);
+
+        if (!nk_init(&ctx, &allocator, &font->handle)) {
+            fprintf(stderr, "failed to initialize nuklear\n");
+            releaseResources();
+            return false;
+        }
+        initialized = true;
+        return true;
+    }
+
+    void NuklearRenderer::shutdown() {
+        if (!initialized) {
+            return;
+        }
+        nk_free(&ctx);
+        releaseResources();
+        initialized = false;
+    }
+
+    void NuklearRenderer::releaseResources() {
+        nk_font_atlas_clear(&atlas);
+        nk_buffer_free(&commands);
+        glDeleteTextures(1, &fontTexture);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        glDeleteVertexArrays(1, &vao);
+        fontTexture = vbo = ebo = vao = 0;
+        Memory::trackFree(Memory::MemoryTag::GpuBuffers, MAX_VERTEX_BYTES + MAX_ELEMENT_BYTES);
+        Memory::trackFree(Memory::MemoryTag::GpuTextures, fontTextureBytes);
+        fontTextureBytes = 0;
+        shader.reset();
+    }
+
+    void NuklearRenderer::input(const Input::InputSystem& input) {
+        nk_input_begin(&ctx);
+        for (const Input::Event& event : input.frameEvents()) {
+            switch (event.type) {
+                case Input::EventType::CursorPosition:
+                    nk_input_motion(&ctx, (int)event.x, (int)event.y);
+                    break;
+                case Input::EventType::MouseButton: {
+                    // the cursor as of this event, the motion events before it already moved
+                    // nuklear's mouse there
+                    int x = (int)ctx.input.mouse.pos.x;
+                    int y = (int)ctx.input.mouse.pos.y;
+                    int down = event.action == GLFW_PRESS;
+                    if (event.code == GLFW_MOUSE_BUTTON_LEFT) {
+                        nk_input_button(&ctx, NK_BUTTON_LEFT, x, y, down);
+                    } else if (event.code == GLFW_MOUSE_BUTTON_RIGHT) {
+                        nk_input_button(&ctx, NK_BUTTON_RIGHT, x, y, down);
+                    } else if (event.code == GLFW_MOUSE_BUTTON_MIDDLE) {
+                        nk_input_button(&ctx, NK_BUTTON_MIDDLE, x, y, down);
+                    }
+                    break;
+                }
+                case Input::EventType::Scroll:
+                    nk_input_scroll(&ctx, nk_vec2((float)event.x, (float)event.y));
+                    break;
+                case Input::EventType::Char:
+                    nk_input_unicode(&ctx, (nk_rune)event.code);
+                    break;
+                case Input::EventType::Key: {
+                    int down = event.action != GLFW_RELEASE;
+                    switch (event.code) {
+                        case GLFW_KEY_DELETE: nk_input_key(&ctx, NK_KEY_DEL, down); break;
+                        case GLFW_KEY_ENTER: nk_input_key(&ctx, NK_KEY_ENTER, down); break;
+                        case GLFW_KEY_TAB: nk_input_key(&ctx, NK_KEY_TAB, down); break;
+                        case GLFW_KEY_BACKSPACE: nk_input_key(&ctx, NK_KEY_BACKSPACE, down); break;
+                        case GLFW_KEY_LEFT: nk_input_key(&ctx, NK_KEY_LEFT, down); break;
+                        case GLFW_KEY_RIGHT: nk_input_key(&ctx, NK_KEY_RIGHT, down); break;
+                        case GLFW_KEY_UP: nk_input_key(&ctx, NK_KEY_UP, down); break;
+                        case GLFW_KEY_DOWN: nk_input_key(&ctx, NK_KEY_DOWN, down); break;
+                        default: break;
+                    }
+                    break;
+                }
+            }
+        }
+        nk_input_end(&ctx);
+    }
+
+    void NuklearRenderer::render(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight) {
+        static const struct nk_draw_vertex_layout_element layout[] = {
+            {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, offsetof(UIVertex, position)},
+            {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, offsetof(UIVertex, uv)},
+            {NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, offsetof(UIVertex, color)},
+            {NK_VERTEX_LAYOUT_END}
+        };
+
+        // top-left origin orthographic projection, column major
+        const float projection[16] = {
+            2.0f / (float)windowWidth, 0.0f, 0.0f, 0.0f,
+            0.0f, -2.0f / (float)windowHeight, 0.0f, 0.0f,
+            0.0f, 0.0f, -1.0f, 0.0f,
+            -1.0f, 1.0f, 0.0f, 1.0f
+        };
+
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_SCISSOR_TEST);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader->Use();
+        shader->setIntAt(atlasLocation, 0);
+        glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, projection);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+        // invalidating the whole buffer lets the driver hand out fresh storage instead of
+        // waiting for last frame's draws to finish reading it
+        void* vertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, MAX_VERTEX_BYTES, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        void* elements = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, MAX_ELEMENT_BYTES, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        struct nk_convert_config config;
+        memset(&config, 0, sizeof(config));
+        config.vertex_layout = layout;
+        config.vertex_size = sizeof(UIVertex);
+        config.vertex_alignment = NK_ALIGNOF(UIVertex);
+        config.null = nullTexture;
+        config.circle_segment_count = 22;
+        config.curve_segment_count = 22;
+        config.arc_segment_count = 22;
+        config.global_alpha = 1.0f;
+        config.shape_AA = NK_ANTI_ALIASING_ON;
+        config.line_AA = NK_ANTI_ALIASING_ON;
+
+        // a failed map (out of memory, lost context) skips the overlay like a failed convert
+        nk_flags converted = NK_CONVERT_INVALID_PARAM;
+        if (vertices && elements) {
+            struct nk_buffer vertexBuffer, elementBuffer;
+            nk_buffer_init_fixed(&vertexBuffer, vertices, MAX_VERTEX_BYTES);
+            nk_buffer_init_fixed(&elementBuffer, elements, MAX_ELEMENT_BYTES);
+            converted = nk_convert(&ctx, &commands, &vertexBuffer, &elementBuffer, &config);
+        } else if (!mapFailed) {
+            fprintf(stderr, "nuklear: mapping the UI buffers failed (GL error 0x%x), the overlay is skipped\n", glGetError());
+            mapFailed = true;
+        }
+        if (vertices) {
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        if (elements) {
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        }
+
+        // a full buffer leaves the vertex data cut off mid command, drawing it would index
+        // garbage, so the whole UI is skipped for the frame
+        drawCalls = 0;
+        if (converted != NK_CONVERT_SUCCESS && vertices && elements && !convertFailed) {
+            fprintf(stderr, "nuklear: converting the UI failed (flags 0x%x), more than %zu vertex or %zu element bytes?\n",
+                (unsigned)converted, MAX_VERTEX_BYTES, MAX_ELEMENT_BYTES);
+            convertFailed = true;
+        }
+        float scaleX = (float)framebufferWidth / (float)(windowWidth > 0 ? windowWidth : 1);
+        float scaleY = (float)framebufferHeight / (float)(windowHeight > 0 ? windowHeight : 1);
+        const struct nk_draw_command* command;
+        const nk_draw_index* offset = NULL;
+        if (converted == NK_CONVERT_SUCCESS) {
+            nk_draw_foreach(command, &ctx, &commands) {
+                if (!command->elem_count) {
+                    continue;
+                }
+                glBindTexture(GL_TEXTURE_2D, (GLuint)command->texture.id);
+                glScissor((GLint)(command->clip_rect.x * scaleX),
+                    (GLint)((float)framebufferHeight - (command->clip_rect.y + command->clip_rect.h) * scaleY),
+                    (GLint)(command->clip_rect.w * scaleX), (GLint)(command->clip_rect.h * scaleY));
+                glDrawElements(GL_TRIANGLES, (GLsizei)command->elem_count, GL_UNSIGNED_SHORT, offset);
+                offset += command->elem_count;
+                drawCalls++;
+            }
+        }
+        nk_clear(&ctx);
+        nk_buffer_clear(&commands);
+
+        glBindVertexArray(0);
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+} // namespace UI
+} // namespace Engine
@@ -0,0 +1,263 @@
+#include "engine/ui/perf_overlay.hpp"
+#include "engine/ui/nuklear_renderer.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/core/frame_pacer.hpp"
+#include "engine/ecs/system_scheduler.hpp"
+#include "engine/jobs/job_system.hpp"
+#include "engine/lua_embed/lua_gc.hpp"
+#include "engine/memory/frame_arena.hpp"
+#include "engine/memory/memory_tracker.hpp"
+#include "engine/profiler/flight_recorder.hpp"
+#include "engine/profiler/profiler.hpp"
+#include "engine/renderer/gpu_profiler.hpp"
+#ifdef ENGINE_GL_TRACE
+#include "engine/renderer/gl_trace.hpp"
+#endif
+
+#include <cstring>
+
+namespace Engine {
+namespace UI {
+
+    static const float UTILIZATION_SMOOTHING = 0.1f;
+
+    PerfOverlay::PerfOverlay(NuklearRenderer& ui, const PerfOverlaySources& sources)
+        : ui(ui), sources(sources), visible(false), historyCount(0), historyNext(0), lastSample(0) {
+        memset(frameHistory, 0, sizeof(frameHistory));
+    }
+
+    void PerfOverlay::setVisible(bool value) {
+        if (value && !visible) {
+            // history from before the overlay was hidden would show up as a flat line
+            historyCount = 0;
+            historyNext = 0;
+            lastBusy.clear();
+            utilization.clear();
+        }
+        visible = value;
+    }
+
+    void PerfOverlay::sampleJobs() {
+        const Jobs::JobSystem& jobs = *sources.jobs;
+        size_t threads = jobs.workerCount() + 1;
+        uint64_t now = Core::nowNanoseconds();
+        if (lastBusy.size() != threads) {
+            lastBusy.resize(threads);
+            utilization.assign(threads, 0.0f);
+            for (size_t i = 0; i < threads; i++) {
+                lastBusy[i] = jobs.busyNanoseconds((unsigned int)i);
+            }
+            lastSample = now;
+            return;
+        }
+        uint64_t elapsed = now - lastSample;
+        if (elapsed == 0) {
+            return;
+        }
+        for (size_t i = 0; i < threads; i++) {
+            uint64_t busy = jobs.busyNanoseconds((unsigned int)i);
+            float fraction = (float)(busy - lastBusy[i]) / (float)elapsed;
+            fraction = fraction > 1.0f ? 1.0f : fraction;
+            utilization[i] += (fraction - utilization[i]) * UTILIZATION_SMOOTHING;
+            lastBusy[i] = busy;
+        }
+        lastSample = now;
+    }
+
+    void PerfOverlay::update(const Input::InputSystem& input, double frameMs, const Renderer::RenderStats& renderStats, uint64_t heapAllocations) {
+        if (!visible) {
+            return;
+        }
+
+        frameHistory[historyNext] = (float)frameMs;
+        historyNext = (historyNext + 1) % HISTORY;
+        if (historyCount < HISTORY) {
+            historyCount++;
+        }
+        if (sources.jobs) {
+            sampleJobs();
+        }
+
+        ui.input(input);
+        nk_context* ctx = ui.context();
+        if (!nk_begin(ctx, "Performance", nk_rect(10, 10, 360, 620),
+                NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE | NK_WINDOW_MINIMIZABLE | NK_WINDOW_TITLE)) {
+            nk_end(ctx);
+            return;
+        }
+
+        // frame time graph, scaled to the worst frame in the window
+        float worst = 1.0f, sum = 0.0f;
+        for (uint32_t i = 0; i < historyCount; i++) {
+            worst = frameHistory[i] > worst ? frameHistory[i] : worst;
+            sum += frameHistory[i];
+        }
+        nk_layout_row_dynamic(ctx, 18, 1);
+        nk_labelf(ctx, NK_TEXT_LEFT, "frame %.2f ms  avg %.2f ms  max %.2f ms", frameMs, sum / (float)historyCount, worst);
+        nk_layout_row_dynamic(ctx, 80, 1);
+        if (nk_chart_begin(ctx, NK_CHART_LINES, (int)historyCount, 0.0f, worst)) {
+            uint32_t first = (historyNext + HISTORY - historyCount) % HISTORY;
+            for (uint32_t i = 0; i < historyCount; i++) {
+                nk_chart_push(ctx, frameHistory[(first + i) % HISTORY]);
+            }
+            nk_chart_end(ctx);
+        }
+
+        if (!sources.schedulers.empty() && nk_tree_push(ctx, NK_TREE_TAB, "CPU systems", NK_MAXIMIZED)) {
+            nk_layout_row_dynamic(ctx, 16, 2);
+            for (const PerfOverlaySources::SchedulerEntry& entry : sources.schedulers) {
+                const ECS::SchedulerFrameStats& stats = entry.scheduler->lastFrame();
+                nk_label(ctx, entry.label, NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms (crit %.3f)", stats.wallMs, stats.criticalPathMs);
+                for (size_t i = 0; i < stats.systems.size() && i < entry.scheduler->systemCount(); i++) {
+                    nk_labelf(ctx, NK_TEXT_LEFT, "  %s", entry.scheduler->system((uint32_t)i).name.c_str());
+                    nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms  t%u", stats.systems[i].durationMs, stats.systems[i].thread);
+                }
+            }
+            nk_tree_pop(ctx);
+        }
+
+        if (sources.gpuProfiler && nk_tree_push(ctx, NK_TREE_TAB, "GPU passes", NK_MAXIMIZED)) {
+            nk_layout_row_dynamic(ctx, 16, 2);
+            for (const Renderer::GpuScopeStats& scope : sources.gpuProfiler->getStats()) {
+                nk_labelf(ctx, NK_TEXT_LEFT, "%*s%s", (int)scope.depth * 2, "", scope.name);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms (avg %.3f)", scope.lastMs, scope.averageMs);
+            }
+            nk_tree_pop(ctx);
+        }
+
+        if (nk_tree_push(ctx, NK_TREE_TAB, "Rendering", NK_MAXIMIZED)) {
+            nk_layout_row_dynamic(ctx, 16, 2);
+            nk_label(ctx, "draw calls", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%u", renderStats.drawCalls);
+            nk_label(ctx, "triangles", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%llu", (unsigned long long)renderStats.triangles);
+            nk_label(ctx, "state changes", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%u", renderStats.stateChanges);
+            nk_label(ctx, "overlay draws", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%u", ui.lastDrawCalls());
+#ifdef ENGINE_GL_TRACE
+            const Renderer::GLFrameStats& glStats = Renderer::glTraceLastFrame();
+            nk_label(ctx, "gl calls", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%u (%.3f ms)", glStats.totalCalls, Core::nanosecondsToMilliseconds(glStats.totalNanoseconds));
+            nk_label(ctx, "gl sync points", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%u", glStats.syncCalls);
+            for (uint32_t i = 0; i < Renderer::GL_FUNCTION_COUNT; i++) {
+                const Renderer::GLCallCounters& counters = glStats.functions[i];
+                if (counters.calls) {
+                    nk_labelf(ctx, NK_TEXT_LEFT, "  %s", Renderer::glFunctionName((Renderer::GLFunction)i));
+                    nk_labelf(ctx, NK_TEXT_RIGHT, "%u  %.3f ms", counters.calls, Core::nanosecondsToMilliseconds(counters.nanoseconds));
+                }
+            }
+#endif
+            nk_tree_pop(ctx);
+        }
+
+        if (nk_tree_push(ctx, NK_TREE_TAB, "Memory", NK_MAXIMIZED)) {
+            nk_layout_row_dynamic(ctx, 16, 2);
+            nk_label(ctx, "heap allocs / frame", NK_TEXT_LEFT);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%llu", (unsigned long long)heapAllocations);
+            if (sources.frameArena) {
+                // previous() is the arena that just finished a whole frame
+                const Memory::LinearArena& arena = sources.frameArena->previous();
+                nk_label(ctx, "frame arena", NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%zu / %zu KB", arena.used() / 1024, arena.getCapacity() / 1024);
+                nk_label(ctx, "frame arena peak", NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%zu KB", sources.frameArena->highWaterMark() / 1024);
+            }
+            if (sources.luaGC) {
+                const LuaGCStats& gc = sources.luaGC->lastFrame();
+                nk_label(ctx, "lua heap", NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.1f KB", (double)gc.heapBytes / 1024.0);
+                nk_label(ctx, "lua gc", NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms  %u steps  %u full", gc.milliseconds, gc.steps, gc.emergencyCollects);
+            }
+            nk_layout_row_dynamic(ctx, 16, 4);
+            nk_label(ctx, "tag", NK_TEXT_LEFT);
+            nk_label(ctx, "current", NK_TEXT_RIGHT);
+            nk_label(ctx, "peak", NK_TEXT_RIGHT);
+            nk_label(ctx, "allocs", NK_TEXT_RIGHT);
+            for (size_t i = 0; i < (size_t)Memory::MemoryTag::Count; i++) {
+                Memory::MemoryTagStats stats = Memory::memoryTagStats((Memory::MemoryTag)i);
+                nk_label(ctx, Memory::memoryTagName((Memory::MemoryTag)i), NK_TEXT_LEFT);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.1f KB", (double)stats.currentBytes / 1024.0);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%.1f KB", (double)stats.peakBytes / 1024.0);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%llu", (unsigned long long)stats.frameAllocations);
+            }
+            nk_layout_row_dynamic(ctx, 22, 1);
+            if (nk_button_label(ctx, "dump memory stats")) {
+                Memory::dumpMemoryStats("memory.csv");
+            }
+            nk_tree_pop(ctx);
+        }
+
+        if (sources.jobs && nk_tree_push(ctx, NK_TREE_TAB, "Jobs", NK_MAXIMIZED)) {
+            nk_layout_row_begin(ctx, NK_DYNAMIC, 16, 3);
+            for (size_t i = 0; i < utilization.size(); i++) {
+                nk_size percent = (nk_size)(utilization[i] * 100.0f + 0.5f);
+                nk_layout_row_push(ctx, 0.3f);
+                if (i == 0) {
+                    nk_label(ctx, "main", NK_TEXT_LEFT);
+                } else {
+                    nk_labelf(ctx, NK_TEXT_LEFT, "worker %zu", i);
+                }
+                nk_layout_row_push(ctx, 0.5f);
+                nk_prog(ctx, percent, 100, nk_false);
+                nk_layout_row_push(ctx, 0.2f);
+                nk_labelf(ctx, NK_TEXT_RIGHT, "%3u%%", (unsigned int)percent);
+            }
+            nk_layout_row_end(ctx);
+            nk_tree_pop(ctx);
+        }
+
+        if (nk_tree_push(ctx, NK_TREE_TAB, "Toggles", NK_MAXIMIZED)) {
+            if (sources.pacer) {
+                Core::FramePacer& pacer = *sources.pacer;
+                static const char* modes[] = {"vsync on", "vsync adaptive", "vsync off"};
+                nk_layout_row_dynamic(ctx, 22, 1);
+                int mode = nk_combo(ctx, modes, (int)Core::VsyncMode::Count, (int)pacer.getVsync(), 18, nk_vec2(200, 90));
+                if (mode != (int)pacer.getVsync()) {
+                    pacer.setVsync((Core::VsyncMode)mode);
+                }
+                double limit = pacer.getFrameLimit();
+                nk_property_double(ctx, "fps limit", 0.0, &limit, 1000.0, 5.0, 1.0f);
+                if (limit != pacer.getFrameLimit()) {
+                    pacer.setFrameLimit(limit);
+                }
+                int throttle = pacer.getIdleThrottle() ? 1 : 0;
+                nk_checkbox_label(ctx, "throttle when idle", &throttle);
+                pacer.setIdleThrottle(throttle != 0);
+            }
+            nk_layout_row_dynamic(ctx, 22, 1);
+            if (sources.gpuProfiler) {
+                int gpu = sources.gpuProfiler->isEnabled() ? 1 : 0;
+                nk_checkbox_label(ctx, "gpu timers", &gpu);
+                sources.gpuProfiler->setEnabled(gpu != 0);
+            }
+#ifdef ENGINE_PROFILING
+            if (sources.flightRecorder) {
+                int recorder = sources.flightRecorder->isEnabled() ? 1 : 0;
+                nk_checkbox_label(ctx, "flight recorder", &recorder);
+                sources.flightRecorder->setEnabled(recorder != 0);
+            }
+            if (Profiler::isCapturing()) {
+                nk_label(ctx, "capturing trace...", NK_TEXT_LEFT);
+            } else if (nk_button_label(ctx, "capture trace (120 frames)")) {
+                Profiler::requestCapture(120, "trace.json");
+            }
+#endif
+            nk_tree_pop(ctx);
+        }
+
+        nk_end(ctx);
+    }
+
+    void PerfOverlay::render(int windowWidth, int windowHeight, int framebufferWidth, int framebufferHeight) {
+        if (!visible) {
+            return;
+        }
+        ui.render(windowWidth, windowHeight, framebufferWidth, framebufferHeight);
+    }
+
+} // namespace UI
+} // namespace Engine
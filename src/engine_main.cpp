@@ -1,6 +1,37 @@
 #include "engine/engine_main.hpp"
 #include "engine/engine_variable_definitions.hpp"
 #include "engine/renderer/shader.hpp"
+#include "engine/renderer/camera.hpp"
+#include "engine/renderer/window.hpp"
+#include "engine/renderer/gpu_profiler.hpp"
+#include "engine/renderer/render_stats.hpp"
+#include "engine/input/input.hpp"
+#include "engine/ecs/world.hpp"
+#include "engine/ecs/system_scheduler.hpp"
+#include "engine/ecs/ecs_benchmark.hpp"
+#include "engine/jobs/job_system.hpp"
+#include "engine/bench/benchmark.hpp"
+#include "engine/bench/camera_path.hpp"
+#include "engine/core/clock.hpp"
+#include "engine/core/fixed_timestep.hpp"
+#include "engine/core/frame_pacer.hpp"
+#include "engine/memory/allocator.hpp"
+#include "engine/memory/memory_tracker.hpp"
+#include "engine/profiler/profiler.hpp"
+#include "engine/profiler/flight_recorder.hpp"
+#include "engine/memory/frame_arena.hpp"
+#include "engine/scene/components.hpp"
+#include "engine/lua_embed/lua_embed_main.hpp"
+#include "engine/lua_embed/lua_scheduler.hpp"
+#include "engine/lua_embed/lua_gc.hpp"
+#include "engine/lua_embed/lua_hot_reload.hpp"
+#include "engine/lua_embed/lua_profiler.hpp"
+#include "engine/lua_embed/lua_state_pool.hpp"
+#include "engine/lua_embed/lua_binding.hpp"
+#include "engine/lua_embed/lua_renderer_bindings.hpp"
+#include "engine/scene/transform.hpp"
+#include "engine/ui/nuklear_renderer.hpp"
+#include "engine/ui/perf_overlay.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "image/stb_image.h"
@@ -9,80 +40,89 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
 
 
 float deltaTime = 0.0f;	// Time between current frame and last frame
-float lastFrame = 0.0f; // Time of last frame
 
-float lastX = 400, lastY = 300;
-float yaw = -90.0f, pitch = 0.0f;
-bool firstMouse = true;
-
-glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  3.0f);
-glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f,  0.0f);
-
-float fov = 45.0f;
-
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
-{
-    fov -= (float)yoffset;
-    if (fov < 1.0f)
-        fov = 1.0f;
-    if (fov > 45.0f)
-        fov = 45.0f; 
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+// ids of the actions and axes the engine loop reads, registered once in setupInput
+struct InputActions {
+    Engine::Input::ActionId cycleVsync;
+    Engine::Input::ActionId captureTrace;
+    Engine::Input::ActionId toggleOverlay;
+    Engine::Input::ActionId dumpMemory;
+    Engine::Input::AxisId moveForward;
+    Engine::Input::AxisId moveRight;
+    Engine::Input::AxisId lookX;
+    Engine::Input::AxisId lookY;
+    Engine::Input::AxisId zoom;
+};
+
+InputActions setupInput(Engine::Input::InputSystem& input) {
+    InputActions actions;
+    actions.cycleVsync = input.addAction("cycle_vsync");
+    input.bindKey(actions.cycleVsync, GLFW_KEY_F2);
+    actions.captureTrace = input.addAction("capture_trace");
+    input.bindKey(actions.captureTrace, GLFW_KEY_F3);
+    actions.toggleOverlay = input.addAction("toggle_overlay");
+    input.bindKey(actions.toggleOverlay, GLFW_KEY_F1);
+    actions.dumpMemory = input.addAction("dump_memory");
+    input.bindKey(actions.dumpMemory, GLFW_KEY_F4);
+
+    actions.moveForward = input.addAxis("move_forward");
+    input.bindKeyAxis(actions.moveForward, GLFW_KEY_W, GLFW_KEY_S);
+    actions.moveRight = input.addAxis("move_right");
+    input.bindKeyAxis(actions.moveRight, GLFW_KEY_D, GLFW_KEY_A);
+
+    // screen y grows downwards, looking up needs a positive offset
+    actions.lookX = input.addAxis("look_x");
+    input.bindMouseAxis(actions.lookX, Engine::Input::MouseAxis::X, 1.0f);
+    actions.lookY = input.addAxis("look_y");
+    input.bindMouseAxis(actions.lookY, Engine::Input::MouseAxis::Y, -1.0f);
+    actions.zoom = input.addAxis("zoom");
+    input.bindMouseAxis(actions.zoom, Engine::Input::MouseAxis::ScrollY, 1.0f);
+    return actions;
 }
 
-void mouse_callback(GLFWwindow* window, double xpos, double ypos)
-{
-    if (firstMouse)
-    {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
-    }
-  
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos; 
-    lastX = xpos;
-    lastY = ypos;
-
-    float sensitivity = 0.1f;
-    xoffset *= sensitivity;
-    yoffset *= sensitivity;
-
-    yaw   += xoffset;
-    pitch += yoffset;
-
-    if(pitch > 89.0f)
-        pitch = 89.0f;
-    if(pitch < -89.0f)
-        pitch = -89.0f;
-
-    glm::vec3 direction;
-    direction.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    direction.y = sin(glm::radians(pitch));
-    direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraFront = glm::normalize(direction);
-}
-
-void processInput(GLFWwindow *window) {
-    float cameraSpeed = 2.5f * deltaTime;
-
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+// mouse look is skipped while the cursor belongs to the overlay
+void processInput(const Engine::Input::InputSystem& input, const InputActions& actions, Engine::Core::FramePacer& pacer, bool look) {
+    if (input.wasPressed(actions.cycleVsync))
+        pacer.cycleVsync();
+    if (input.wasPressed(actions.captureTrace))
+        Engine::Profiler::requestCapture(120, "trace.json");
+    if (input.wasPressed(actions.dumpMemory))
+        Engine::Memory::dumpMemoryStats("memory.csv");
+
+    float forward = input.axis(actions.moveForward);
+    float right = input.axis(actions.moveRight);
+    if (forward > 0.0f)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (forward < 0.0f)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (right < 0.0f)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (right > 0.0f)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    // one look update per frame no matter how many motion events arrived
+    float lookX = input.axis(actions.lookX);
+    float lookY = input.axis(actions.lookY);
+    if (look && (lookX != 0.0f || lookY != 0.0f))
+        camera.ProcessMouseMovement(lookX, lookY);
+
+    float zoom = input.axis(actions.zoom);
+    if (zoom != 0.0f)
+        camera.ProcessMouseScroll(zoom);
 }
 
 // callback function to make the window's darawable size be the size of the actual window
@@ -96,6 +136,35 @@ void Engine::window_size_callback(GLFWwindow* window, int width, int height) {
 // get command line arguments where argc is the ammount and argv is the strings that are the argument (argv[1] is always the executable)
 int Engine::engine_main(int argc, char* argv[])
 {
+    PROFILE_THREAD_NAME("main");
+
+    Engine::Core::FramePacerSettings pacerSettings;
+    Engine::Renderer::WindowSettings windowSettings;
+    Engine::Bench::BenchmarkSettings benchSettings;
+    uint64_t maxFrames = 0;
+    uint32_t traceFrames = 0;
+    std::string tracePath = "trace.json";
+    Engine::Profiler::FlightRecorderSettings flightRecorderSettings;
+    bool showOverlay = false;
+    std::string glTracePath;
+    uint32_t glTraceFrames = 60;
+    uint32_t ecsBenchEntities = 0;
+    bool selfCheck = false;
+    bool checkAllocations = false;
+    uint64_t allocationCheckWarmup = 0;
+    uint32_t luaBenchEntities = 0;
+    std::vector<std::string> scripts;
+    Engine::LuaGCSettings luaGCSettings;
+    uint32_t luaStartupBenchScripts = 0;
+    uint32_t luaPoolBenchEntities = 0;
+    uint32_t luaBindingBenchCalls = 0;
+    uint32_t luaMathBenchTransforms = 0;
+    bool hotReload = false;
+    bool luaProfile = false;
+    std::vector<std::string> poolScripts;
+    uint32_t luaStates = 0;
+    // where the cook-scripts target puts assets/scripts when run from the build directory
+    std::string scriptCache = "cooked/scripts";
     for (int i = 1; i < argc; i++) {
         if (argc < 2) {
             break;
@@ -103,40 +172,190 @@ int Engine::engine_main(int argc, char* argv[])
         if (strcmp(argv[i], "-debug") == 0) {
             Engine::DEBUG_MODE = true;
         }
+        if (strcmp(argv[i], "-vsync") == 0 && i + 1 < argc) {
+            if (!Engine::Core::parseVsyncMode(argv[++i], pacerSettings.vsync)) {
+                fprintf(stderr, "unknown vsync mode %s, expected on, adaptive or off\n", argv[i]);
+            }
+        }
+        if (strcmp(argv[i], "-fps-limit") == 0 && i + 1 < argc) {
+            pacerSettings.fpsLimit = atof(argv[++i]);
+        }
+        if (strcmp(argv[i], "-no-idle-throttle") == 0) {
+            pacerSettings.throttleWhenIdle = false;
+        }
+        if (strcmp(argv[i], "-headless") == 0) {
+            windowSettings.headless = true;
+        }
+        if (strcmp(argv[i], "-size") == 0 && i + 1 < argc) {
+            int width, height;
+            if (sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                windowSettings.width = width;
+                windowSettings.height = height;
+            } else {
+                fprintf(stderr, "invalid size %s, expected WIDTHxHEIGHT\n", argv[i]);
+            }
+        }
+        if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc) {
+            maxFrames = strtoull(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-bench") == 0 && i + 1 < argc) {
+            benchSettings.frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-bench-warmup") == 0 && i + 1 < argc) {
+            benchSettings.warmupFrames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-bench-out") == 0 && i + 1 < argc) {
+            benchSettings.output = argv[++i];
+        }
+        if (strcmp(argv[i], "-bench-path") == 0 && i + 1 < argc) {
+            benchSettings.cameraPath = argv[++i];
+        }
+        if (strcmp(argv[i], "-trace-frames") == 0 && i + 1 < argc) {
+            traceFrames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-trace-out") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        }
+        if (strcmp(argv[i], "-hitch-ms") == 0 && i + 1 < argc) {
+            flightRecorderSettings.thresholdMs = atof(argv[++i]);
+        }
+        if (strcmp(argv[i], "-no-flight-recorder") == 0) {
+            flightRecorderSettings.enabled = false;
+        }
+        if (strcmp(argv[i], "-overlay") == 0) {
+            showOverlay = true;
+        }
+        if (strcmp(argv[i], "-gl-trace") == 0 && i + 1 < argc) {
+            glTracePath = argv[++i];
+        }
+        if (strcmp(argv[i], "-gl-trace-frames") == 0 && i + 1 < argc) {
+            glTraceFrames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-ecs-bench") == 0 && i + 1 < argc) {
+            ecsBenchEntities = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-self-check") == 0) {
+            selfCheck = true;
+        }
+        if (strcmp(argv[i], "-check-allocations") == 0 && i + 1 < argc) {
+            checkAllocations = true;
+            allocationCheckWarmup = strtoull(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-lua-bench") == 0 && i + 1 < argc) {
+            luaBenchEntities = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-script") == 0 && i + 1 < argc) {
+            scripts.push_back(argv[++i]);
+        }
+        if (strcmp(argv[i], "-script-cache") == 0 && i + 1 < argc) {
+            scriptCache = argv[++i];
+        }
+        if (strcmp(argv[i], "-lua-startup-bench") == 0 && i + 1 < argc) {
+            luaStartupBenchScripts = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-hot-reload") == 0) {
+            hotReload = true;
+        }
+        if (strcmp(argv[i], "-lua-profile") == 0) {
+            luaProfile = true;
+        }
+        if (strcmp(argv[i], "-lua-binding-bench") == 0 && i + 1 < argc) {
+            luaBindingBenchCalls = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-lua-math-bench") == 0 && i + 1 < argc) {
+            luaMathBenchTransforms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-lua-pool-bench") == 0 && i + 1 < argc) {
+            luaPoolBenchEntities = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-pool-script") == 0 && i + 1 < argc) {
+            poolScripts.push_back(argv[++i]);
+        }
+        if (strcmp(argv[i], "-lua-states") == 0 && i + 1 < argc) {
+            luaStates = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        if (strcmp(argv[i], "-lua-heap-limit") == 0 && i + 1 < argc) {
+            luaGCSettings.ceilingBytes = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        }
     }
 
-    GLFWwindow* window;
+    // nothing presents a headless frame, vsync would only mislabel the frame stats
+    if (windowSettings.headless) {
+        pacerSettings.vsync = Engine::Core::VsyncMode::Off;
+        pacerSettings.throttleWhenIdle = false;
+    }
 
-    /* Initialize the library */
-    if (!glfwInit()) {
-        return -1;
+    // a bench run measures how fast frames can be produced, any pacing would only measure the pacer
+    bool benchmark = benchSettings.frames > 0;
+    if (benchmark) {
+        pacerSettings.vsync = Engine::Core::VsyncMode::Off;
+        pacerSettings.fpsLimit = 0.0;
+        pacerSettings.throttleWhenIdle = false;
     }
 
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(1280, 720, "Hello World", NULL, NULL);
-    if (!window)
-    {
-        glfwTerminate();
-        return -1;
+    if (checkAllocations && !Engine::Memory::heapAllocationTrackingEnabled()) {
+        fprintf(stderr, "-check-allocations needs a build with ENGINE_TRACK_ALLOCATIONS\n");
+        return 1;
     }
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
-    glfwSetWindowSizeCallback(window, window_size_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouse_callback); 
-    glfwSetScrollCallback(window, scroll_callback);
-    
-    GLenum err = glewInit();
-    if (GLEW_OK != err) {
-        fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+    // ECS and scripting only, no window or GL context needed
+    if (selfCheck) {
+        bool passed = Engine::Input::runInputCheck();
+        printf("self check %s\n", passed ? "passed" : "failed");
+        return passed ? 0 : 1;
+    }
+    if (ecsBenchEntities > 0) {
+        Engine::ECS::runIterationBenchmark(ecsBenchEntities, 20);
+        return 0;
     }
+    if (luaBenchEntities > 0) {
+        Engine::runLuaComponentBenchmark(luaBenchEntities, 100);
+        return 0;
+    }
+    if (luaStartupBenchScripts > 0) {
+        Engine::runLuaStartupBenchmark(luaStartupBenchScripts);
+        return 0;
+    }
+    if (luaBindingBenchCalls > 0) {
+        Engine::runLuaBindingBenchmark(luaBindingBenchCalls);
+        return 0;
+    }
+    if (luaMathBenchTransforms > 0) {
+        Engine::runLuaMathBenchmark(luaMathBenchTransforms, "../assets/scripts");
+        return 0;
+    }
+    if (luaPoolBenchEntities > 0) {
+        Engine::runLuaPoolBenchmark(luaPoolBenchEntities, luaStates);
+        return 0;
+    }
+
+    /* Create the window (or offscreen framebuffer) and its OpenGL context */
+    Engine::Renderer::Window window;
+    if (!window.create(windowSettings)) {
+        return -1;
+    }
+#ifdef ENGINE_GL_TRACE
+    // started right after the context exists, before the renderer makes any of its objects. a
+    // headless window.create has already made the offscreen framebuffer by now, gl_replay
+    // renders into its own target wherever the trace uses a framebuffer it never saw created
+    if (!glTracePath.empty()) {
+        Engine::Renderer::glTraceStartCapture(glTracePath.c_str(), glTraceFrames);
+    }
+#else
+    if (!glTracePath.empty()) {
+        fprintf(stderr, "-gl-trace needs a build with ENGINE_GL_TRACE\n");
+    }
+    (void)glTraceFrames;
+#endif
+
+    Engine::Input::InputSystem input;
+    if (window.handle()) {
+        glfwSetWindowSizeCallback(window.handle(), window_size_callback);
+        glfwSetInputMode(window.handle(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        input.attach(window.handle());
+    }
+    InputActions inputActions = setupInput(input);
+
     fprintf(stdout, "using GLEW version %s\n", glewGetString(GLEW_VERSION));
     int backend = glfwGetPlatform();
     printf("GLFW backend: %x\n", backend);
@@ -213,9 +432,13 @@ int Engine::engine_main(int argc, char* argv[])
     int width, height, nrChannels;
     unsigned char *data = stbi_load("../assets/textures/theodore.png", &width, &height, &nrChannels, STBI_rgb_alpha);
 
+    size_t textureBytes = 0;
     if (data) {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        // the mip chain adds a third on top of the base level
+        textureBytes = (size_t)width * (size_t)height * 4 * 4 / 3;
+        Engine::Memory::trackAllocation(Engine::Memory::MemoryTag::GpuTextures, textureBytes);
     } else {
         std::cout << "Failed to load texture" << std::endl;
     }
@@ -229,6 +452,7 @@ int Engine::engine_main(int argc, char* argv[])
     glGenBuffers(1, &VBO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    Engine::Memory::trackAllocation(Engine::Memory::MemoryTag::GpuBuffers, sizeof(vertices));
 
     glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,5*sizeof(float),(void*)0);
     glEnableVertexAttribArray(0);
@@ -238,59 +462,414 @@ int Engine::engine_main(int argc, char* argv[])
 
     glBindVertexArray(0);
 
+    Engine::Memory::TaggedAllocator ecsAllocator(Engine::Memory::heapAllocator(), Engine::Memory::MemoryTag::ECS);
+    Engine::ECS::World world(ecsAllocator);
+    Engine::Scene::TransformHierarchy transforms;
+    for (unsigned int i = 0; i < 10; i++) {
+        Engine::Scene::TransformHandle node = transforms.create();
+        float angle = 20.0f * i;
+        transforms.setLocal(node, cubePositions[i],
+            glm::angleAxis(glm::radians(angle), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f))), glm::vec3(1.0f));
+        world.create(
+            Engine::Scene::Position{cubePositions[i]},
+            Engine::Scene::Transform{node},
+            Engine::Scene::CubeMesh{texture}
+        );
+    }
+    // component layouts scripts see through FFI, checked against the C++ structs on registration
+    Engine::LuaJIT lua;
+    if (!lua.init(world) ||
+        !lua.registerComponent<Engine::Scene::Position>("Position", "float x, y, z;") ||
+        !lua.registerComponent<Engine::Scene::PreviousPosition>("PreviousPosition", "float x, y, z;") ||
+        !lua.registerComponent<Engine::Scene::Velocity>("Velocity", "float x, y, z;")) {
+        return -1;
+    }
+    // engine.camera is the global camera as an FFI cdata, fields and methods come from the bindings
+    if (!Engine::bindRendererTypes(lua.state()) || !Engine::LuaBind::setEngineField(lua.state(), "camera", &camera)) {
+        return -1;
+    }
+    lua.setBytecodeCache("../assets/scripts", scriptCache);
+    Engine::LuaScheduler coroutines;
+    if (!coroutines.init(lua)) {
+        return -1;
+    }
+    // the script heap is only collected in the idle time at the end of each frame
+    Engine::LuaGC luaGC(luaGCSettings);
+    luaGC.attach(lua);
+    // script stack samples and JIT trace aborts land on their own tracks in captures and hitch
+    // dumps, the hottest functions are printed at exit
+    Engine::LuaProfiler luaProfiler;
+    if (luaProfile && !luaProfiler.start(lua)) {
+        return -1;
+    }
+    Engine::Jobs::JobSystem jobs;
+    Engine::Memory::FrameArena frameArena(1024 * 1024);
+    Engine::ECS::SystemScheduler simulation(jobs);
+    Engine::ECS::SystemScheduler frameSystems(jobs);
+    simulation.setFrameAllocator(&frameArena);
+    frameSystems.setFrameAllocator(&frameArena);
+
+    // simulation systems run once per fixed step
+    simulation.addSystem("store previous",
+        Engine::ECS::Reads<Engine::Scene::Position>(), Engine::ECS::Writes<Engine::Scene::PreviousPosition>(),
+        [](Engine::ECS::SystemContext& context) {
+            context.parallelEach<Engine::Scene::Position, Engine::Scene::PreviousPosition>(
+                [](Engine::Scene::Position& position, Engine::Scene::PreviousPosition& previous) {
+                    previous.value = position.value;
+                });
+        });
+    simulation.addSystem("movement",
+        Engine::ECS::Reads<Engine::Scene::Velocity>(), Engine::ECS::Writes<Engine::Scene::Position>(),
+        [](Engine::ECS::SystemContext& context) {
+            float dt = context.deltaTime;
+            context.parallelEach<Engine::Scene::Position, Engine::Scene::Velocity>(
+                [dt](Engine::Scene::Position& position, Engine::Scene::Velocity& velocity) {
+                    position.value += velocity.value * dt;
+                });
+        });
+    // set up further down, declared before the reloader so that lets go of its states first
+    Engine::LuaStatePool luaPool;
+    // require() finds modules below the script root, with -hot-reload saved scripts are
+    // recompiled off the main thread and swapped in during the frame's idle time, in the main
+    // state and in every pool state
+    Engine::LuaHotReload scriptReload;
+    if (!scriptReload.init(lua, "../assets/scripts")) {
+        return -1;
+    }
+    // scripts can touch any component they can see, so the script systems get ordered against
+    // everything registered. main thread because the lua state isn't shared
+    for (const std::string& script : scripts) {
+        scriptReload.runScript(script.c_str());
+    }
+    Engine::ECS::SystemDesc scriptSystems;
+    scriptSystems.name = "lua systems";
+    scriptSystems.reads = lua.componentMask();
+    scriptSystems.writes = lua.componentMask();
+    scriptSystems.mainThread = true;
+    scriptSystems.function = [&lua, &coroutines](Engine::ECS::SystemContext& context) {
+        lua.runSystems(context.deltaTime);
+        coroutines.update(context.deltaTime);
+    };
+    simulation.addSystem(scriptSystems);
+
+    // -pool-script files run in a pool of states that split the chunks between them and update
+    // in parallel, one state per hardware thread unless -lua-states says otherwise
+    if (!poolScripts.empty()) {
+        if (!luaPool.init(world, luaStates > 0 ? luaStates : jobs.workerCount() + 1) ||
+            !luaPool.registerComponent<Engine::Scene::Position>("Position", "float x, y, z;") ||
+            !luaPool.registerComponent<Engine::Scene::PreviousPosition>("PreviousPosition", "float x, y, z;") ||
+            !luaPool.registerComponent<Engine::Scene::Velocity>("Velocity", "float x, y, z;")) {
+            return -1;
+        }
+        // every pool state loads its own copy through the reloader, a save reloads all of them
+        for (uint32_t i = 0; i < luaPool.stateCount(); i++) {
+            if (!scriptReload.addState(luaPool.state(i))) {
+                return -1;
+            }
+            for (const std::string& script : poolScripts) {
+                scriptReload.runScript(luaPool.state(i), script.c_str());
+            }
+        }
+        Engine::ECS::SystemDesc poolSystems;
+        poolSystems.name = "lua pool";
+        poolSystems.reads = luaPool.state(0).componentMask();
+        poolSystems.writes = luaPool.state(0).componentMask();
+        poolSystems.mainThread = true;
+        poolSystems.function = [&luaPool](Engine::ECS::SystemContext& context) {
+            luaPool.update(context.jobs, context.deltaTime);
+        };
+        simulation.addSystem(poolSystems);
+    }
+    if (hotReload) {
+        scriptReload.watch();
+    }
+
+    // pushes positions of moving entities into the hierarchy, blended between the last two
+    // simulation steps. static entities have no Velocity so they never match and never dirty
+    // their transform. then collects the cubes' world matrices into the frame's draw list,
+    // which lives in frame arena memory so building it never touches the heap
+    float interpolationAlpha = 0.0f;
+    Engine::ECS::Query& cubeQuery = world.query<Engine::Scene::Transform, Engine::Scene::CubeMesh>();
+    Engine::Memory::Vector<glm::mat4> cubeMatrices;
+    frameSystems.addSystem("transform sync",
+        Engine::ECS::Reads<Engine::Scene::Position, Engine::Scene::PreviousPosition, Engine::Scene::Velocity, Engine::Scene::Transform, Engine::Scene::CubeMesh>(), Engine::ECS::Writes<>(),
+        [&transforms, &interpolationAlpha, &cubeQuery, &cubeMatrices](Engine::ECS::SystemContext& context) {
+            float alpha = interpolationAlpha;
+            context.world.each<Engine::Scene::Position, Engine::Scene::PreviousPosition, Engine::Scene::Velocity, Engine::Scene::Transform>(
+                [&transforms, alpha](Engine::Scene::Position& position, Engine::Scene::PreviousPosition& previous,
+                                     Engine::Scene::Velocity&, Engine::Scene::Transform& transform) {
+                    transforms.setPosition(transform.node, glm::mix(previous.value, position.value, alpha));
+                });
+            transforms.update();
+
+            // last frame's list points into the arena half that is about to be reset, drop it
+            // without reading it
+            cubeMatrices = Engine::Memory::Vector<glm::mat4>(Engine::Memory::StlAllocator<glm::mat4>(*context.frameAllocator));
+            cubeMatrices.reserve(cubeQuery.entityCount());
+            cubeQuery.each<Engine::Scene::Transform, Engine::Scene::CubeMesh>(
+                [&transforms, &cubeMatrices](Engine::Scene::Transform& transform, Engine::Scene::CubeMesh&) {
+                    cubeMatrices.push_back(transforms.getWorld(transform.node).toMat4());
+                });
+        }, true);
+
+    Engine::Core::FixedTimestep timestep(Engine::Core::NANOSECONDS_PER_SECOND / 60, 5);
+    uint64_t lastSchedulerReport = 0;
+    uint64_t frameAllocations = 0;
+
     Engine::Renderer::ShaderProgram shaderProgram("../assets/shaders/basic.vert", "../assets/shaders/basic.frag");
+    int modelLoc = shaderProgram.uniformLocation("model");
+    int viewLoc = shaderProgram.uniformLocation("view");
+    int projectionLoc = shaderProgram.uniformLocation("projection");
+    Engine::LuaBind::setEngineField(lua.state(), "shader", &shaderProgram);
 
     glEnable(GL_DEPTH_TEST);
 
+    Engine::Renderer::GpuProfiler gpuProfiler;
+    gpuProfiler.init();
+
+    // a failed start skips the frame loop but still goes through the shutdown at the end
+    int exitCode = 0;
+
+    Engine::Bench::BenchmarkRecorder bench(benchSettings);
+    Engine::Bench::CameraPath cameraPath = Engine::Bench::CameraPath::defaultPath();
+    if (benchmark) {
+        if (!benchSettings.cameraPath.empty() && !cameraPath.load(benchSettings.cameraPath.c_str())) {
+            exitCode = -1;
+            window.requestClose();
+        } else {
+            bench.init();
+        }
+    }
+    // bench frames advance a synthetic clock by exactly one step so every run simulates and
+    // renders the same sequence of states regardless of how long the frames take
+    uint64_t benchClock = 0;
+
+    Engine::Core::FramePacer pacer(window.handle(), pacerSettings);
+    bool shouldRender = true;
+    uint64_t frameCount = 0;
+#ifdef ENGINE_PROFILING
+    uint64_t tracedGpuFrame = 0;
+#endif
+    Engine::Profiler::requestCapture(traceFrames, tracePath);
+    Engine::Profiler::FlightRecorder flightRecorder(flightRecorderSettings);
+
+    Engine::UI::NuklearRenderer nuklear;
+    if (!nuklear.init()) {
+        exitCode = -1;
+        window.requestClose();
+    }
+    Engine::UI::PerfOverlaySources overlaySources;
+    overlaySources.schedulers.push_back({"simulation", &simulation});
+    overlaySources.schedulers.push_back({"frame systems", &frameSystems});
+    overlaySources.gpuProfiler = &gpuProfiler;
+    overlaySources.jobs = &jobs;
+    overlaySources.pacer = &pacer;
+    overlaySources.flightRecorder = &flightRecorder;
+    overlaySources.frameArena = &frameArena;
+    overlaySources.luaGC = &luaGC;
+    Engine::UI::PerfOverlay overlay(nuklear, overlaySources);
+    overlay.setVisible(showOverlay);
+    Engine::Renderer::RenderStats renderStats;
+
     /* Loop until the user closes the window */
-    while (!glfwWindowShouldClose(window))
+    while (!window.shouldClose())
     {        
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;  
-
-        processInput(window);
-        /* Render here */
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        uint64_t currentFrame = Engine::Core::nowNanoseconds();
+        if (benchmark) {
+            bench.beginFrame();
+            benchClock += timestep.stepNanoseconds();
+        }
+        uint32_t steps = timestep.advance(benchmark ? benchClock : currentFrame);
+        deltaTime = (float)Engine::Core::nanosecondsToSeconds(timestep.frameNanoseconds());
 
-        shaderProgram.Use();
-        
-        glBindTexture(GL_TEXTURE_2D, texture);
+        uint64_t allocationsAtFrameStart = Engine::Memory::heapAllocationCount();
+        frameArena.beginFrame();
 
-        glm::mat4 view;
-        view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        {
+            PROFILE_SCOPE("input");
+            input.update();
+            if (benchmark) {
+                Engine::Bench::CameraPose pose = cameraPath.evaluate(bench.progress());
+                camera.SetPose(pose.position, pose.yaw, pose.pitch);
+            } else {
+                if (input.wasPressed(inputActions.toggleOverlay)) {
+                    overlay.toggle();
+                    if (window.handle()) {
+                        glfwSetInputMode(window.handle(), GLFW_CURSOR, overlay.isVisible() ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+                    }
+                }
+                processInput(input, inputActions, pacer, !overlay.isVisible());
+            }
+        }
 
-        glm::mat4 projection;
-        projection = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 100.0f);
+        for (uint32_t step = 0; step < steps; step++) {
+            PROFILE_SCOPE("simulation step");
+            simulation.run(world, timestep.stepSeconds());
+        }
+        interpolationAlpha = (float)timestep.alpha();
+        {
+            PROFILE_SCOPE("frame systems");
+            frameSystems.run(world, deltaTime);
+        }
 
-        int viewLoc = glGetUniformLocation(shaderProgram.ID, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        int projectionLoc = glGetUniformLocation(shaderProgram.ID, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        if (Engine::DEBUG_MODE && currentFrame - lastSchedulerReport >= Engine::Core::NANOSECONDS_PER_SECOND) {
+            lastSchedulerReport = currentFrame;
+            printf("simulation: %llu steps, %.3fms dropped, last step %.3fms wall, critical path %.3fms: %s\n",
+                (unsigned long long)timestep.totalSteps(), Engine::Core::nanosecondsToMilliseconds(timestep.droppedNanoseconds()),
+                simulation.lastFrame().wallMs, simulation.lastFrame().criticalPathMs, simulation.criticalPathString().c_str());
+            pacer.printStats();
+            gpuProfiler.printStats();
+#ifdef ENGINE_GL_TRACE
+            Engine::Renderer::glTracePrintStats();
+#endif
+        }
 
-        glBindVertexArray(VAO);
-        for(unsigned int i = 0; i < 10; i++)
+        if (shouldRender) {
+            /* Render here */
+            PROFILE_SCOPE("render");
+            gpuProfiler.collect();
+#ifdef ENGINE_GL_TRACE
+            Engine::Renderer::glTraceBeginFrame();
+#endif
+            // the overlay shows the previous frame's numbers, this frame's aren't known yet
+            overlay.update(input, Engine::Core::nanosecondsToMilliseconds(timestep.frameNanoseconds()), renderStats, frameAllocations);
+            renderStats.reset();
+            gpuProfiler.beginFrame();
+#ifdef ENGINE_PROFILING
+            // GPU scopes arrive FRAME_LATENCY frames late, each resolved frame goes into the trace once
+            if (gpuProfiler.getResolvedFrame() != tracedGpuFrame) {
+                tracedGpuFrame = gpuProfiler.getResolvedFrame();
+                for (const Engine::Renderer::GpuScopeEvent& event : gpuProfiler.getResolvedEvents()) {
+                    PROFILE_SPAN("GPU", event.name, event.startNanoseconds, event.endNanoseconds);
+                }
+            }
+#endif
+            uint32_t frameScope = gpuProfiler.beginScope("frame");
+            {
+                GPU_PROFILE_SCOPE(gpuProfiler, "clear");
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            }
+
+            shaderProgram.Use();
+        
+            glBindTexture(GL_TEXTURE_2D, texture);
+            renderStats.stateChanges += 2;
+
+            glm::mat4 view;
+            view = camera.GetViewMatrix();
+
+            // the render target's own size, headless runs go up to 1920x1080
+            float aspect = (float)window.getWidth() / (float)std::max(window.getHeight(), 1);
+            glm::mat4 projection;
+            projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+
+            shaderProgram.setMat4At(viewLoc, view);
+            shaderProgram.setMat4At(projectionLoc, projection);
+
+            {
+                GPU_PROFILE_SCOPE(gpuProfiler, "cubes");
+                glBindVertexArray(VAO);
+                renderStats.stateChanges++;
+                for (const glm::mat4& model : cubeMatrices) {
+                    shaderProgram.setMat4At(modelLoc, model);
+
+                    glDrawArrays(GL_TRIANGLES, 0, 36);
+                    renderStats.drawCalls++;
+                    renderStats.triangles += 12;
+                    if (benchmark) {
+                        bench.countDraw(12);
+                    }
+                }
+            }
+            if (overlay.isVisible()) {
+                GPU_PROFILE_SCOPE(gpuProfiler, "overlay");
+                // headless has no scaling, the render target is the window
+                int windowWidth = window.getWidth(), windowHeight = window.getHeight();
+                int framebufferWidth = windowWidth, framebufferHeight = windowHeight;
+                if (window.handle()) {
+                    glfwGetWindowSize(window.handle(), &windowWidth, &windowHeight);
+                    glfwGetFramebufferSize(window.handle(), &framebufferWidth, &framebufferHeight);
+                }
+                overlay.render(windowWidth, windowHeight, framebufferWidth, framebufferHeight);
+            }
+            gpuProfiler.endScope(frameScope);
+            gpuProfiler.endFrame();
+#ifdef ENGINE_GL_TRACE
+            // the swap waits on purpose, it stays outside the frame's sync point check
+            Engine::Renderer::glTraceEndFrame();
+#endif
+
+            /* Swap front and back buffers */
+            PROFILE_SCOPE("swap");
+            window.swapBuffers();
+        }
+        if (benchmark) {
+            bench.endFrame();
+            if (bench.isFinished()) {
+                window.requestClose();
+            }
+        }
+        scriptReload.apply(pacer.remainingNanoseconds());
+        luaGC.collect(pacer.remainingNanoseconds());
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i; 
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            shaderProgram.setMat4("model", model);
+            PROFILE_SCOPE("pacing");
+            pacer.endFrame();
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            /* Poll for and process events, blocks while the window is unfocused or iconified */
+            shouldRender = pacer.pollEvents();
         }
-        /* Swap front and back buffers */
-        glfwSwapBuffers(window);
 
-        /* Poll for and process events */
-        glfwPollEvents();
+        frameAllocations = Engine::Memory::heapAllocationCount() - allocationsAtFrameStart;
+        // the steady state budget is zero heap allocations, past the warmup frames any
+        // allocation fails the run
+        if (checkAllocations && frameCount >= allocationCheckWarmup && frameAllocations > 0) {
+            fprintf(stderr, "frame %llu made %llu heap allocations, steady state frames must make none\n",
+                (unsigned long long)frameCount, (unsigned long long)frameAllocations);
+            exitCode = 1;
+            window.requestClose();
+        }
+        Engine::Memory::memoryTrackerEndFrame();
+        lua.endFrame();
+        luaPool.endFrame();
+        coroutines.endFrame();
+        luaGC.endFrame();
+        scriptReload.endFrame();
+        luaProfiler.endFrame();
+        PROFILE_COUNTER("heap allocations", frameAllocations);
+        PROFILE_COUNTER("simulation steps", steps);
+        PROFILE_COUNTER("frame ms", Engine::Core::nanosecondsToMilliseconds(timestep.frameNanoseconds()));
+        PROFILE_FRAME();
+#ifdef ENGINE_PROFILING
+        // the first frame carries all the startup work, idle frames are slow on purpose
+        flightRecorder.endFrame(frameCount > 0 && !pacer.isIdle());
+#endif
+
+        frameCount++;
+        if (maxFrames && frameCount >= maxFrames) {
+            window.requestClose();
+        }
     }
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteTextures(1, &texture);
+    Engine::Memory::trackFree(Engine::Memory::MemoryTag::GpuBuffers, sizeof(vertices));
+    Engine::Memory::trackFree(Engine::Memory::MemoryTag::GpuTextures, textureBytes);
+
+    if (luaProfile) {
+        luaProfiler.printReport(stdout);
+    }
+    // a capture ending on the last frame is still being written
+    Engine::Profiler::finishCaptures();
+
+    if (benchmark && frameCount > 0 && !bench.finish(window.getWidth(), window.getHeight())) {
+        exitCode = 1;
+    }
 
-    glfwTerminate();
-    return 0;
+    nuklear.shutdown();
+    gpuProfiler.shutdown();
+    window.destroy();
+    return exitCode;
 }
 
 bool Engine::getDebugMode() {
@@ -0,0 +1,188 @@
+// compares two bench mode JSON reports and flags metrics that got worse than the baseline.
+// usage: bench_compare <baseline.json> <current.json> [-threshold 0.05] [-min-delta 0.05]
+// exits with 1 when any metric regressed or is missing from the current report, 2 when a
+// report can't be read
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <stdio.h>
+
+// just enough JSON for the reports bench mode writes: objects, strings and numbers,
+// flattened into "metrics.cpu_ms.p95" style keys
+class FlatJsonReader {
+public:
+    explicit FlatJsonReader(const std::string& text) : text(text), position(0) {}
+
+    bool parse(std::map<std::string, double>& values) {
+        skipSpace();
+        return parseValue("", values);
+    }
+
+private:
+    const std::string& text;
+    size_t position;
+
+    void skipSpace() {
+        while (position < text.size() && isspace((unsigned char)text[position])) {
+            position++;
+        }
+    }
+
+    bool parseString(std::string& out) {
+        if (position >= text.size() || text[position] != '"') {
+            return false;
+        }
+        position++;
+        out.clear();
+        while (position < text.size() && text[position] != '"') {
+            if (text[position] == '\\' && position + 1 < text.size()) {
+                position++;
+            }
+            out += text[position++];
+        }
+        if (position >= text.size()) {
+            return false;
+        }
+        position++;
+        return true;
+    }
+
+    bool parseValue(const std::string& key, std::map<std::string, double>& values) {
+        skipSpace();
+        if (position >= text.size()) {
+            return false;
+        }
+        if (text[position] == '{') {
+            position++;
+            skipSpace();
+            if (position < text.size() && text[position] == '}') {
+                position++;
+                return true;
+            }
+            while (true) {
+                skipSpace();
+                std::string name;
+                if (!parseString(name)) {
+                    return false;
+                }
+                skipSpace();
+                if (position >= text.size() || text[position] != ':') {
+                    return false;
+                }
+                position++;
+                if (!parseValue(key.empty() ? name : key + "." + name, values)) {
+                    return false;
+                }
+                skipSpace();
+                if (position < text.size() && text[position] == ',') {
+                    position++;
+                    continue;
+                }
+                if (position < text.size() && text[position] == '}') {
+                    position++;
+                    return true;
+                }
+                return false;
+            }
+        }
+        if (text[position] == '"') {
+            std::string ignored;
+            return parseString(ignored);
+        }
+        const char* start = text.c_str() + position;
+        char* end = nullptr;
+        double value = strtod(start, &end);
+        if (end == start) {
+            return false;
+        }
+        position += (size_t)(end - start);
+        values[key] = value;
+        return true;
+    }
+};
+
+static bool loadReport(const char* path, std::map<std::string, double>& values) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "failed to open %s\n", path);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    FlatJsonReader reader(text);
+    if (!reader.parse(values)) {
+        fprintf(stderr, "failed to parse %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <baseline.json> <current.json> [-threshold 0.05] [-min-delta 0.05]\n", argv[0]);
+        return 2;
+    }
+    // relative growth that counts as a regression, and an absolute floor so sub-noise
+    // changes on tiny values don't trip it
+    double threshold = 0.05;
+    double minDelta = 0.05;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        }
+        if (strcmp(argv[i], "-min-delta") == 0 && i + 1 < argc) {
+            minDelta = atof(argv[++i]);
+        }
+    }
+
+    std::map<std::string, double> baseline, current;
+    if (!loadReport(argv[1], baseline) || !loadReport(argv[2], current)) {
+        return 2;
+    }
+    if (baseline["width"] != current["width"] || baseline["height"] != current["height"]) {
+        printf("warning: resolution differs (%gx%g baseline, %gx%g current)\n",
+            baseline["width"], baseline["height"], current["width"], current["height"]);
+    }
+
+    int regressions = 0;
+    printf("%-28s %12s %12s %9s\n", "metric", "baseline", "current", "change");
+    for (const auto& entry : baseline) {
+        if (entry.first.compare(0, 8, "metrics.") != 0) {
+            continue;
+        }
+        auto found = current.find(entry.first);
+        // a metric that stopped being reported can't be checked, which must not pass silently
+        if (found == current.end()) {
+            printf("%-28s %12.4f %12s %9s  REGRESSION\n", entry.first.c_str() + 8, entry.second, "missing", "");
+            regressions++;
+            continue;
+        }
+        double before = entry.second;
+        double after = found->second;
+        double change = before != 0.0 ? (after - before) / before : 0.0;
+        // nothing to scale against for a zero baseline (heap allocations per frame), any growth
+        // beyond the noise floor is a regression
+        bool regressed = after - before > minDelta && (before == 0.0 || change > threshold);
+        if (regressed) {
+            regressions++;
+        }
+        if (before == 0.0 && after != 0.0) {
+            printf("%-28s %12.4f %12.4f %9s%s\n", entry.first.c_str() + 8, before, after, "from 0", regressed ? "  REGRESSION" : "");
+            continue;
+        }
+        printf("%-28s %12.4f %12.4f %+8.1f%%%s\n", entry.first.c_str() + 8, before, after, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    if (regressions) {
+        printf("%d metric(s) regressed by more than %.1f%%, grew from zero or are missing\n", regressions, threshold * 100.0);
+        return 1;
+    }
+    printf("no regressions\n");
+    return 0;
+}
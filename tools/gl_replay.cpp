@@ -0,0 +1,428 @@
+// replays a binary GL trace written with -gl-trace on a headless context, so driver cost can be
+// measured without the engine's own CPU work in between.
+// usage: gl_replay <trace.bin> [-size 1280x720] [-loops 10] [-warmup 1]
+// setup calls run once, then every captured frame is submitted `loops` times. calls made
+// between two frames belong to the frame after them, they set state it draws with. each frame is
+// finished before the next one starts, reported are submit time (CPU in the driver) and
+// submit + finish (the frame's full cost)
+
+#include "engine/renderer/gl_trace_format.hpp"
+#include "engine/renderer/headless_context.hpp"
+#include "engine/core/clock.hpp"
+
+#include "GL/glew.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <stdio.h>
+
+using Engine::Renderer::GLFunction;
+
+struct Record {
+    GLFunction function;
+    uint16_t argCount;
+    const uint64_t* args;
+    uint32_t payloadBytes;
+    const unsigned char* payload;
+};
+
+struct Trace {
+    std::vector<unsigned char> data;
+    std::vector<Record> records;
+    size_t setupEnd = 0;                                    // records before the first frame
+    std::vector<std::pair<size_t, size_t>> frames;          // [begin, end) record ranges
+    size_t betweenFrames = 0;                               // records folded into the next frame
+};
+
+static bool loadTrace(const char* path, Trace& trace) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "failed to open %s\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    trace.data.resize(size > 0 ? (size_t)size : 0);
+    size_t read = fread(trace.data.data(), 1, trace.data.size(), file);
+    fclose(file);
+
+    Engine::Renderer::GLTraceHeader header;
+    if (read != trace.data.size() || read < sizeof(header)) {
+        fprintf(stderr, "%s: truncated trace\n", path);
+        return false;
+    }
+    memcpy(&header, trace.data.data(), sizeof(header));
+    if (memcmp(header.magic, Engine::Renderer::GL_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != Engine::Renderer::GL_TRACE_VERSION || header.functionCount != Engine::Renderer::GL_FUNCTION_COUNT) {
+        fprintf(stderr, "%s: not a trace this build can read\n", path);
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    size_t frameBegin = 0;
+    size_t lastFrameEnd = 0;
+    bool inFrame = false;
+    bool sawFrame = false;
+    while (offset + sizeof(Engine::Renderer::GLTraceRecord) <= trace.data.size()) {
+        Engine::Renderer::GLTraceRecord recordHeader;
+        memcpy(&recordHeader, trace.data.data() + offset, sizeof(recordHeader));
+        offset += sizeof(recordHeader);
+        size_t argBytes = recordHeader.argCount * sizeof(uint64_t);
+        size_t payloadBytes = (size_t)Engine::Renderer::glTracePaddedSize(recordHeader.payloadBytes);
+        if (offset + argBytes + payloadBytes > trace.data.size()) {
+            fprintf(stderr, "%s: truncated record, stopping there\n", path);
+            break;
+        }
+        GLFunction function = (GLFunction)recordHeader.function;
+        if (function == GLFunction::FrameBegin) {
+            if (!sawFrame) {
+                trace.setupEnd = trace.records.size();
+                frameBegin = trace.records.size();
+                sawFrame = true;
+            } else {
+                frameBegin = lastFrameEnd;
+                trace.betweenFrames += trace.records.size() - lastFrameEnd;
+            }
+            inFrame = true;
+        } else if (function == GLFunction::FrameEnd) {
+            if (inFrame) {
+                trace.frames.push_back(std::make_pair(frameBegin, trace.records.size()));
+            }
+            lastFrameEnd = trace.records.size();
+            inFrame = false;
+        } else {
+            // headers are 8 bytes and payloads are padded, so the args are always 8 byte aligned
+            trace.records.push_back(Record{function, recordHeader.argCount,
+                reinterpret_cast<const uint64_t*>(trace.data.data() + offset), recordHeader.payloadBytes,
+                trace.data.data() + offset + argBytes});
+        }
+        offset += argBytes + payloadBytes;
+    }
+    if (!sawFrame) {
+        trace.setupEnd = trace.records.size();
+    }
+    return true;
+}
+
+// executes records against the current context, object names and uniform locations from the
+// capture are translated to the ones this context hands out. objects created before the capture
+// started (a headless run's offscreen framebuffer, made by window.create) have no translation:
+// framebuffers among them are this tool's target, anything else is replaced by name 0 rather
+// than aliasing whatever this context happens to call by the same number
+class Replayer {
+public:
+    explicit Replayer(GLuint targetFramebuffer) : targetFramebuffer(targetFramebuffer), currentProgram(0), unseenNames(0) {}
+
+    uint32_t unseenNameCount() const { return unseenNames; }
+
+    void execute(const Record& record) {
+        const Record& r = record;
+        switch (r.function) {
+            case GLFunction::ActiveTexture: glActiveTexture(e(r, 0)); break;
+            case GLFunction::AttachShader: glAttachShader(name(programs, r, 0), name(programs, r, 1)); break;
+            case GLFunction::BeginQuery: glBeginQuery(e(r, 0), name(queries, r, 1)); break;
+            case GLFunction::BindBuffer: glBindBuffer(e(r, 0), name(buffers, r, 1)); break;
+            case GLFunction::BindFramebuffer:
+                // the engine's default framebuffer is this tool's offscreen target, and so is the
+                // headless one it renders into instead
+                glBindFramebuffer(e(r, 0), framebuffers.count((GLuint)r.args[1]) ? name(framebuffers, r, 1) : targetFramebuffer);
+                break;
+            case GLFunction::BindRenderbuffer: glBindRenderbuffer(e(r, 0), name(renderbuffers, r, 1)); break;
+            case GLFunction::BindTexture: glBindTexture(e(r, 0), name(textures, r, 1)); break;
+            case GLFunction::BindVertexArray: glBindVertexArray(name(vertexArrays, r, 0)); break;
+            case GLFunction::BlendEquation: glBlendEquation(e(r, 0)); break;
+            case GLFunction::BlendFunc: glBlendFunc(e(r, 0), e(r, 1)); break;
+            case GLFunction::BufferData:
+                glBufferData(e(r, 0), (GLsizeiptr)(int64_t)r.args[1], r.args[3] ? r.payload : nullptr, e(r, 2));
+                break;
+            case GLFunction::CheckFramebufferStatus: glCheckFramebufferStatus(e(r, 0)); break;
+            case GLFunction::Clear: glClear((GLbitfield)r.args[0]); break;
+            case GLFunction::CompileShader: glCompileShader(name(programs, r, 0)); break;
+            case GLFunction::CreateProgram: programs[(GLuint)r.args[0]] = glCreateProgram(); break;
+            case GLFunction::CreateShader: programs[(GLuint)r.args[1]] = glCreateShader(e(r, 0)); break;
+            case GLFunction::DeleteBuffers: remove(buffers, r, [](GLsizei n, const GLuint* names) { glDeleteBuffers(n, names); }); break;
+            case GLFunction::DeleteFramebuffers: remove(framebuffers, r, [](GLsizei n, const GLuint* names) { glDeleteFramebuffers(n, names); }); break;
+            case GLFunction::DeleteQueries: remove(queries, r, [](GLsizei n, const GLuint* names) { glDeleteQueries(n, names); }); break;
+            case GLFunction::DeleteRenderbuffers: remove(renderbuffers, r, [](GLsizei n, const GLuint* names) { glDeleteRenderbuffers(n, names); }); break;
+            case GLFunction::DeleteShader: glDeleteShader(name(programs, r, 0)); break;
+            case GLFunction::DeleteTextures: remove(textures, r, [](GLsizei n, const GLuint* names) { glDeleteTextures(n, names); }); break;
+            case GLFunction::DeleteVertexArrays: remove(vertexArrays, r, [](GLsizei n, const GLuint* names) { glDeleteVertexArrays(n, names); }); break;
+            case GLFunction::Disable: glDisable(e(r, 0)); break;
+            case GLFunction::DrawArrays: glDrawArrays(e(r, 0), i(r, 1), i(r, 2)); break;
+            case GLFunction::DrawElements: glDrawElements(e(r, 0), i(r, 1), e(r, 2), (const void*)(uintptr_t)r.args[3]); break;
+            case GLFunction::Enable: glEnable(e(r, 0)); break;
+            case GLFunction::EnableVertexAttribArray: glEnableVertexAttribArray(e(r, 0)); break;
+            case GLFunction::EndQuery: glEndQuery(e(r, 0)); break;
+            case GLFunction::Finish: glFinish(); break;
+            case GLFunction::FramebufferRenderbuffer:
+                glFramebufferRenderbuffer(e(r, 0), e(r, 1), e(r, 2), name(renderbuffers, r, 3));
+                break;
+            case GLFunction::GenBuffers: generate(buffers, r, [](GLsizei n, GLuint* names) { glGenBuffers(n, names); }); break;
+            case GLFunction::GenFramebuffers: generate(framebuffers, r, [](GLsizei n, GLuint* names) { glGenFramebuffers(n, names); }); break;
+            case GLFunction::GenQueries: generate(queries, r, [](GLsizei n, GLuint* names) { glGenQueries(n, names); }); break;
+            case GLFunction::GenRenderbuffers: generate(renderbuffers, r, [](GLsizei n, GLuint* names) { glGenRenderbuffers(n, names); }); break;
+            case GLFunction::GenTextures: generate(textures, r, [](GLsizei n, GLuint* names) { glGenTextures(n, names); }); break;
+            case GLFunction::GenVertexArrays: generate(vertexArrays, r, [](GLsizei n, GLuint* names) { glGenVertexArrays(n, names); }); break;
+            case GLFunction::GenerateMipmap: glGenerateMipmap(e(r, 0)); break;
+            case GLFunction::GetFloatv: glGetFloatv(e(r, 0), reinterpret_cast<GLfloat*>(scratchBuffer(64))); break;
+            case GLFunction::GetInteger64v: glGetInteger64v(e(r, 0), reinterpret_cast<GLint64*>(scratchBuffer(64))); break;
+            case GLFunction::GetIntegerv: glGetIntegerv(e(r, 0), reinterpret_cast<GLint*>(scratchBuffer(64))); break;
+            case GLFunction::GetProgramInfoLog:
+                glGetProgramInfoLog(name(programs, r, 0), i(r, 1), nullptr, reinterpret_cast<GLchar*>(scratchBuffer((size_t)i(r, 1))));
+                break;
+            case GLFunction::GetProgramiv: glGetProgramiv(name(programs, r, 0), e(r, 1), reinterpret_cast<GLint*>(scratchBuffer(16))); break;
+            case GLFunction::GetQueryObjectui64v:
+                glGetQueryObjectui64v(name(queries, r, 0), e(r, 1), reinterpret_cast<GLuint64*>(scratchBuffer(16)));
+                break;
+            case GLFunction::GetShaderInfoLog:
+                glGetShaderInfoLog(name(programs, r, 0), i(r, 1), nullptr, reinterpret_cast<GLchar*>(scratchBuffer((size_t)i(r, 1))));
+                break;
+            case GLFunction::GetShaderiv: glGetShaderiv(name(programs, r, 0), e(r, 1), reinterpret_cast<GLint*>(scratchBuffer(16))); break;
+            case GLFunction::GetString: glGetString(e(r, 0)); break;
+            case GLFunction::GetUniformLocation: {
+                GLuint program = name(programs, r, 0);
+                GLint location = glGetUniformLocation(program, reinterpret_cast<const GLchar*>(r.payload));
+                locations[locationKey(program, i(r, 1))] = location;
+                break;
+            }
+            case GLFunction::LinkProgram: glLinkProgram(name(programs, r, 0)); break;
+            case GLFunction::MapBufferRange:
+                mapped[e(r, 0)] = glMapBufferRange(e(r, 0), (GLintptr)(int64_t)r.args[1], (GLsizeiptr)(int64_t)r.args[2], (GLbitfield)r.args[3]);
+                break;
+            case GLFunction::QueryCounter: glQueryCounter(name(queries, r, 0), e(r, 1)); break;
+            case GLFunction::ReadPixels:
+                glReadPixels(i(r, 0), i(r, 1), i(r, 2), i(r, 3), e(r, 4), e(r, 5), scratchBuffer((size_t)i(r, 2) * (size_t)i(r, 3) * 16));
+                break;
+            case GLFunction::RenderbufferStorage: glRenderbufferStorage(e(r, 0), e(r, 1), i(r, 2), i(r, 3)); break;
+            case GLFunction::Scissor: glScissor(i(r, 0), i(r, 1), i(r, 2), i(r, 3)); break;
+            case GLFunction::ShaderSource: {
+                const GLchar* source = reinterpret_cast<const GLchar*>(r.payload);
+                GLint length = (GLint)r.payloadBytes;
+                glShaderSource(name(programs, r, 0), 1, &source, &length);
+                break;
+            }
+            case GLFunction::TexImage2D:
+                glTexImage2D(e(r, 0), i(r, 1), i(r, 2), i(r, 3), i(r, 4), i(r, 5), e(r, 6), e(r, 7), r.args[8] ? r.payload : nullptr);
+                break;
+            case GLFunction::TexParameteri: glTexParameteri(e(r, 0), e(r, 1), i(r, 2)); break;
+            case GLFunction::Uniform1f: {
+                uint32_t bits = (uint32_t)r.args[1];
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                glUniform1f(location(i(r, 0)), value);
+                break;
+            }
+            case GLFunction::Uniform1i: glUniform1i(location(i(r, 0)), i(r, 1)); break;
+            case GLFunction::UniformMatrix4fv:
+                glUniformMatrix4fv(location(i(r, 0)), i(r, 1), (GLboolean)r.args[2], reinterpret_cast<const GLfloat*>(r.payload));
+                break;
+            case GLFunction::UnmapBuffer: {
+                auto found = mapped.find(e(r, 0));
+                if (found != mapped.end() && found->second && r.payloadBytes) {
+                    memcpy(found->second, r.payload, r.payloadBytes);
+                }
+                mapped.erase(e(r, 0));
+                glUnmapBuffer(e(r, 0));
+                break;
+            }
+            case GLFunction::UseProgram:
+                currentProgram = name(programs, r, 0);
+                glUseProgram(currentProgram);
+                break;
+            case GLFunction::VertexAttribPointer:
+                glVertexAttribPointer(e(r, 0), i(r, 1), e(r, 2), (GLboolean)r.args[3], i(r, 4), (const void*)(uintptr_t)r.args[5]);
+                break;
+            case GLFunction::Viewport: glViewport(i(r, 0), i(r, 1), i(r, 2), i(r, 3)); break;
+            default: break;
+        }
+    }
+
+private:
+    typedef std::unordered_map<GLuint, GLuint> NameMap;
+
+    GLuint targetFramebuffer;
+    NameMap buffers, textures, vertexArrays, queries, framebuffers, renderbuffers;
+    NameMap programs;                               // shaders and programs share one namespace
+    std::unordered_map<uint64_t, GLint> locations;  // (program, captured location) -> location
+    std::map<GLenum, void*> mapped;
+    std::vector<unsigned char> scratch;
+    GLuint currentProgram;
+    uint32_t unseenNames;                           // references to objects the trace never created
+
+    static GLenum e(const Record& r, int index) { return (GLenum)r.args[index]; }
+    static GLint i(const Record& r, int index) { return (GLint)(int64_t)r.args[index]; }
+
+    GLuint name(const NameMap& names, const Record& r, int index) {
+        GLuint captured = (GLuint)r.args[index];
+        auto found = names.find(captured);
+        if (found != names.end()) {
+            return found->second;
+        }
+        if (captured != 0) {
+            unseenNames++;
+        }
+        return 0;
+    }
+
+    static uint64_t locationKey(GLuint program, GLint location) {
+        return ((uint64_t)program << 32) | (uint32_t)location;
+    }
+
+    GLint location(GLint captured) {
+        auto found = locations.find(locationKey(currentProgram, captured));
+        return found != locations.end() ? found->second : captured;
+    }
+
+    void* scratchBuffer(size_t size) {
+        if (scratch.size() < size) {
+            scratch.resize(size);
+        }
+        return scratch.data();
+    }
+
+    template<typename Fn>
+    void generate(NameMap& names, const Record& r, Fn gen) {
+        GLsizei n = i(r, 0);
+        std::vector<GLuint> fresh((size_t)n);
+        gen(n, fresh.data());
+        const GLuint* captured = reinterpret_cast<const GLuint*>(r.payload);
+        for (GLsizei k = 0; k < n; k++) {
+            names[captured[k]] = fresh[(size_t)k];
+        }
+    }
+
+    template<typename Fn>
+    void remove(NameMap& names, const Record& r, Fn del) {
+        GLsizei n = i(r, 0);
+        std::vector<GLuint> translated((size_t)n);
+        const GLuint* captured = reinterpret_cast<const GLuint*>(r.payload);
+        for (GLsizei k = 0; k < n; k++) {
+            auto found = names.find(captured[k]);
+            translated[(size_t)k] = found != names.end() ? found->second : 0;
+            names.erase(captured[k]);
+        }
+        del(n, translated.data());
+    }
+};
+
+static void printTimes(const char* label, std::vector<double>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    size_t p95 = (size_t)((double)(samples.size() - 1) * 0.95);
+    printf("%-16s avg %8.3fms  p50 %8.3fms  p95 %8.3fms  max %8.3fms\n", label, sum / (double)samples.size(),
+        samples[samples.size() / 2], samples[p95], samples.back());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace.bin> [-size 1280x720] [-loops 10] [-warmup 1]\n", argv[0]);
+        return 2;
+    }
+    int width = 1280, height = 720;
+    int loops = 10;
+    int warmupLoops = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                fprintf(stderr, "invalid size %s, expected WIDTHxHEIGHT\n", argv[i]);
+                return 2;
+            }
+        }
+        if (strcmp(argv[i], "-loops") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        }
+        if (strcmp(argv[i], "-warmup") == 0 && i + 1 < argc) {
+            warmupLoops = atoi(argv[++i]);
+        }
+    }
+
+    Trace trace;
+    if (!loadTrace(argv[1], trace)) {
+        return 2;
+    }
+    if (trace.frames.empty()) {
+        fprintf(stderr, "%s: trace has no complete frames\n", argv[1]);
+        return 2;
+    }
+    size_t frameCalls = 0;
+    for (const auto& frame : trace.frames) {
+        frameCalls += frame.second - frame.first;
+    }
+    printf("%s: %zu setup calls, %zu frames, %.1f calls per frame (%zu made between frames)\n", argv[1], trace.setupEnd,
+        trace.frames.size(), (double)frameCalls / (double)trace.frames.size(), trace.betweenFrames);
+
+    Engine::Renderer::HeadlessContext context;
+    if (!context.create(3, 3)) {
+        return 2;
+    }
+    GLenum err = glewInit();
+    if (GLEW_OK != err) {
+        fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+    }
+
+    GLuint colorBuffer, depthBuffer, framebuffer;
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "framebuffer incomplete\n");
+        return 2;
+    }
+    glViewport(0, 0, width, height);
+
+    Replayer replayer(framebuffer);
+    for (size_t i = 0; i < trace.setupEnd; i++) {
+        replayer.execute(trace.records[i]);
+    }
+    glFinish();
+
+    std::vector<double> submitMs, frameMs;
+    for (int loop = 0; loop < warmupLoops + loops; loop++) {
+        for (const auto& frame : trace.frames) {
+            uint64_t start = Engine::Core::nowNanoseconds();
+            for (size_t i = frame.first; i < frame.second; i++) {
+                replayer.execute(trace.records[i]);
+            }
+            uint64_t submitted = Engine::Core::nowNanoseconds();
+            glFinish();
+            uint64_t finished = Engine::Core::nowNanoseconds();
+            if (loop >= warmupLoops) {
+                submitMs.push_back(Engine::Core::nanosecondsToMilliseconds(submitted - start));
+                frameMs.push_back(Engine::Core::nanosecondsToMilliseconds(finished - start));
+            }
+        }
+    }
+
+    printf("replayed %zu frames at %dx%d\n", submitMs.size(), width, height);
+    if (replayer.unseenNameCount() > 0) {
+        printf("%u replayed calls named objects created before the capture started, they were dropped\n",
+            replayer.unseenNameCount());
+    }
+    printTimes("submit", submitMs);
+    printTimes("submit + finish", frameMs);
+
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    context.destroy();
+    return 0;
+}
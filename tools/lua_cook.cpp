@@ -0,0 +1,38 @@
+// compiles every .lua file below a script directory to LuaJIT bytecode for the engine's script
+// loader, files whose source hash still matches their cooked version are skipped.
+// usage: lua_cook <script dir> <cooked dir> [-strip]
+// exits with 1 when any script failed to compile or write
+
+#include "engine/lua_embed/lua_bytecode.hpp"
+
+#include "lua.hpp"
+
+#include <cstring>
+#include <stdio.h>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <script dir> <cooked dir> [-strip]\n", argv[0]);
+        return 2;
+    }
+    bool strip = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-strip") == 0) {
+            strip = true;
+        }
+    }
+
+    // compiling needs the parser only, no libraries
+    lua_State* L = luaL_newstate();
+    if (!L) {
+        fprintf(stderr, "failed to create lua state\n");
+        return 2;
+    }
+    lua_pushcfunction(L, luaopen_string);
+    lua_call(L, 0, 0);
+    Engine::LuaCookStats stats = Engine::cookLuaDirectory(L, argv[1], argv[2], strip);
+    lua_close(L);
+
+    printf("lua_cook: %u cooked, %u up to date, %u failed\n", stats.cooked, stats.upToDate, stats.failed);
+    return stats.failed > 0 ? 1 : 0;
+}